@@ -1,5 +1,8 @@
 #include "cell/cell.hpp"
+#include "cell/dictionary.hpp"
+#include "cell/hash.hpp"
 #include <algorithm>
+#include <cstring>
 
 namespace memdb {
     #define UCHAR_TO_HEX(c) (((c) < (unsigned char)0xA) ? (char)((char)'0' + (char)(c)) : (char)((char)'A' + (char)(c) - (char)10))
@@ -23,6 +26,11 @@ namespace memdb {
             {CellType::BYTES, "Bytes"}
         };
 
+    const std::string& type_name(CellType type)
+    {
+        return type_to_str.at(type);
+    }
+
     Cell::Cell(Int32 value) : 
         value_(value), size_(4)
     { }
@@ -38,10 +46,13 @@ namespace memdb {
         if (size_ > MAX_STRING_DATA)
             throw MaxLengthExceededException();
 
-        String a{0}; // initialize with zeros
-        std::copy_n(value.begin(), size_, &a[0]);
+    #ifdef CACHE_STRINGS
+        String a{}; // initialize with zeros
+        std::copy_n(value.begin(), size_, a.begin());
         value_ = std::move(a);
-
+    #else
+        value_ = String(value);
+    #endif
     }
 
     Cell::Cell(const std::vector<std::byte>& value)
@@ -50,11 +61,19 @@ namespace memdb {
         if (size_ > MAX_STRING_DATA)
             throw MaxLengthExceededException();
 
-        Bytes a{std::byte(0)}; // Initialize with zeros
-        std::copy_n(value.begin(), size_, &a[0]);
+    #ifdef CACHE_STRINGS
+        Bytes a{}; // Initialize with zeros
+        std::copy_n(value.begin(), size_, a.begin());
         value_ = std::move(a);
+    #else
+        value_ = Bytes(value);
+    #endif
     }
 
+    Cell::Cell(const DictionaryEntry* entry) :
+        value_(Symbol{entry}), size_(entry->value_.size())
+    { }
+
     CellType Cell::get_type() const
     {
         if (is_int())
@@ -68,29 +87,70 @@ namespace memdb {
 
     bool Cell::less(const Cell& other) const
     {
-        if (get_type() != other.get_type())
+        if (value_.index() != other.value_.index() && get_type() != other.get_type())
             throw TypeException();
 
-        return this->value_ < other.value_;
-
+        return compare(other) < 0;
     }
 
-    size_t Cell::hash() const
+    // Lexicographic order of two buffers, shorter first on a common prefix
+    static int compare_bytes(const void* lhs, size_t lhs_size, const void* rhs, size_t rhs_size)
     {
-        CellType type = get_type();
+        int res = std::memcmp(lhs, rhs, std::min(lhs_size, rhs_size));
+        if (res != 0)
+            return (res > 0) - (res < 0);
+        return (lhs_size > rhs_size) - (lhs_size < rhs_size);
+    }
 
-        switch (type)
+    int Cell::compare(const Cell& other) const
+    {
+        // same alternative: one branch to the typed comparison
+        if (value_.index() == other.value_.index())
         {
-        case CellType::INT32: return std::hash<int>{}(get_int());
-        case CellType::BOOL : return std::hash<bool>{}(get_bool());
-        case CellType::STRING: return std::hash<std::string>{}(get_string());
-        default:
-            auto bytes = get_bytes();
-            std::string str = "";
-            for (std::byte b : bytes)
-                str += (char)b;
-            return std::hash<std::string>{}(str);
+            if (auto lhs = std::get_if<Int32>(&value_)) {
+                Int32 rhs = std::get<Int32>(other.value_);
+                return (*lhs > rhs) - (*lhs < rhs);
+            }
+            if (auto lhs = std::get_if<Bool>(&value_))
+                return (int)*lhs - (int)std::get<Bool>(other.value_);
+            if (auto lhs = std::get_if<Bytes>(&value_))
+                return compare_bytes(lhs->data(), size_, std::get<Bytes>(other.value_).data(), other.size_);
+            if (entry() && entry() == other.entry())
+                return 0;
         }
+
+        CellType type = get_type();
+        CellType other_type = other.get_type();
+        if (type != other_type)
+            return type < other_type ? -1 : 1;
+
+        // strings, stored in the cell or in a dictionary
+        std::string_view lhs = text(), rhs = other.text();
+        return compare_bytes(lhs.data(), lhs.size(), rhs.data(), rhs.size());
+    }
+
+    bool Cell::equals(const Cell& other) const
+    {
+        // entries of one dictionary hold distinct values
+        const DictionaryEntry* lhs = entry();
+        const DictionaryEntry* rhs = other.entry();
+        if (lhs && rhs && lhs->dictionary_ == rhs->dictionary_)
+            return lhs == rhs;
+
+        return compare(other) == 0;
+    }
+
+    size_t Cell::hash() const
+    {
+        if (auto value = std::get_if<Int32>(&value_))
+            return hash_int(uint32_t(*value));
+        if (auto value = std::get_if<Bool>(&value_))
+            return hash_int(uint64_t(1) << 32 | *value);     // not equal to any Int32
+        if (auto value = std::get_if<String>(&value_))
+            return hash_bytes(value->data(), size_);
+        if (auto value = std::get_if<Bytes>(&value_))
+            return hash_bytes(value->data(), size_);
+        return std::get<Symbol>(value_).entry_->hash_;
     }
 
     bool Cell::is_int() const 
@@ -105,7 +165,7 @@ namespace memdb {
 
     bool Cell::is_string() const 
     {
-        return std::holds_alternative<String>(value_);
+        return std::holds_alternative<String>(value_) || std::holds_alternative<Symbol>(value_);
     }
 
     bool Cell::is_bytes() const 
@@ -134,8 +194,27 @@ namespace memdb {
     {
         if (!this->is_string())
             throw TypeException();
-        String ret = std::get<String>(value_);
-        return std::string(ret.begin(), ret.begin() + size_);
+        return std::string(text());
+    }
+
+    std::string_view Cell::text() const
+    {
+        if (auto symbol = std::get_if<Symbol>(&value_))
+            return symbol->entry_->value_;
+        return std::string_view(std::get<String>(value_).data(), size_);
+    }
+
+    std::string_view Cell::data() const
+    {
+        if (auto bytes = std::get_if<Bytes>(&value_))
+            return std::string_view(reinterpret_cast<const char*>(bytes->data()), size_);
+        return text();
+    }
+
+    const DictionaryEntry* Cell::entry() const
+    {
+        auto symbol = std::get_if<Symbol>(&value_);
+        return symbol ? symbol->entry_ : nullptr;
     }
 
 
@@ -143,7 +222,7 @@ namespace memdb {
     {
         if (!this->is_bytes())
             throw TypeException();
-        Bytes ret = std::get<Bytes>(value_);
+        const Bytes& ret = std::get<Bytes>(value_);
         return std::vector<std::byte>(ret.begin(), ret.begin() + size_);
     }
 
@@ -151,32 +230,32 @@ namespace memdb {
     // Comparison operators
     Cell Cell::operator== (const Cell& other) const
     {
-        return Cell(this->value_ == other.value_);
+        return Cell(equals(other));
     }
 
     Cell Cell::operator!= (const Cell& other) const
     {
-        return Cell(this->value_ != other.value_);
+        return Cell(!equals(other));
     }
 
     Cell Cell::operator>= (const Cell& other) const
     {
-        return Cell(this->value_ >= other.value_);
+        return Cell(compare(other) >= 0);
     }
 
     Cell Cell::operator<= (const Cell& other) const
     {
-        return Cell(this->value_ <= other.value_);
+        return Cell(compare(other) <= 0);
     }
 
     Cell Cell::operator< (const Cell& other) const
     {
-        return Cell(this->value_ < other.value_);
+        return Cell(compare(other) < 0);
     }
 
     Cell Cell::operator> (const Cell& other) const
     {
-        return Cell(this->value_ > other.value_);
+        return Cell(compare(other) > 0);
     }
 
     // Arithmetical operators (For Int32)
@@ -242,9 +321,6 @@ namespace memdb {
         if (type2 != CellType::INT32)
             throw IncompatibleTypeOperatorException("*", type_to_str.at(type2));
 
-        if (!other.get_int())
-            throw DivisionByZeroException();
-
         return Cell(get_int() * other.get_int());
     }
 
@@ -253,15 +329,15 @@ namespace memdb {
         CellType type1 = get_type();
         CellType type2 = other.get_type();
 
-        if (type1 != CellType::INT32 || type1 != CellType::STRING)
-            throw IncompatibleTypeOperatorException("*", type_to_str.at(type1));
-        if (type2 != CellType::INT32 || type2 != CellType::STRING)
-            throw IncompatibleTypeOperatorException("*", type_to_str.at(type2));
+        if (type1 != CellType::INT32 && type1 != CellType::STRING)
+            throw IncompatibleTypeOperatorException("+", type_to_str.at(type1));
+        if (type2 != CellType::INT32 && type2 != CellType::STRING)
+            throw IncompatibleTypeOperatorException("+", type_to_str.at(type2));
         if (type1 != type2)
             throw DifferentTypesException("+");
 
         if (type1 == CellType::INT32)
-            return Cell(get_int() * other.get_int());
+            return Cell(get_int() + other.get_int());
 
         return Cell(get_string() + other.get_string());
     }
@@ -402,6 +478,11 @@ namespace memdb {
         return Cell(bt1);
     }
 
+    Cell clipped_int(uint64_t value)
+    {
+        return Cell(static_cast<Int32>(std::min<uint64_t>(value, INT32_MAX)));
+    }
+
     std::string Cell::ToString() const
     {
         CellType type = get_type();
@@ -8,6 +8,7 @@
 #include <memory>
 #include <vector>
 #include <array>
+#include <string_view>
 #include <unordered_map>
 #include <stdint.h>
 
@@ -22,7 +23,9 @@ namespace memdb
     using Int32     = int32_t;
     using Bool      = bool;
 
-    #define CACHE_STRINGS
+    // Keep strings in fixed buffers inside the cell instead of the heap.
+    // Every cell then takes MAX_STRING_DATA bytes, whatever its type
+    // #define CACHE_STRINGS
     #ifdef  CACHE_STRINGS
         using String    = typename std::array<char, MAX_STRING_DATA>;
         using Bytes     = typename std::array<std::byte, MAX_STRING_DATA>;
@@ -31,6 +34,14 @@ namespace memdb
         using Bytes     = typename std::vector<std::byte>;
     #endif // CACHE_STRINGS
 
+    struct DictionaryEntry;
+
+    // String stored once in the dictionary of its column
+    struct Symbol
+    {
+        const DictionaryEntry* entry_;
+    };
+
     // Flags for types of data stored in one table column
     enum CellType {
         INT32,
@@ -39,6 +50,9 @@ namespace memdb
         BYTES
     };
 
+    // Name of the type in error messages
+    const std::string& type_name(CellType type);
+
     class Cell
     {
     public:
@@ -48,6 +62,9 @@ namespace memdb
         Cell(const std::string& value);
         Cell(const std::vector<std::byte>& value);
 
+        // String value of a column dictionary, see Dictionary
+        explicit Cell(const DictionaryEntry* entry);
+
         Cell(const Cell& other) = default;
         Cell(Cell&& other) = default;
 
@@ -62,7 +79,15 @@ namespace memdb
         CellType get_type() const;
         std::string display() const;
 
-        bool less(const Cell& other) const;
+        // Comparisons for sorting, indexes and filters, with no Cell built
+        // for the result. Cells of different types are ordered by type,
+        // strings and bytes by memcmp over their length
+        int compare(const Cell& other) const;
+        bool equals(const Cell& other) const;
+        bool less(const Cell& other) const;     // TypeException for different types
+
+        // Hash of the value, computed in place without allocating.
+        // Equal strings hash alike whether or not they are in a dictionary
         size_t hash() const;
 
         Int32           get_int() const;
@@ -70,6 +95,17 @@ namespace memdb
         std::string     get_string() const;
         std::vector<std::byte>   get_bytes() const;
 
+        // Values of cells known to hold the type, not checked
+        Int32           int_value() const   { return *std::get_if<Int32>(&value_); }
+        Bool            bool_value() const  { return *std::get_if<Bool>(&value_); }
+
+        // Characters of a string cell or bytes of a bytes cell, not copied
+        // and not checked. Valid while the cell and its dictionary live
+        std::string_view data() const;
+
+        // Dictionary entry of the string, nullptr if it is stored in the cell
+        const DictionaryEntry*   entry() const;
+
         // Comparison operators
         Cell operator== (const Cell& other) const;
         Cell operator!= (const Cell& other) const;
@@ -101,12 +137,18 @@ namespace memdb
         
 
     private:
-        std::variant<Int32, Bool, String, Bytes>
+        // Characters of a string cell
+        std::string_view text() const;
+
+        std::variant<Int32, Bool, String, Bytes, Symbol>
             value_;
 
         size_t size_;
     };
 
+    // INT32 cell of a count for tables of statistics, INT32_MAX if it does not fit
+    Cell clipped_int(uint64_t value);
+
     // Lexicographical comparison of two cells
     struct CellCompare {
         bool operator() (const Cell& lhs, const Cell& rhs) const {
@@ -114,6 +156,12 @@ namespace memdb
         }
     };
 
+    struct CellEqual {
+        bool operator() (const Cell& lhs, const Cell& rhs) const {
+            return lhs.equals(rhs);
+        }
+    };
+
     struct CellHash {
         size_t operator() (const Cell& lhs) const {
             return lhs.hash();
@@ -0,0 +1,72 @@
+#include "cell/dictionary.hpp"
+#include "cell/hash.hpp"
+
+#include <mutex>
+
+namespace memdb
+{
+    Cell Dictionary::encode(const Cell& cell)
+    {
+        if (cell.get_type() != CellType::STRING)
+            return cell;
+        if (cell.entry() && cell.entry()->dictionary_ == this)
+            return cell;
+
+        // looked up in place, the characters are copied only into a new entry
+        // or into the plain cell returned once the dictionary is full
+        std::string_view value = cell.data();
+        auto plain = [&] { return cell.entry() ? Cell(std::string(value)) : cell; };
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            auto it = codes_.find(value);
+            if (it != codes_.end())
+                return Cell(it->second);
+            if (entries_.size() >= DICTIONARY_CAPACITY)
+                return plain();
+        }
+
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto it = codes_.find(value);
+        if (it != codes_.end())
+            return Cell(it->second);
+        if (entries_.size() >= DICTIONARY_CAPACITY)
+            return plain();
+
+        size_t hash = hash_bytes(value.data(), value.size());
+        uint32_t code = entries_.size();
+        entries_.push_back(std::make_unique<DictionaryEntry>(DictionaryEntry{std::string(value), hash, code, this}));
+
+        const DictionaryEntry* entry = entries_.back().get();
+        codes_.emplace(entry->value_, entry);
+        return Cell(entry);
+    }
+
+    Cell Dictionary::find(const Cell& cell) const
+    {
+        if (cell.get_type() != CellType::STRING)
+            return cell;
+        if (cell.entry() && cell.entry()->dictionary_ == this)
+            return cell;
+
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = codes_.find(cell.data());
+        return it != codes_.end() ? Cell(it->second) : cell;
+    }
+
+    size_t Dictionary::size() const
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return entries_.size();
+    }
+
+    size_t Dictionary::bytes() const
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        size_t bytes = entries_.capacity() * sizeof(entries_[0])
+            + codes_.bucket_count() * sizeof(void*);
+        for (auto& entry : entries_)
+            bytes += sizeof(DictionaryEntry) + entry->value_.capacity()
+                + sizeof(std::pair<std::string_view, const DictionaryEntry*>) + sizeof(void*);
+        return bytes;
+    }
+} // namespace memdb
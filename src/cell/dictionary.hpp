@@ -0,0 +1,72 @@
+#ifndef HEADER_GUARD_CELL_DICTIONARY_H
+#define HEADER_GUARD_CELL_DICTIONARY_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <shared_mutex>
+#include <atomic>
+#include <cstdint>
+
+#include "cell/cell.hpp"
+
+// Distinct values a column dictionary takes before new values are stored plain
+#define DICTIONARY_CAPACITY 4096U
+
+namespace memdb
+{
+    class Dictionary;
+
+    // Value of a dictionary, shared by all cells holding it
+    struct DictionaryEntry
+    {
+        std::string         value_;
+        size_t              hash_;      // hash of value_, the same as of a plain string cell
+        uint32_t            code_;
+        const Dictionary*   dictionary_;
+    };
+
+    /*
+        Dictionary of distinct values of one STRING column.
+
+        Cells of the column hold a pointer to their entry instead of the
+        string. Cells of one dictionary are equal exactly when the entries
+        are, so equality and hashing never look at the characters.
+
+        Entries are never removed or moved, so cells stay valid while any
+        table with the column (it holds the dictionary) exists. Values are
+        added by the writers of the table and looked up by readers
+        preparing a query, both under the dictionary's own lock.
+    */
+    class Dictionary
+    {
+    public:
+        Dictionary() = default;
+
+        Dictionary(const Dictionary& other)               = delete;
+        Dictionary& operator= (const Dictionary& other)   = delete;
+
+        // Cell of the dictionary equal to cell, which is added if there is room.
+        // Cells of other types and values that do not fit are returned as they are
+        Cell encode(const Cell& cell);
+
+        // Cell of the dictionary equal to cell if the value is already in it
+        Cell find(const Cell& cell) const;
+
+        size_t size() const;
+
+        // Memory taken by the entries and their lookup, an estimate
+        size_t bytes() const;
+
+    private:
+        mutable std::shared_mutex                   mutex_;
+        std::vector<std::unique_ptr<DictionaryEntry>>
+                                                    entries_;
+        std::unordered_map<std::string_view, const DictionaryEntry*>
+                                                    codes_;     // keys point into entries_
+    };
+} // namespace memdb
+
+#endif // HEADER_GUARD_CELL_DICTIONARY_H
@@ -0,0 +1,78 @@
+#include "cell/hash.hpp"
+
+#include <cstring>
+
+namespace memdb
+{
+    static const uint64_t secret[4] = {
+        0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL, 0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL
+    };
+
+    static inline uint64_t read64(const uint8_t* p)
+    {
+        uint64_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    static inline uint64_t read32(const uint8_t* p)
+    {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    uint64_t hash_bytes(const void* data, size_t size)
+    {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        uint64_t seed = hash_mix(secret[0], secret[1]);
+        uint64_t a, b;
+
+        if (size <= 16)
+        {
+            // short keys are read as up to four overlapping words
+            if (size >= 4) {
+                size_t middle = (size >> 3) << 2;
+                a = (read32(p) << 32) | read32(p + middle);
+                b = (read32(p + size - 4) << 32) | read32(p + size - 4 - middle);
+            }
+            else if (size > 0) {
+                a = (uint64_t(p[0]) << 16) | (uint64_t(p[size >> 1]) << 8) | p[size - 1];
+                b = 0;
+            }
+            else
+                a = b = 0;
+        }
+        else
+        {
+            size_t left = size;
+            if (left > 48)
+            {
+                uint64_t seed1 = seed, seed2 = seed;
+                do {
+                    seed  = hash_mix(read64(p) ^ secret[1], read64(p + 8) ^ seed);
+                    seed1 = hash_mix(read64(p + 16) ^ secret[2], read64(p + 24) ^ seed1);
+                    seed2 = hash_mix(read64(p + 32) ^ secret[3], read64(p + 40) ^ seed2);
+                    p += 48;
+                    left -= 48;
+                } while (left > 48);
+                seed ^= seed1 ^ seed2;
+            }
+
+            while (left > 16) {
+                seed = hash_mix(read64(p) ^ secret[1], read64(p + 8) ^ seed);
+                p += 16;
+                left -= 16;
+            }
+
+            // the last 16 bytes, overlapping what was already mixed
+            a = read64(p + left - 16);
+            b = read64(p + left - 8);
+        }
+
+        __uint128_t product = (__uint128_t)(a ^ secret[1]) * (b ^ seed);
+        a = (uint64_t)product;
+        b = (uint64_t)(product >> 64);
+        return hash_mix(a ^ secret[0] ^ size, b ^ secret[1]);
+    }
+} // namespace memdb
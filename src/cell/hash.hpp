@@ -0,0 +1,27 @@
+#ifndef HEADER_GUARD_CELL_HASH_H
+#define HEADER_GUARD_CELL_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace memdb
+{
+    // Multiply to 128 bits and fold the halves, the mixing step of wyhash
+    inline uint64_t hash_mix(uint64_t a, uint64_t b)
+    {
+        __uint128_t product = (__uint128_t)a * b;
+        return (uint64_t)product ^ (uint64_t)(product >> 64);
+    }
+
+    // Hash of a 64-bit value
+    inline uint64_t hash_int(uint64_t value)
+    {
+        return hash_mix(value ^ 0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL);
+    }
+
+    // Hash of size bytes at data, wyhash style: reads the buffer in place,
+    // 48 bytes per round, and never allocates
+    uint64_t hash_bytes(const void* data, size_t size);
+} // namespace memdb
+
+#endif // HEADER_GUARD_CELL_HASH_H
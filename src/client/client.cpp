@@ -0,0 +1,264 @@
+#include "client/client.hpp"
+#include "server/protocol.hpp"
+#include "storage/codec.hpp"
+
+#include <cerrno>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace memdb
+{
+    // Bytes read from the socket at a time
+    static const size_t read_size = 64 * 1024;
+
+    static std::string errno_string()
+    {
+        return std::string(strerror(errno));
+    }
+
+    std::string_view ResultSet::data(size_t column, size_t row) const
+    {
+        const ColumnData& data = columns_[column];
+        return std::string_view(data.data_).substr(data.offsets_[row],
+            data.offsets_[row + 1] - data.offsets_[row]);
+    }
+
+    Cell ResultSet::cell(size_t column, size_t row) const
+    {
+        switch (type(column))
+        {
+        case CellType::INT32:   return Cell(int_value(column, row));
+        case CellType::BOOL:    return Cell(bool_value(column, row));
+        case CellType::STRING:  return Cell(std::string(data(column, row)));
+        default:
+        {
+            std::string_view bytes = data(column, row);
+            auto begin = reinterpret_cast<const std::byte*>(bytes.data());
+            return Cell(std::vector<std::byte>(begin, begin + bytes.size()));
+        }
+        }
+    }
+
+    Client::Client(const std::string& host, uint16_t port)
+    {
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1)
+            throw ClientException("invalid address " + host);
+
+        fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd_ < 0)
+            throw ClientException("cannot create socket: " + errno_string());
+
+        if (connect(fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+            std::string reason = errno_string();
+            ::close(fd_);
+            throw ClientException("cannot connect to " + host + ":" + std::to_string(port) + ": " + reason);
+        }
+
+        int one = 1;
+        setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+
+    Client::~Client()
+    {
+        ::close(fd_);
+    }
+
+    size_t Client::begin_request(uint8_t type)
+    {
+        size_t start = output_.size();
+        output_.append(sizeof(uint32_t), '\0');
+        output_.push_back(char(type));
+        return start;
+    }
+
+    void Client::end_request(size_t start)
+    {
+        uint32_t length = output_.size() - start - sizeof(uint32_t);
+        for (auto i = 0LU; i < sizeof(uint32_t); ++i)
+            output_[start + i] = char(length >> (8 * i));
+    }
+
+    void Client::send_query(const std::string& text)
+    {
+        size_t start = begin_request(QueryMessage);
+        output_.append(text);
+        end_request(start);
+    }
+
+    void Client::send_execute(uint32_t statement, const std::vector<Cell>& parameters)
+    {
+        size_t start = begin_request(ExecuteMessage);
+        Encoder out(output_);
+        out.put<uint32_t>(statement);
+        out.put_cells(parameters);
+        end_request(start);
+    }
+
+    void Client::flush()
+    {
+        size_t sent = 0;
+        while (sent < output_.size())
+        {
+            ssize_t res = send(fd_, output_.data() + sent, output_.size() - sent, MSG_NOSIGNAL);
+            if (res < 0 && errno == EINTR)
+                continue;
+            if (res < 0)
+                throw ClientException("send failed: " + errno_string());
+            sent += res;
+        }
+        output_.clear();
+    }
+
+    std::string_view Client::read_frame()
+    {
+        // bytes of earlier frames are dropped once a new one is needed
+        input_.erase(input_.begin(), input_.begin() + consumed_);
+        consumed_ = 0;
+
+        auto fill = [this] (size_t size) {
+            while (input_.size() < size)
+            {
+                size_t old_size = input_.size();
+                input_.resize(old_size + std::max(read_size, size - old_size));
+
+                ssize_t res = recv(fd_, input_.data() + old_size, input_.size() - old_size, 0);
+                input_.resize(old_size + std::max<ssize_t>(res, 0));
+
+                if (res < 0 && errno == EINTR)
+                    continue;
+                if (res < 0)
+                    throw ClientException("receive failed: " + errno_string());
+                if (res == 0)
+                    throw ClientException("connection closed by the server");
+            }
+        };
+
+        fill(sizeof(uint32_t));
+        auto bytes = reinterpret_cast<const unsigned char*>(input_.data());
+        uint32_t length = uint32_t(bytes[0]) | uint32_t(bytes[1]) << 8
+            | uint32_t(bytes[2]) << 16 | uint32_t(bytes[3]) << 24;
+
+        fill(sizeof(uint32_t) + length);
+        consumed_ = sizeof(uint32_t) + length;
+        return std::string_view(input_.data() + sizeof(uint32_t), length);
+    }
+
+    // Status of a response, the error message in error if it failed
+    static ResponseStatus read_status(Decoder& in, std::string& error)
+    {
+        auto status = ResponseStatus(in.get<uint8_t>());
+        if (status != ResponseOk)
+            error = in.get_string();
+        return status;
+    }
+
+    ResultSet Client::receive()
+    {
+        std::string_view frame = read_frame();
+        Decoder in(frame.data(), frame.size());
+
+        ResultSet res;
+        ResponseStatus status = read_status(in, res.error_);
+        res.ok_ = status == ResponseOk;
+        res.retryable_ = status == ResponseRetry;
+        if (!res.ok_)
+            return res;
+
+        res.columns_.resize(in.get<uint16_t>());
+        for (auto& column : res.columns_) {
+            column.type_ = CellType(in.get<uint8_t>());
+            uint16_t length = in.get<uint16_t>();
+            column.name_.assign(in.get_data(length), length);
+            column.offsets_.push_back(0);
+        }
+
+        // batches are appended column by column
+        while (uint32_t rows = in.get<uint32_t>())
+        {
+            for (auto& column : res.columns_)
+            {
+                switch (column.type_)
+                {
+                case CellType::INT32:
+                {
+                    size_t size = column.ints_.size();
+                    column.ints_.resize(size + rows);
+                    std::memcpy(column.ints_.data() + size, in.get_data(rows * sizeof(Int32)), rows * sizeof(Int32));
+                    break;
+                }
+                case CellType::BOOL:
+                {
+                    auto data = reinterpret_cast<const uint8_t*>(in.get_data(rows));
+                    column.bools_.insert(column.bools_.end(), data, data + rows);
+                    break;
+                }
+                default:
+                {
+                    // offsets of the batch start at 0, values go after the earlier ones
+                    uint32_t base = column.data_.size();
+                    in.get<uint32_t>();
+                    for (auto r = 0U; r < rows; ++r)
+                        column.offsets_.push_back(base + in.get<uint32_t>());
+                    uint32_t length = column.offsets_.back() - base;
+                    column.data_.append(in.get_data(length), length);
+                    break;
+                }
+                }
+            }
+            res.rows_ += rows;
+        }
+
+        return res;
+    }
+
+    ResultSet Client::query(const std::string& text)
+    {
+        send_query(text);
+        flush();
+        return receive();
+    }
+
+    ResultSet Client::execute(uint32_t statement, const std::vector<Cell>& parameters)
+    {
+        send_execute(statement, parameters);
+        flush();
+        return receive();
+    }
+
+    uint32_t Client::prepare(const std::string& text)
+    {
+        size_t start = begin_request(PrepareMessage);
+        output_.append(text);
+        end_request(start);
+        flush();
+
+        std::string_view frame = read_frame();
+        Decoder in(frame.data(), frame.size());
+        std::string error;
+        if (read_status(in, error) != ResponseOk)
+            throw ClientException(error);
+        return in.get<uint32_t>();
+    }
+
+    void Client::close(uint32_t statement)
+    {
+        size_t start = begin_request(CloseMessage);
+        Encoder(output_).put<uint32_t>(statement);
+        end_request(start);
+        flush();
+
+        std::string_view frame = read_frame();
+        Decoder in(frame.data(), frame.size());
+        std::string error;
+        if (read_status(in, error) != ResponseOk)
+            throw ClientException(error);
+    }
+} // namespace memdb
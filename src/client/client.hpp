@@ -0,0 +1,116 @@
+#ifndef HEADER_GUARD_CLIENT_CLIENT_H
+#define HEADER_GUARD_CLIENT_CLIENT_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "cell/cell.hpp"
+
+namespace memdb
+{
+    /*
+        Result of a query run by memdb-server, kept in the columnar layout
+        it arrives in: the values of an INT32 or BOOL column in one array,
+        the values of a STRING or BYTES column back to back with their end
+        offsets. Reading a value costs an index, nothing is parsed.
+    */
+    class ResultSet
+    {
+    public:
+        bool ok() const                     { return ok_; }
+        const std::string& error() const    { return error_; }
+
+        // Not run because the server was overloaded, the same request may be sent again
+        bool retryable() const              { return retryable_; }
+
+        size_t width() const                { return columns_.size(); }     // number of columns
+        size_t size() const                 { return rows_; }               // number of rows
+
+        const std::string& name(size_t column) const    { return columns_[column].name_; }
+        CellType type(size_t column) const              { return columns_[column].type_; }
+
+        // Values of a column of the type, not checked
+        Int32 int_value(size_t column, size_t row) const    { return columns_[column].ints_[row]; }
+        Bool bool_value(size_t column, size_t row) const    { return columns_[column].bools_[row]; }
+        std::string_view data(size_t column, size_t row) const;    // STRING and BYTES
+
+        // Value of any column as a cell, copied
+        Cell cell(size_t column, size_t row) const;
+
+    private:
+        friend class Client;
+
+        struct ColumnData
+        {
+            std::string             name_;
+            CellType                type_;
+            std::vector<Int32>      ints_;
+            std::vector<uint8_t>    bools_;
+            std::vector<uint32_t>   offsets_;   // end of every value in data_, after a leading 0
+            std::string             data_;
+        };
+
+        bool                    ok_ = true;
+        bool                    retryable_ = false;
+        std::string             error_;
+        size_t                  rows_ = 0;
+        std::vector<ColumnData> columns_;
+    };
+
+    /*
+        Connection to memdb-server, see protocol.hpp.
+
+        query, prepare, execute and close wait for their response. For
+        pipelining, send_query and send_execute only queue the request;
+        flush() sends everything queued at once and receive() reads the
+        responses in the order of the requests. Errors of statements come
+        back in the ResultSet, so do rejections of an overloaded server
+        (see ResultSet::retryable). ClientException is thrown when the
+        server cannot be reached or the connection breaks.
+
+        A client is used by one thread at a time.
+    */
+    class Client
+    {
+    public:
+        Client(const std::string& host, uint16_t port);
+        ~Client();
+
+        Client(const Client& other)             = delete;
+        Client& operator= (const Client& other) = delete;
+
+        ResultSet query(const std::string& text);
+
+        // Handle of the statement, ClientException with the parse error if it is invalid
+        uint32_t prepare(const std::string& text);
+
+        ResultSet execute(uint32_t statement, const std::vector<Cell>& parameters);
+
+        // Release a prepared statement, ClientException if there is none
+        void close(uint32_t statement);
+
+        void send_query(const std::string& text);
+        void send_execute(uint32_t statement, const std::vector<Cell>& parameters);
+        void flush();
+
+        // Response to the oldest QUERY or EXECUTE sent and not received yet
+        ResultSet receive();
+
+    private:
+        // Start a request of type in the queue, finished by end_request
+        size_t begin_request(uint8_t type);
+        void end_request(size_t start);
+
+        // Next response message, valid until the next call
+        std::string_view read_frame();
+
+        int                 fd_;
+        std::string         output_;        // requests not sent yet
+        std::vector<char>   input_;         // bytes received
+        size_t              consumed_ = 0;  // bytes of input_ already read out
+    };
+} // namespace memdb
+
+#endif // HEADER_GUARD_CLIENT_CLIENT_H
@@ -1,26 +1,194 @@
 #include "command/command.hpp"
 #include "database/database.hpp"
+#include "database/session.hpp"
+#include "database/scan_stats.hpp"
 #include <utility>
+#include <chrono>
 
 namespace memdb 
 {
 
-    Result Command::execute(Database* database)
+    // Result rows counted in the metrics: owned result sets only, the
+    // borrowed table of an INSERT is not returned rows
+    static size_t returned_rows(const Result& res)
     {
+        return res.ok() && res.get_table() && !res.shared_table() ? res.get_table()->size() : 0;
+    }
+
+    template <typename F>
+    Result Command::run(Session* session, F f)
+    {
+        ScanStats stats;
+        auto start = std::chrono::steady_clock::now();
+        Result res(nullptr);
         try
         {
-            return root_->execute(database);
+            ScanStats::Scope scope(stats);
+            res = f();
         }
         catch (std::exception& ex)
         {
-            return Result(ex.what());
+            res = Result(ex.what());
+        }
+
+        uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        size_t returned = returned_rows(res);
+
+        Database& database = session->database();
+        database.metrics().executed(type_, ns, res.ok(), stats.rows_read_, returned);
+
+        // the plan is only built for statements that were slow
+        SlowLog& slow_log = database.slow_log();
+        if (slow_log.slow(parse_ns_ + ns)) {
+            SlowQuery query;
+            query.time_ = std::chrono::system_clock::now();
+            query.query_ = query_ ? normalize_query(*query_) : "";
+            query.parse_ns_ = parse_ns_;
+            query.execute_ns_ = ns;
+            query.rows_scanned_ = stats.rows_read_;
+            query.rows_skipped_ = stats.skipped_zone_ + stats.skipped_sealed_;
+            query.rows_returned_ = returned;
+            query.plan_ = normalize_query(plan_summary(root_->plan()));
+            query.ok_ = res.ok();
+            slow_log.record(std::move(query));
         }
+        return res;
     }
 
-    Command::Command(CommandNodePointer root)
-    : root_(root)
+    Result Command::execute(Session* session)
+    {
+        return run(session, [&] { return root_->execute(session); });
+    }
+
+    Command::Command(CommandNodePointer root, CommandType type)
+    : root_(root), type_(type)
     { }
 
+    Command Command::bind(const std::vector<Cell>& values) const
+    {
+        CommandNodePointer root = root_->bind(values);
+        Command bound = root ? Command(root, type_) : *this;
+        bound.set_source(query_, 0);
+        return bound;
+    }
+
+    void Command::set_source(std::shared_ptr<const std::string> query, uint64_t parse_ns)
+    {
+        query_ = std::move(query);
+        parse_ns_ = parse_ns;
+    }
+
+    size_t Command::estimate(Session* session) const
+    {
+        return root_ ? root_->estimate(session) : 0;
+    }
+
+    PlanNode Command::plan() const
+    {
+        return root_->plan();
+    }
+
+    Result Command::analyze(Session* session)
+    {
+        return run(session, [&] {
+            auto plan = std::make_shared<PlanNode>(root_->plan());
+            Result res = root_->analyze(session, *plan);
+            res.set_plan(std::move(plan));
+            return res;
+        });
+    }
+
+    CommandNodePointer SQLCommand::bind(const std::vector<Cell>& values) const
+    {
+        (void)values;
+        return nullptr;
+    }
+
+    size_t SQLCommand::estimate(Session* session) const
+    {
+        (void)session;
+        return 0;
+    }
+
+    PlanNode SQLCommand::plan() const
+    {
+        return PlanNode("Statement");
+    }
+
+    static uint64_t elapsed_ns(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    }
+
+    Result SQLCommand::analyze(Session* session, PlanNode& plan)
+    {
+        plan = this->plan();
+
+        auto start = std::chrono::steady_clock::now();
+        Result res = execute(session);
+        plan.time_ns_ = elapsed_ns(start);
+
+        plan.rows_out_ = returned_rows(res);
+        return res;
+    }
+
+    // Scan of the table, with the condition it filters rows by
+    static PlanNode scan_plan(const std::string& name, const Expression& where)
+    {
+        PlanNode scan("Scan", name);
+        std::string condition = where.text();
+        if (!condition.empty())
+            scan.detail_ += " filter " + condition;
+        return scan;
+    }
+
+    // Counters of a Scan operator from the stats of its statement
+    static void set_scan(PlanNode& scan, const ScanStats& stats)
+    {
+        scan.rows_skipped_ = stats.skipped_zone_ + stats.skipped_sealed_;
+        scan.rows_in_ = stats.rows_read_ + scan.rows_skipped_;
+        scan.rows_out_ = stats.rows_matched_;
+        scan.time_ns_ = stats.scan_ns_;
+    }
+
+    // UPDATE and DELETE: the operator on top gets the time the scan did
+    // not take, and the memory for the matched rows
+    static Result analyze_write(SQLCommand& command, Session* session, PlanNode& plan)
+    {
+        plan = command.plan();
+
+        ScanStats stats;
+        auto start = std::chrono::steady_clock::now();
+        Result res(nullptr);
+        {
+            ScanStats::Scope scope(stats);
+            res = command.execute(session);
+        }
+        uint64_t total = elapsed_ns(start);
+
+        set_scan(plan.children_.front(), stats);
+        plan.rows_in_ = stats.rows_matched_;
+        plan.rows_out_ = stats.rows_matched_;
+        plan.time_ns_ = total - std::min(total, stats.scan_ns_);
+        plan.bytes_ = stats.bytes_;
+        return res;
+    }
+
+    // Slots a scan of the table reads, 0 for an unknown table: running the
+    // command reports that
+    static size_t scan_estimate(Session* session, const std::string& name, const Expression& where)
+    {
+        try {
+            return session->database().get_table(name)->scan_estimate(where);
+        }
+        catch (DatabaseException&)
+        {
+            return 0;
+        }
+    }
+
 
     //
     // GetTable
@@ -34,13 +202,12 @@ namespace memdb
         name_(name)
     { }
 
-    Result GetTable::execute(Database* database)
+    Result GetTable::execute(Session* session)
     {
-        Table* table;
+        Database* database = &session->database();
 
         try {
-            table = database->get_table(name_);
-            return Result(table);
+            return Result(database->get_table(name_));
         }
         catch (DatabaseException& ex)
         {
@@ -48,6 +215,11 @@ namespace memdb
         }
     }
 
+    PlanNode GetTable::plan() const
+    {
+        return PlanNode("Scan", name_);
+    }
+
     //
     // Create Table
     //
@@ -60,12 +232,17 @@ namespace memdb
         name_(name), columns_(columns)
     { }
 
-    Result SQLCreateTable::execute(Database* database)
+    Result SQLCreateTable::execute(Session* session)
     {
+        Database* database = &session->database();
+
         try
         {
-            Table* table = new Table(name_, columns_);
-            database->add_table(table);
+            if (session->transaction())
+                throw StatementInTransactionException("CREATE TABLE");
+
+            uint64_t lsn = database->add_table(new Table(name_, columns_));
+            database->commit(lsn);
             return Result(database->get_table(name_));
         }
         catch (DatabaseException& ex)
@@ -78,20 +255,40 @@ namespace memdb
     // Insert
     //
 
-    SQLInsertOrdered::SQLInsertOrdered(const std::string& name, const std::vector<Cell>& data) :
-        name_(name), data_(data)
+    SQLInsertOrdered::SQLInsertOrdered(const std::string& name, const std::vector<Cell>& data,
+        const RowParameters& parameters) :
+        name_(name), data_(data), parameters_(parameters)
     { }
 
     SQLInsertOrdered::SQLInsertOrdered(const char*   name, const std::vector<Cell>& data) :
         name_(name), data_(data)
     { }
 
-    Result SQLInsertOrdered::execute(Database* database)
+    Result SQLInsertOrdered::execute(Session* session)
     {
+        Database* database = &session->database();
+
         try
         {
-            Table* table = database->get_table(name_);
-            table->insert(data_);
+            if (!parameters_.empty())
+                throw UnboundParameterException(parameters_.front().second + 1);
+
+            auto table = database->get_table(name_);
+
+            if (Transaction* transaction = session->transaction()) {
+                transaction->insert(table, std::vector<Cell>(data_));
+                return Result(nullptr);
+            }
+
+            uint64_t lsn;
+            {
+                // logged once the row is in, under the same lock, so a failed statement
+                // is never logged and snapshots see either both or neither
+                auto lock = table->write_lock();
+                table->insert(data_);
+                lsn = database->log(WalRecord::insert(name_, data_));
+            }
+            database->commit(lsn);
             return Result(table);
         }
         catch (DatabaseException& ex)
@@ -100,9 +297,29 @@ namespace memdb
         }
     }
 
+    CommandNodePointer SQLInsertOrdered::bind(const std::vector<Cell>& values) const
+    {
+        if (parameters_.empty())
+            return nullptr;
+
+        std::vector<Cell> data = data_;
+        for (auto &[position, index] : parameters_) {
+            if (index >= values.size())
+                throw UnboundParameterException(index + 1);
+            data[position] = values[index];
+        }
+        return std::make_shared<SQLInsertOrdered>(name_, data);
+    }
 
-    SQLInsertUnordered::SQLInsertUnordered(const std::string& name, const std::unordered_map<std::string, Cell>& data) :
-        name_(name), data_(data)
+    PlanNode SQLInsertOrdered::plan() const
+    {
+        return PlanNode("Insert", name_);
+    }
+
+
+    SQLInsertUnordered::SQLInsertUnordered(const std::string& name, const std::unordered_map<std::string, Cell>& data,
+        const NamedRowParameters& parameters) :
+        name_(name), data_(data), parameters_(parameters)
     { }
 
     SQLInsertUnordered::SQLInsertUnordered(const char*   name, const std::unordered_map<std::string, Cell>& data) :
@@ -110,12 +327,29 @@ namespace memdb
     { }
 
 
-    Result SQLInsertUnordered::execute(Database* database)
+    Result SQLInsertUnordered::execute(Session* session)
     {
+        Database* database = &session->database();
+
         try
         {
-            Table* table = database->get_table(name_);
-            table->insert(data_);
+            if (!parameters_.empty())
+                throw UnboundParameterException(parameters_.front().second + 1);
+
+            auto table = database->get_table(name_);
+
+            if (Transaction* transaction = session->transaction()) {
+                transaction->insert(table, data_);
+                return Result(nullptr);
+            }
+
+            uint64_t lsn;
+            {
+                auto lock = table->write_lock();
+                table->insert(data_);
+                lsn = database->log(WalRecord::insert(name_, data_));
+            }
+            database->commit(lsn);
             return Result(table);
         }
         catch (DatabaseException& ex)
@@ -124,6 +358,25 @@ namespace memdb
         }
     }
 
+    CommandNodePointer SQLInsertUnordered::bind(const std::vector<Cell>& values) const
+    {
+        if (parameters_.empty())
+            return nullptr;
+
+        std::unordered_map<std::string, Cell> data = data_;
+        for (auto &[column, index] : parameters_) {
+            if (index >= values.size())
+                throw UnboundParameterException(index + 1);
+            data[column] = values[index];
+        }
+        return std::make_shared<SQLInsertUnordered>(name_, data);
+    }
+
+    PlanNode SQLInsertUnordered::plan() const
+    {
+        return PlanNode("Insert", name_);
+    }
+
 
     SQLSelect::SQLSelect(const std::vector<std::string>& column_names, 
         CommandNodePointer& argument, Expression& where)
@@ -131,16 +384,27 @@ namespace memdb
     { }
 
         // Allocate new table
-    Result SQLSelect::execute(Database* database)
+    Result SQLSelect::execute(Session* session)
     {
-        Result arg = argument_->execute(database);
+        Result arg = argument_->execute(session);
         if (!arg.ok())
             return arg;
+        return select(session, arg);
+    }
+
+    Result SQLSelect::select(Session* session, Result& arg)
+    {
         try
         {
+            // tables of the catalog are read as the open transaction sees them
+            Transaction* transaction = session->transaction();
+            auto pool = session->results();
+            if (transaction && arg.shared_table())
+                return Result(transaction->select(arg.shared_table(), column_names_, where_,
+                    pool.get()), pool);
+
             Table* table = arg.get_table();
-            Table* ret = table->select(column_names_, where_);
-            return Result(ret);
+            return Result(table->select(column_names_, where_, pool.get()), pool);
         }
         catch (DatabaseException& ex)
         {
@@ -148,6 +412,105 @@ namespace memdb
         }
     }
 
+    Result SQLSelect::declare(Session* session, const std::string& name)
+    {
+        Result arg = argument_->execute(session);
+        if (!arg.ok())
+            return arg;
+        try
+        {
+            // results of subqueries are not kept in segments to scan
+            std::shared_ptr<Table> table = arg.shared_table();
+            if (!table)
+                throw CursorException("a cursor selects from a table of the database");
+
+            auto manager = session->database().transactions();
+            std::unique_ptr<Cursor> cursor;
+
+            // inside a transaction the cursor reads the transaction's snapshot,
+            // which its own buffered changes are not part of
+            if (Transaction* transaction = session->transaction()) {
+                if (transaction->changes(table))
+                    throw CursorException("table \"" + table->name() + "\" has changes of the open transaction");
+                cursor = std::make_unique<Cursor>(table, column_names_, where_, manager,
+                    transaction->snapshot_ts());
+            }
+            else {
+                TransactionManager::ReadView view(*manager);
+                cursor = std::make_unique<Cursor>(table, column_names_, where_, manager, view.ts());
+            }
+
+            session->declare(name, std::move(cursor));
+            return Result(nullptr);
+        }
+        catch (DatabaseException& ex)
+        {
+            return Result(ex.what());
+        }
+    }
+
+    CommandNodePointer SQLSelect::bind(const std::vector<Cell>& values) const
+    {
+        CommandNodePointer argument = argument_->bind(values);
+        Expression where = where_.bind_parameters(values);
+        if (!argument)
+            argument = argument_;
+        return std::make_shared<SQLSelect>(column_names_, argument, where);
+    }
+
+    size_t SQLSelect::estimate(Session* session) const
+    {
+        // a subquery is judged by what it reads, its result is no bigger
+        auto source = std::dynamic_pointer_cast<GetTable>(argument_);
+        if (!source)
+            return argument_->estimate(session);
+        return scan_estimate(session, source->name(), where_);
+    }
+
+    PlanNode SQLSelect::plan() const
+    {
+        std::string columns;
+        for (auto& name : column_names_)
+            columns += (columns.empty() ? "" : ", ") + name;
+        PlanNode project("Project", columns);
+
+        // a subquery is scanned as the table it results in
+        auto source = std::dynamic_pointer_cast<GetTable>(argument_);
+        PlanNode scan = scan_plan(source ? source->name() : "subquery", where_);
+        if (!source)
+            scan.children_.push_back(argument_->plan());
+
+        project.children_.push_back(std::move(scan));
+        return project;
+    }
+
+    Result SQLSelect::analyze(Session* session, PlanNode& plan)
+    {
+        plan = this->plan();
+        PlanNode& scan = plan.children_.front();
+
+        Result arg = scan.children_.empty() ? argument_->execute(session)
+            : argument_->analyze(session, scan.children_.front());
+        if (!arg.ok())
+            return arg;
+
+        ScanStats stats;
+        auto start = std::chrono::steady_clock::now();
+        Result res(nullptr);
+        {
+            ScanStats::Scope scope(stats);
+            res = select(session, arg);
+        }
+        uint64_t total = elapsed_ns(start);
+
+        set_scan(scan, stats);
+        scan.bytes_ = stats.bytes_;
+        plan.rows_in_ = stats.rows_matched_;
+        plan.rows_out_ = res.ok() ? res.get_table()->size() : 0;
+        plan.time_ns_ = total - std::min(total, stats.scan_ns_);
+        return res;
+    }
+
 
     SQLUpdate::SQLUpdate(const std::string& name, 
         std::unordered_map<std::string, Expression>& set, 
@@ -155,12 +518,26 @@ namespace memdb
     : name_(name), set_(std::move(set)), where_(std::move(where))
     { }
 
-    Result SQLUpdate::execute(Database* database)
+    Result SQLUpdate::execute(Session* session)
     {
+        Database* database = &session->database();
+
         try
         {
-            Table* table = database->get_table(name_);
-            table->update(set_, where_);
+            auto table = database->get_table(name_);
+
+            if (Transaction* transaction = session->transaction()) {
+                transaction->update(table, set_, where_);
+                return Result(nullptr);
+            }
+
+            uint64_t lsn;
+            {
+                auto lock = table->write_lock();
+                table->update(set_, where_);
+                lsn = database->log(WalRecord::update(name_, set_, where_));
+            }
+            database->commit(lsn);
             return Result(table);
         }
         catch (DatabaseException& ex)
@@ -169,17 +546,57 @@ namespace memdb
         }
     }
 
+    CommandNodePointer SQLUpdate::bind(const std::vector<Cell>& values) const
+    {
+        std::unordered_map<std::string, Expression> set;
+        for (auto &[column, rhs] : set_)
+            set.emplace(column, rhs.bind_parameters(values));
+        Expression where = where_.bind_parameters(values);
+        return std::make_shared<SQLUpdate>(name_, set, where);
+    }
+
+    size_t SQLUpdate::estimate(Session* session) const
+    {
+        return scan_estimate(session, name_, where_);
+    }
+
+    PlanNode SQLUpdate::plan() const
+    {
+        PlanNode update("Update", name_);
+        update.children_.push_back(scan_plan(name_, where_));
+        return update;
+    }
+
+    Result SQLUpdate::analyze(Session* session, PlanNode& plan)
+    {
+        return analyze_write(*this, session, plan);
+    }
+
 
     SQLDelete::SQLDelete(const std::string& name, Expression& where)
     : name_(name), where_(where)
     { }
 
-    Result SQLDelete::execute(Database* database)
+    Result SQLDelete::execute(Session* session)
     {
+        Database* database = &session->database();
+
         try
         {
-            Table* table = database->get_table(name_);
-            table->drop(where_);
+            auto table = database->get_table(name_);
+
+            if (Transaction* transaction = session->transaction()) {
+                transaction->drop(table, where_);
+                return Result(nullptr);
+            }
+
+            uint64_t lsn;
+            {
+                auto lock = table->write_lock();
+                table->drop(where_);
+                lsn = database->log(WalRecord::remove(name_, where_));
+            }
+            database->commit(lsn);
             return Result(table);
         }
         catch (DatabaseException& ex)
@@ -188,5 +605,309 @@ namespace memdb
         }
     }
 
+    CommandNodePointer SQLDelete::bind(const std::vector<Cell>& values) const
+    {
+        Expression where = where_.bind_parameters(values);
+        return std::make_shared<SQLDelete>(name_, where);
+    }
+
+    size_t SQLDelete::estimate(Session* session) const
+    {
+        return scan_estimate(session, name_, where_);
+    }
 
+    PlanNode SQLDelete::plan() const
+    {
+        PlanNode remove("Delete", name_);
+        remove.children_.push_back(scan_plan(name_, where_));
+        return remove;
+    }
+
+    Result SQLDelete::analyze(Session* session, PlanNode& plan)
+    {
+        return analyze_write(*this, session, plan);
+    }
+
+
+    SQLDropTable::SQLDropTable(const std::string& name)
+    : name_(name)
+    { }
+
+    Result SQLDropTable::execute(Session* session)
+    {
+        Database* database = &session->database();
+
+        try
+        {
+            if (session->transaction())
+                throw StatementInTransactionException("DROP TABLE");
+
+            uint64_t lsn = database->drop_table(name_);
+            database->commit(lsn);
+            return Result(nullptr);
+        }
+        catch (DatabaseException& ex)
+        {
+            return Result(ex.what());
+        }
+    }
+
+
+    SQLSave::SQLSave(const std::string& path)
+    : path_(path)
+    { }
+
+    Result SQLSave::execute(Session* session)
+    {
+        Database* database = &session->database();
+
+        try
+        {
+            if (session->transaction())
+                throw StatementInTransactionException("SAVE");
+
+            database->save(path_);
+            return Result(nullptr);
+        }
+        catch (DatabaseException& ex)
+        {
+            return Result(ex.what());
+        }
+    }
+
+
+    SQLLoad::SQLLoad(const std::string& path)
+    : path_(path)
+    { }
+
+    Result SQLLoad::execute(Session* session)
+    {
+        Database* database = &session->database();
+
+        try
+        {
+            if (session->transaction())
+                throw StatementInTransactionException("LOAD");
+
+            database->load(path_);
+            return Result(nullptr);
+        }
+        catch (DatabaseException& ex)
+        {
+            return Result(ex.what());
+        }
+    }
+
+
+    SQLBackgroundSave::SQLBackgroundSave(const std::string& path)
+    : path_(path)
+    { }
+
+    Result SQLBackgroundSave::execute(Session* session)
+    {
+        Database* database = &session->database();
+
+        try
+        {
+            if (session->transaction())
+                throw StatementInTransactionException("BGSAVE");
+
+            database->background_save(path_);
+            return Result(nullptr);
+        }
+        catch (DatabaseException& ex)
+        {
+            return Result(ex.what());
+        }
+    }
+
+
+    Result SQLBackgroundSaveStatus::execute(Session* session)
+    {
+        Database* database = &session->database();
+
+        static const char* state_names[] = {"idle", "running", "done", "failed"};
+
+        try
+        {
+            BackgroundSaveStatus status = database->background_save_status();
+
+            auto pool = session->results();
+            std::unique_ptr<Table> table = pool->acquire({
+                Column(CellType::STRING, "state", 0),
+                Column(CellType::STRING, "path", 0),
+                Column(CellType::INT32, "progress", 0),
+                Column(CellType::INT32, "duration_ms", 0),
+                Column(CellType::INT32, "fork_us", 0),
+                Column(CellType::INT32, "lsn", 0),
+                Column(CellType::STRING, "error", 0)
+            });
+
+            // long values are clipped to fit the cells
+            table->insert(std::vector<Cell>{
+                Cell(std::string(state_names[status.state_])),
+                Cell(status.path_.substr(0, MAX_STRING_DATA)),
+                Cell(static_cast<int>(status.progress_)),
+                Cell(static_cast<int>(std::min<uint64_t>(status.duration_ms_, INT32_MAX))),
+                Cell(static_cast<int>(std::min<uint64_t>(status.fork_us_, INT32_MAX))),
+                Cell(static_cast<int>(std::min<uint64_t>(status.wal_lsn_, INT32_MAX))),
+                Cell(status.error_.substr(0, MAX_STRING_DATA))
+            });
+            return Result(std::move(table), pool);
+        }
+        catch (DatabaseException& ex)
+        {
+            return Result(ex.what());
+        }
+    }
+
+
+    Result SQLBegin::execute(Session* session)
+    {
+        try
+        {
+            session->begin();
+            return Result(nullptr);
+        }
+        catch (DatabaseException& ex)
+        {
+            return Result(ex.what());
+        }
+    }
+
+
+    Result SQLCommit::execute(Session* session)
+    {
+        try
+        {
+            session->commit();
+            return Result(nullptr);
+        }
+        catch (DatabaseException& ex)
+        {
+            return Result(ex.what());
+        }
+    }
+
+
+    Result SQLRollback::execute(Session* session)
+    {
+        try
+        {
+            session->rollback();
+            return Result(nullptr);
+        }
+        catch (DatabaseException& ex)
+        {
+            return Result(ex.what());
+        }
+    }
+
+
+    //
+    // Cursors
+    //
+
+    SQLDeclareCursor::SQLDeclareCursor(const std::string& name, std::shared_ptr<SQLSelect> select)
+    : name_(name), select_(std::move(select))
+    { }
+
+    Result SQLDeclareCursor::execute(Session* session)
+    {
+        return select_->declare(session, name_);
+    }
+
+    CommandNodePointer SQLDeclareCursor::bind(const std::vector<Cell>& values) const
+    {
+        CommandNodePointer select = select_->bind(values);
+        return std::make_shared<SQLDeclareCursor>(name_, std::static_pointer_cast<SQLSelect>(select));
+    }
+
+    PlanNode SQLDeclareCursor::plan() const
+    {
+        PlanNode cursor("Cursor", name_);
+        cursor.children_.push_back(select_->plan());
+        return cursor;
+    }
+
+    SQLFetch::SQLFetch(const std::string& name, size_t count)
+    : name_(name), count_(count)
+    { }
+
+    Result SQLFetch::execute(Session* session)
+    {
+        try
+        {
+            auto pool = session->results();
+            return Result(session->cursor(name_).fetch(count_, pool.get()), pool);
+        }
+        catch (DatabaseException& ex)
+        {
+            return Result(ex.what());
+        }
+    }
+
+    SQLCloseCursor::SQLCloseCursor(const std::string& name)
+    : name_(name)
+    { }
+
+    Result SQLCloseCursor::execute(Session* session)
+    {
+        try
+        {
+            session->close(name_);
+            return Result(nullptr);
+        }
+        catch (DatabaseException& ex)
+        {
+            return Result(ex.what());
+        }
+    }
+
+
+    //
+    // Explain
+    //
+
+    SQLExplain::SQLExplain(CommandNodePointer statement, bool analyze)
+    : statement_(std::move(statement)), analyze_(analyze)
+    { }
+
+    Result SQLExplain::execute(Session* session)
+    {
+        auto plan = std::make_shared<PlanNode>(statement_->plan());
+
+        // the statement takes effect, as it would without EXPLAIN
+        if (analyze_) {
+            Result res = statement_->analyze(session, *plan);
+            if (!res.ok())
+                return res;
+        }
+
+        try
+        {
+            auto pool = session->results();
+            Result res(plan_table(*plan, analyze_, pool.get()), pool);
+            res.set_plan(std::move(plan));
+            return res;
+        }
+        catch (DatabaseException& ex)
+        {
+            return Result(ex.what());
+        }
+    }
+
+    CommandNodePointer SQLExplain::bind(const std::vector<Cell>& values) const
+    {
+        CommandNodePointer statement = statement_->bind(values);
+        if (!statement)
+            return nullptr;
+        return std::make_shared<SQLExplain>(statement, analyze_);
+    }
+
+    size_t SQLExplain::estimate(Session* session) const
+    {
+        // plans alone read no table
+        return analyze_ ? statement_->estimate(session) : 0;
+    }
 } // namespace memdb
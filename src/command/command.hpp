@@ -7,12 +7,14 @@
 #include <unordered_map>
 
 #include "command/result.hpp"
+#include "command/plan.hpp"
 #include "database/table.hpp"
 #include "expression/expression.hpp"
 
 namespace memdb 
 {
     class Database; // forward declaration
+    class Session;
 
     // Abstract class for command tree node
     class SQLCommand 
@@ -20,9 +22,30 @@ namespace memdb
     public:
         SQLCommand() {}
         virtual ~SQLCommand() {}
-        virtual Result execute(Database* database) = 0;
+        virtual Result execute(Session* session) = 0;
+
+        // Copy of the command with parameters $n of a prepared statement
+        // replaced by values[n - 1]. Commands that take no parameters
+        // return nullptr and run as they are
+        virtual CommandNodePointer bind(const std::vector<Cell>& values) const;
+
+        // Rows the command is expected to read, judged by Table::scan_estimate
+        // without running it. 0 for commands that scan no table
+        virtual size_t estimate(Session* session) const;
+
+        // Operators the command runs, see PlanNode
+        virtual PlanNode plan() const;
+
+        // Execute the command and set plan to its operators with their
+        // counters. By default the command is one operator, timed as a whole
+        virtual Result analyze(Session* session, PlanNode& plan);
     };
 
+    // Cells of an inserted row given as parameters: position of the cell
+    // (or name of its column) and index of the parameter, 0 for $1
+    typedef std::vector<std::pair<size_t, size_t>>      RowParameters;
+    typedef std::vector<std::pair<std::string, size_t>> NamedRowParameters;
+
     // Wrapper class for command tree
     class Command
     {
@@ -34,13 +57,43 @@ namespace memdb
         Command(Command&& other)             = default;
         Command& operator= (Command&& other) = default;
 
-        Result execute(Database* database);
+        Result execute(Session* session);
+
+        // Command with parameters $n replaced by values[n - 1], see SQLCommand::bind.
+        // Parts without parameters are shared with this command
+        Command bind(const std::vector<Cell>& values) const;
+
+        // See SQLCommand::estimate
+        size_t estimate(Session* session) const;
+
+        // See SQLCommand::plan
+        PlanNode plan() const;
+
+        // Statement the command was parsed from, CommandTypeCount if none
+        CommandType type() const { return type_; }
+
+        // Text the command was parsed from and the time parsing took, for
+        // the slow query log. Commands bound from it keep the text, with
+        // no parse time of their own
+        void set_source(std::shared_ptr<const std::string> query, uint64_t parse_ns);
+
+        // Execute the command, with its analyzed plan attached to the result
+        Result analyze(Session* session);
     private:
         // Only parser can construct command trees
         friend class Parser;
-        Command(CommandNodePointer root);
+        Command(CommandNodePointer root, CommandType type = CommandTypeCount);
+
+        // Result of f, with the run counted in the metrics of the database
+        template <typename F>
+        Result run(Session* session, F f);
 
         CommandNodePointer root_;
+        CommandType        type_ = CommandTypeCount;
+
+        std::shared_ptr<const std::string>
+                           query_;
+        uint64_t           parse_ns_ = 0;
     };
 
     // Leave of command tree
@@ -51,7 +104,11 @@ namespace memdb
         GetTable(const char* name);
 
         // Return a pointer to existing table from database
-        Result execute(Database* database) override;
+        Result execute(Session* session) override;
+
+        const std::string& name() const { return name_; }
+
+        PlanNode plan() const override;
 
     private:
         const std::string name_;
@@ -65,7 +122,7 @@ namespace memdb
 
         // Allocate table
         // Return pointer to it
-        Result execute(Database* database) override;
+        Result execute(Session* session) override;
 
     private:
         const std::string name_;    // Name of the table to create
@@ -75,29 +132,39 @@ namespace memdb
     class SQLInsertOrdered : public SQLCommand
     {
     public:
-        SQLInsertOrdered(const std::string& name, const std::vector<Cell>& data);
+        SQLInsertOrdered(const std::string& name, const std::vector<Cell>& data,
+            const RowParameters& parameters = {});
         SQLInsertOrdered(const char*   name, const std::vector<Cell>& data);
 
         // Insert a row_ to a table with provided name
-        Result execute(Database* database) override;
+        Result execute(Session* session) override;
+
+        CommandNodePointer bind(const std::vector<Cell>& values) const override;
+        PlanNode plan() const override;
 
     private:
         const std::string   name_; // Name of the table to insert to
         std::vector<Cell>   data_;
+        RowParameters       parameters_;    // cells of data_ still to be given
     };
 
     class SQLInsertUnordered : public SQLCommand
     {
     public:
-        SQLInsertUnordered(const std::string& name, const std::unordered_map<std::string, Cell>& data);
+        SQLInsertUnordered(const std::string& name, const std::unordered_map<std::string, Cell>& data,
+            const NamedRowParameters& parameters = {});
         SQLInsertUnordered(const char*   name, const std::unordered_map<std::string, Cell>& data);
 
         // Insert a row to a table with provided name
-        Result execute(Database* database) override;
+        Result execute(Session* session) override;
+
+        CommandNodePointer bind(const std::vector<Cell>& values) const override;
+        PlanNode plan() const override;
 
     private:
         const std::string   name_; // Name of the table to insert to
         std::unordered_map<std::string, Cell> data_;
+        NamedRowParameters  parameters_;    // values of data_ still to be given
     };
 
 
@@ -108,9 +175,21 @@ namespace memdb
             Expression& where);
 
         // Allocate new table
-        Result execute(Database* database) override;
+        Result execute(Session* session) override;
+
+        // Open a cursor of the session under name over the selected rows
+        // instead of selecting them all at once
+        Result declare(Session* session, const std::string& name);
+
+        CommandNodePointer bind(const std::vector<Cell>& values) const override;
+        size_t estimate(Session* session) const override;
+        PlanNode plan() const override;
+        Result analyze(Session* session, PlanNode& plan) override;
 
     private:
+        // Select from the result of the argument
+        Result select(Session* session, Result& arg);
+
         std::vector<std::string> column_names_;  // Pairs of table-column names
 
         CommandNodePointer
@@ -127,7 +206,12 @@ namespace memdb
         std::unordered_map<std::string, Expression>& set, 
         Expression& where);
 
-        Result execute(Database* database) override;
+        Result execute(Session* session) override;
+
+        CommandNodePointer bind(const std::vector<Cell>& values) const override;
+        size_t estimate(Session* session) const override;
+        PlanNode plan() const override;
+        Result analyze(Session* session, PlanNode& plan) override;
 
     private:
         std::string name_;
@@ -143,13 +227,160 @@ namespace memdb
     public:
         SQLDelete(const std::string& name, Expression& where);
 
-        Result execute(Database* database) override;
+        Result execute(Session* session) override;
+
+        CommandNodePointer bind(const std::vector<Cell>& values) const override;
+        size_t estimate(Session* session) const override;
+        PlanNode plan() const override;
+        Result analyze(Session* session, PlanNode& plan) override;
 
     private:
         const std::string name_; // table name
         Expression where_;     // Expression tree of conditions provided with WHERE 
     };
 
+    class SQLDropTable : public SQLCommand
+    {
+    public:
+        SQLDropTable(const std::string& name);
+
+        // Remove table from database
+        Result execute(Session* session) override;
+
+    private:
+        const std::string name_;
+    };
+
+    class SQLSave : public SQLCommand
+    {
+    public:
+        SQLSave(const std::string& path);
+
+        // Write a snapshot of the database to path
+        Result execute(Session* session) override;
+
+    private:
+        const std::string path_;
+    };
+
+    class SQLLoad : public SQLCommand
+    {
+    public:
+        SQLLoad(const std::string& path);
+
+        // Replace database contents with a snapshot from path
+        Result execute(Session* session) override;
+
+    private:
+        const std::string path_;
+    };
+
+    class SQLBackgroundSave : public SQLCommand
+    {
+    public:
+        SQLBackgroundSave(const std::string& path);
+
+        // Start writing a snapshot to path in a child process
+        Result execute(Session* session) override;
+
+    private:
+        const std::string path_;
+    };
+
+    class SQLBackgroundSaveStatus : public SQLCommand
+    {
+    public:
+        SQLBackgroundSaveStatus() = default;
+
+        // Allocate a one row table describing the running or the last background save
+        Result execute(Session* session) override;
+    };
+
+    class SQLBegin : public SQLCommand
+    {
+    public:
+        SQLBegin() = default;
+
+        // Open a transaction in the session
+        Result execute(Session* session) override;
+    };
+
+    class SQLCommit : public SQLCommand
+    {
+    public:
+        SQLCommit() = default;
+
+        // Apply changes of the open transaction
+        Result execute(Session* session) override;
+    };
+
+    class SQLRollback : public SQLCommand
+    {
+    public:
+        SQLRollback() = default;
+
+        // Discard changes of the open transaction
+        Result execute(Session* session) override;
+    };
+
+    class SQLDeclareCursor : public SQLCommand
+    {
+    public:
+        SQLDeclareCursor(const std::string& name, std::shared_ptr<SQLSelect> select);
+
+        // Open a cursor over the rows select matches
+        Result execute(Session* session) override;
+
+        CommandNodePointer bind(const std::vector<Cell>& values) const override;
+        PlanNode plan() const override;
+
+    private:
+        const std::string           name_;
+        std::shared_ptr<SQLSelect>  select_;
+    };
+
+    class SQLFetch : public SQLCommand
+    {
+    public:
+        SQLFetch(const std::string& name, size_t count);
+
+        // Allocate a table of the next count rows of the cursor
+        Result execute(Session* session) override;
+
+    private:
+        const std::string   name_;
+        const size_t        count_;
+    };
+
+    class SQLCloseCursor : public SQLCommand
+    {
+    public:
+        SQLCloseCursor(const std::string& name);
+
+        // Release the cursor and its snapshot
+        Result execute(Session* session) override;
+
+    private:
+        const std::string name_;
+    };
+
+    class SQLExplain : public SQLCommand
+    {
+    public:
+        SQLExplain(CommandNodePointer statement, bool analyze);
+
+        // Allocate a table of the operators of the statement. With ANALYZE
+        // the statement is run first and the table has their counters
+        Result execute(Session* session) override;
+
+        CommandNodePointer bind(const std::vector<Cell>& values) const override;
+        size_t estimate(Session* session) const override;
+
+    private:
+        CommandNodePointer  statement_;
+        const bool          analyze_;
+    };
+
     class SQLJoin;
     class SQLCreateIndex;
 
@@ -0,0 +1,526 @@
+#include "command/output.hpp"
+#include "database/table.hpp"
+
+#include <charconv>
+
+namespace memdb
+{
+    static const char hex_digits[] = "0123456789ABCDEF";
+
+    OutputBuffer::OutputBuffer()
+    : os_(nullptr)
+    { }
+
+    OutputBuffer::OutputBuffer(std::ostream& os)
+    : os_(&os)
+    {
+        data_.reserve(OUTPUT_CHUNK_SIZE + OUTPUT_CHUNK_SIZE / 4);
+    }
+
+    OutputBuffer::~OutputBuffer()
+    {
+        flush();
+    }
+
+    void OutputBuffer::append_int(int64_t value)
+    {
+        char digits[24];
+        auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), value);
+        data_.insert(data_.end(), digits, end);
+    }
+
+    void OutputBuffer::append_u16(uint16_t value)
+    {
+        data_.push_back(char(value));
+        data_.push_back(char(value >> 8));
+    }
+
+    void OutputBuffer::append_u32(uint32_t value)
+    {
+        for (int shift = 0; shift < 32; shift += 8)
+            data_.push_back(char(value >> shift));
+    }
+
+    void OutputBuffer::store_u32(size_t offset, uint32_t value)
+    {
+        for (int i = 0; i < 4; ++i)
+            data_[offset + i] = char(value >> (8 * i));
+    }
+
+    void OutputBuffer::flush()
+    {
+        if (!os_ || data_.empty())
+            return;
+
+        os_->write(data_.data(), data_.size());
+        data_.clear();
+    }
+
+    static void append_hex(std::string_view bytes, OutputBuffer& out)
+    {
+        out.append("0x");
+        for (unsigned char c : bytes) {
+            out.put(hex_digits[c >> 4]);
+            out.put(hex_digits[c & 0xF]);
+        }
+    }
+
+    void format_cell(const Cell& cell, CellType type, std::string& text)
+    {
+        switch (type)
+        {
+        case CellType::INT32:
+        {
+            char digits[16];
+            auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), cell.int_value());
+            text.assign(digits, end);
+            break;
+        }
+        case CellType::BOOL:
+            text.assign(cell.bool_value() ? "true" : "false");
+            break;
+        case CellType::STRING:
+            text.assign(cell.data());
+            break;
+        case CellType::BYTES:
+            text.assign("0x");
+            for (unsigned char c : cell.data()) {
+                text.push_back(hex_digits[c >> 4]);
+                text.push_back(hex_digits[c & 0xF]);
+            }
+            break;
+        }
+    }
+
+    //
+    // Aligned tables
+    //
+
+    static void append_spaces(size_t count, OutputBuffer& out)
+    {
+        static const char spaces[] = "                                ";
+        for (; count > sizeof(spaces) - 1; count -= sizeof(spaces) - 1)
+            out.append(std::string_view(spaces, sizeof(spaces) - 1));
+        out.append(std::string_view(spaces, count));
+    }
+
+    // Bar, then lines of cells until every cell is written, each cell wrapped at its width
+    static void append_aligned_row(const std::string* cells, const std::vector<size_t>& widths,
+        const std::string& bar, std::vector<size_t>& written, OutputBuffer& out)
+    {
+        out.append(bar);
+        written.assign(widths.size(), 0);
+
+        bool more = true;
+        while (more) {
+            more = false;
+            for (auto i = 0LU; i < widths.size(); ++i) {
+                std::string_view chunk = std::string_view(cells[i]).substr(written[i], widths[i]);
+                written[i] += chunk.size();
+                more |= written[i] < cells[i].size();
+
+                out.append("| ");
+                out.append(chunk);
+                append_spaces(widths[i] - chunk.size() + 1, out);
+            }
+            out.append("|\n");
+        }
+    }
+
+    void write_aligned(const Table& table, OutputBuffer& out, size_t max_rows)
+    {
+        const std::vector<Column>& columns = table.columns();
+        const size_t width = columns.size();
+
+        std::vector<size_t> widths(width);
+        for (auto i = 0LU; i < width; ++i)
+            widths[i] = columns[i].name_.size();
+
+        // cells of the first rows, row after row, kept until the widths are known
+        std::vector<std::string> sample;
+        size_t sampled = 0;
+        bool sampling = true;
+
+        std::vector<std::string> cells(width);
+        std::vector<size_t> written;
+        std::string bar;
+
+        auto end_sample = [&]
+        {
+            for (auto k = 0LU; k < sample.size(); ++k)
+                widths[k % width] = std::max<size_t>(widths[k % width],
+                    std::min<size_t>(sample[k].size(), PRINT_MAX_WIDTH));
+
+            size_t length = 1;
+            for (size_t column_width : widths)
+                length += column_width + 3;
+            bar.assign(length, '-');
+            bar.push_back('\n');
+
+            out.append(bar);
+            for (auto i = 0LU; i < width; ++i) {
+                out.append("| ");
+                out.append(columns[i].name_);
+                append_spaces(widths[i] - columns[i].name_.size() + 1, out);
+            }
+            out.append("|\n");
+
+            for (auto r = 0LU; r < sampled; ++r)
+                append_aligned_row(&sample[r * width], widths, bar, written, out);
+
+            sample = std::vector<std::string>();
+            sampling = false;
+        };
+
+        table.for_each_row([&] (const Row& row, const std::vector<size_t>& positions)
+        {
+            if (sampling) {
+                for (auto i = 0LU; i < width; ++i) {
+                    sample.emplace_back();
+                    format_cell(row[positions[i]], columns[i].type_, sample.back());
+                }
+                if (++sampled == PRINT_SAMPLE_ROWS)
+                    end_sample();
+                return;
+            }
+
+            for (auto i = 0LU; i < width; ++i)
+                format_cell(row[positions[i]], columns[i].type_, cells[i]);
+            append_aligned_row(cells.data(), widths, bar, written, out);
+            out.flush_if_full();
+        }, max_rows);
+
+        if (sampling)
+            end_sample();
+        out.append(bar);
+
+        size_t size = table.size();
+        if (size > max_rows) {
+            out.put('(');
+            out.append_int(max_rows);
+            out.append(" of ");
+            out.append_int(size);
+            out.append(" rows shown)\n");
+        }
+        out.flush();
+    }
+
+    //
+    // CSV
+    //
+
+    static void append_csv_string(std::string_view text, OutputBuffer& out)
+    {
+        if (text.find_first_of(",\"\r\n") == std::string_view::npos) {
+            out.append(text);
+            return;
+        }
+
+        // quotes inside a quoted field are doubled
+        out.put('"');
+        for (char c : text) {
+            if (c == '"')
+                out.put('"');
+            out.put(c);
+        }
+        out.put('"');
+    }
+
+    void write_csv(const Table& table, OutputBuffer& out)
+    {
+        const std::vector<Column>& columns = table.columns();
+
+        for (auto i = 0LU; i < columns.size(); ++i) {
+            if (i)
+                out.put(',');
+            append_csv_string(columns[i].name_, out);
+        }
+        out.put('\n');
+
+        table.for_each_row([&] (const Row& row, const std::vector<size_t>& positions)
+        {
+            for (auto i = 0LU; i < columns.size(); ++i)
+            {
+                if (i)
+                    out.put(',');
+
+                const Cell& cell = row[positions[i]];
+                switch (columns[i].type_)
+                {
+                case CellType::INT32:   out.append_int(cell.int_value()); break;
+                case CellType::BOOL:    out.append(cell.bool_value() ? "true" : "false"); break;
+                case CellType::STRING:  append_csv_string(cell.data(), out); break;
+                case CellType::BYTES:   append_hex(cell.data(), out); break;
+                }
+            }
+            out.put('\n');
+            out.flush_if_full();
+        });
+
+        out.flush();
+    }
+
+    //
+    // JSON
+    //
+
+    static void append_json_string(std::string_view text, OutputBuffer& out)
+    {
+        out.put('"');
+        for (unsigned char c : text)
+        {
+            switch (c)
+            {
+            case '"':   out.append("\\\""); break;
+            case '\\':  out.append("\\\\"); break;
+            case '\n':  out.append("\\n"); break;
+            case '\r':  out.append("\\r"); break;
+            case '\t':  out.append("\\t"); break;
+            default:
+                if (c < 0x20) {
+                    out.append("\\u00");
+                    out.put(hex_digits[c >> 4]);
+                    out.put(hex_digits[c & 0xF]);
+                }
+                else
+                    out.put(char(c));
+            }
+        }
+        out.put('"');
+    }
+
+    void write_json(const Table* table, OutputBuffer& out)
+    {
+        out.append("{\"columns\":[");
+        if (table)
+        {
+            const std::vector<Column>& columns = table->columns();
+            for (auto i = 0LU; i < columns.size(); ++i) {
+                out.append(i ? ",{\"name\":" : "{\"name\":");
+                append_json_string(columns[i].name_, out);
+                out.append(",\"type\":");
+                append_json_string(type_name(columns[i].type_), out);
+                out.put('}');
+            }
+        }
+        out.append("],\"rows\":[");
+
+        if (table)
+        {
+            const std::vector<Column>& columns = table->columns();
+            bool first = true;
+            table->for_each_row([&] (const Row& row, const std::vector<size_t>& positions)
+            {
+                out.append(first ? "[" : ",[");
+                first = false;
+
+                for (auto i = 0LU; i < columns.size(); ++i)
+                {
+                    if (i)
+                        out.put(',');
+
+                    const Cell& cell = row[positions[i]];
+                    switch (columns[i].type_)
+                    {
+                    case CellType::INT32:   out.append_int(cell.int_value()); break;
+                    case CellType::BOOL:    out.append(cell.bool_value() ? "true" : "false"); break;
+                    case CellType::STRING:  append_json_string(cell.data(), out); break;
+                    case CellType::BYTES:
+                        out.put('"');
+                        append_hex(cell.data(), out);
+                        out.put('"');
+                        break;
+                    }
+                }
+                out.put(']');
+                out.flush_if_full();
+            });
+        }
+
+        out.append("]}\n");
+        out.flush();
+    }
+
+    void write_json_error(std::string_view error, OutputBuffer& out)
+    {
+        // messages of exceptions end with a line break
+        if (!error.empty() && error.back() == '\n')
+            error.remove_suffix(1);
+
+        out.append("{\"error\":");
+        append_json_string(error, out);
+        out.append("}\n");
+        out.flush();
+    }
+
+    //
+    // Binary
+    //
+
+    static void append_binary_header(uint8_t status, OutputBuffer& out)
+    {
+        out.append("MDBR");
+        out.append_u8(BINARY_RESULT_VERSION);
+        out.append_u8(status);
+    }
+
+    void write_binary(const Table* table, OutputBuffer& out)
+    {
+        append_binary_header(0, out);
+
+        if (!table) {
+            out.append_u16(0);
+            out.append_u32(0);
+            out.flush();
+            return;
+        }
+
+        const std::vector<Column>& columns = table->columns();
+        out.append_u16(columns.size());
+        for (auto& column : columns) {
+            out.append_u8(column.type_);
+            out.append_u16(column.name_.size());
+            out.append(column.name_);
+        }
+
+        // the row count of a block is filled in when the block is closed
+        size_t block = out.size();
+        uint32_t rows = 0;
+        out.append_u32(0);
+
+        table->for_each_row([&] (const Row& row, const std::vector<size_t>& positions)
+        {
+            for (auto i = 0LU; i < columns.size(); ++i)
+            {
+                const Cell& cell = row[positions[i]];
+                switch (columns[i].type_)
+                {
+                case CellType::INT32:   out.append_u32(uint32_t(cell.int_value())); break;
+                case CellType::BOOL:    out.append_u8(cell.bool_value()); break;
+                case CellType::STRING:
+                case CellType::BYTES:
+                {
+                    std::string_view data = cell.data();
+                    out.append_u32(data.size());
+                    out.append(data);
+                    break;
+                }
+                }
+            }
+            rows++;
+
+            if (out.size() - block >= OUTPUT_CHUNK_SIZE) {
+                out.store_u32(block, rows);
+                out.flush_if_full();
+                block = out.size();
+                rows = 0;
+                out.append_u32(0);
+            }
+        });
+
+        // an empty block ends the result
+        if (rows) {
+            out.store_u32(block, rows);
+            out.append_u32(0);
+        }
+        out.flush();
+    }
+
+    void write_binary_error(std::string_view error, OutputBuffer& out)
+    {
+        append_binary_header(1, out);
+        out.append_u32(error.size());
+        out.append(error);
+        out.flush();
+    }
+
+    //
+    // Columnar
+    //
+
+    static void append_columns(const std::vector<Column>& columns, OutputBuffer& out)
+    {
+        out.append_u16(columns.size());
+        for (auto& column : columns) {
+            out.append_u8(column.type_);
+            out.append_u16(column.name_.size());
+            out.append(column.name_);
+        }
+    }
+
+    // One batch of rows that share positions, column after column
+    static void append_batch(const std::vector<Column>& columns, const std::vector<const Row*>& rows,
+        const std::vector<size_t>& positions, OutputBuffer& out)
+    {
+        out.append_u32(rows.size());
+
+        for (auto i = 0LU; i < columns.size(); ++i)
+        {
+            size_t position = positions[i];
+            switch (columns[i].type_)
+            {
+            case CellType::INT32:
+                for (const Row* row : rows)
+                    out.append_u32(uint32_t((*row)[position].int_value()));
+                break;
+            case CellType::BOOL:
+                for (const Row* row : rows)
+                    out.append_u8((*row)[position].bool_value());
+                break;
+            case CellType::STRING:
+            case CellType::BYTES:
+            {
+                // end offsets first, so a client finds every value without a scan
+                uint32_t offset = 0;
+                out.append_u32(0);
+                for (const Row* row : rows) {
+                    offset += (*row)[position].data().size();
+                    out.append_u32(offset);
+                }
+                for (const Row* row : rows)
+                    out.append((*row)[position].data());
+                break;
+            }
+            }
+        }
+    }
+
+    void write_columnar(const Table* table, OutputBuffer& out)
+    {
+        if (!table) {
+            out.append_u16(0);
+            out.append_u32(0);
+            out.flush();
+            return;
+        }
+
+        const std::vector<Column>& columns = table->columns();
+        append_columns(columns, out);
+
+        // projected and stored rows have their columns at different positions.
+        // The positions are copied, for_each_row keeps its own only during the call
+        std::vector<const Row*> rows;
+        std::vector<size_t> positions;
+        const std::vector<size_t>* source = nullptr;
+        rows.reserve(COLUMNAR_BATCH_ROWS);
+
+        table->for_each_row([&] (const Row& row, const std::vector<size_t>& row_positions)
+        {
+            if (!rows.empty() && (rows.size() == COLUMNAR_BATCH_ROWS || &row_positions != source)) {
+                append_batch(columns, rows, positions, out);
+                out.flush_if_full();
+                rows.clear();
+            }
+            if (&row_positions != source) {
+                source = &row_positions;
+                positions = row_positions;
+            }
+            rows.push_back(&row);
+        });
+
+        if (!rows.empty())
+            append_batch(columns, rows, positions, out);
+        out.append_u32(0);
+        out.flush();
+    }
+} // namespace memdb
@@ -0,0 +1,135 @@
+#ifndef HEADER_GUARD_COMMAND_OUTPUT_H
+#define HEADER_GUARD_COMMAND_OUTPUT_H
+
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "cell/cell.hpp"
+
+// Size of the chunks an OutputBuffer writes to its stream
+#define OUTPUT_CHUNK_SIZE (64U * 1024U)
+
+// Version of the binary result format, see write_binary
+#define BINARY_RESULT_VERSION 1U
+
+// Rows per batch of the columnar format, see write_columnar
+#define COLUMNAR_BATCH_ROWS 1024U
+
+// Aligned tables size their columns to the values of this many first rows
+#define PRINT_SAMPLE_ROWS 1000U
+
+// Longer values wrap onto more lines of their column
+#define PRINT_MAX_WIDTH 40U
+
+namespace memdb
+{
+    class Table;
+
+    /*
+        Formatted output collected in one buffer, numbers formatted in place
+        with std::to_chars.
+
+        Writers append whole rows and call flush_if_full() between them, so
+        a stream gets chunks of about OUTPUT_CHUNK_SIZE bytes. The buffer
+        keeps its memory between chunks and can be reused for many results.
+        Without a stream the output stays in the buffer until it is taken
+        with view() and clear().
+    */
+    class OutputBuffer
+    {
+    public:
+        OutputBuffer();
+        OutputBuffer(std::ostream& os);
+        ~OutputBuffer();
+
+        OutputBuffer(const OutputBuffer& other)             = delete;
+        OutputBuffer& operator= (const OutputBuffer& other) = delete;
+
+        void put(char c)                    { data_.push_back(c); }
+        void append(std::string_view text)  { data_.insert(data_.end(), text.begin(), text.end()); }
+        void append_int(int64_t value);
+
+        // Little-endian integers of the binary format
+        void append_u8(uint8_t value)       { data_.push_back(char(value)); }
+        void append_u16(uint16_t value);
+        void append_u32(uint32_t value);
+        void store_u32(size_t offset, uint32_t value);
+
+        size_t size() const                 { return data_.size(); }
+        bool full() const                   { return data_.size() >= OUTPUT_CHUNK_SIZE; }
+
+        // Write the buffer to the stream and empty it. Nothing to do without a stream
+        void flush();
+        void flush_if_full()                { if (full()) flush(); }
+
+        std::string_view view() const       { return std::string_view(data_.data(), data_.size()); }
+        void clear()                        { data_.clear(); }
+
+    private:
+        std::ostream*       os_;
+        std::vector<char>   data_;
+    };
+
+    // Text of a cell in aligned tables: strings as they are, bytes as 0x hex
+    void format_cell(const Cell& cell, CellType type, std::string& text);
+
+    // Table with a line per row, columns as wide as their name or their widest
+    // value among the first PRINT_SAMPLE_ROWS rows, up to PRINT_MAX_WIDTH. Every
+    // cell is formatted once. At most max_rows rows are written, a note tells
+    // how many were left out
+    void write_aligned(const Table& table, OutputBuffer& out, size_t max_rows = SIZE_MAX);
+
+    // Header line with the column names, then one line per row. Strings are
+    // quoted when they hold a comma, a quote or a line break, bytes are 0x hex
+    void write_csv(const Table& table, OutputBuffer& out);
+
+    // {"columns":[{"name":...,"type":...}],"rows":[[...],...]}, bytes are "0x" hex strings.
+    // table may be null for a successful statement without a table
+    void write_json(const Table* table, OutputBuffer& out);
+    void write_json_error(std::string_view error, OutputBuffer& out);
+
+    /*
+        Binary result, every integer little-endian:
+
+            "MDBR" u8 version u8 status
+            status 1:   u32 length, error message
+            status 0:   u16 column count, columns, row blocks
+
+            column      u8 CellType, u16 length, name
+            row block   u32 row count, rows. A block of 0 rows ends the result
+            row         cells in column order:
+                        INT32 4 bytes, BOOL 1 byte, STRING and BYTES u32 length, data
+
+        A block is sent per chunk of output, so a client decodes rows at fixed
+        offsets as soon as their block arrives. table may be null for a
+        successful statement without a table.
+    */
+    void write_binary(const Table* table, OutputBuffer& out);
+    void write_binary_error(std::string_view error, OutputBuffer& out);
+
+    /*
+        Table in columnar batches, every integer little-endian:
+
+            u16 column count, columns, batches
+
+            column      u8 CellType, u16 length, name
+            batch       u32 row count, then every column in order.
+                        A batch of 0 rows ends the table
+            INT32       4 bytes per row
+            BOOL        1 byte per row
+            STRING      u32 end offsets, one more than rows starting with 0,
+            BYTES       then the values back to back
+
+        A client reads a whole column of a batch as one array, e.g. the INT32
+        values straight into memory. There is no header or status, the
+        server protocol frames it, see Server. table may be null for a
+        successful statement without a table, that is no columns and no rows.
+    */
+    void write_columnar(const Table* table, OutputBuffer& out);
+} // namespace memdb
+
+#endif // HEADER_GUARD_COMMAND_OUTPUT_H
@@ -0,0 +1,68 @@
+#include "command/plan.hpp"
+#include "command/result.hpp"
+#include "database/table.hpp"
+
+namespace memdb
+{
+    uint64_t PlanNode::total_ns() const
+    {
+        uint64_t total = time_ns_;
+        for (auto& child : children_)
+            total += child.total_ns();
+        return total;
+    }
+
+    std::string plan_summary(const PlanNode& plan)
+    {
+        std::string text = plan.name_;
+        if (!plan.detail_.empty())
+            text += ' ' + plan.detail_;
+
+        if (plan.children_.size() == 1)
+            text += " <- " + plan_summary(plan.children_.front());
+        else if (!plan.children_.empty()) {
+            text += " <- (";
+            for (auto i = 0LU; i < plan.children_.size(); ++i)
+                text += (i ? ", " : "") + plan_summary(plan.children_[i]);
+            text += ')';
+        }
+        return text;
+    }
+
+    static void add_rows(Table& table, const PlanNode& node, size_t depth, bool analyzed)
+    {
+        std::string text(2 * depth, ' ');
+        text += node.name_;
+        if (!node.detail_.empty()) {
+            text += ' ';
+            text += node.detail_;
+        }
+
+        // long conditions are clipped to fit the cell
+        std::vector<Cell> row{Cell(text.substr(0, MAX_STRING_DATA))};
+        if (analyzed) {
+            row.push_back(clipped_int(node.rows_in_));
+            row.push_back(clipped_int(node.rows_out_));
+            row.push_back(clipped_int(node.rows_skipped_));
+            row.push_back(clipped_int(node.time_ns_ / 1000));
+            row.push_back(clipped_int(node.bytes_));
+        }
+        table.insert(std::move(row));
+
+        for (auto& child : node.children_)
+            add_rows(table, child, depth + 1, analyzed);
+    }
+
+    std::unique_ptr<Table> plan_table(const PlanNode& plan, bool analyzed, ResultPool* pool)
+    {
+        std::vector<Column> columns{Column(CellType::STRING, "operator", 0)};
+        if (analyzed)
+            for (const char* name : {"rows_in", "rows_out", "skipped", "time_us", "bytes"})
+                columns.emplace_back(CellType::INT32, name, 0);
+
+        std::unique_ptr<Table> table = pool ? pool->acquire(columns)
+            : std::make_unique<Table>("", columns);
+        add_rows(*table, plan, 0, analyzed);
+        return table;
+    }
+} // namespace memdb
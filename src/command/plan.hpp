@@ -0,0 +1,56 @@
+#ifndef HEADER_GUARD_COMMAND_PLAN_H
+#define HEADER_GUARD_COMMAND_PLAN_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace memdb
+{
+    class Table;
+    class ResultPool;
+
+    /*
+        Operator of a statement plan, as EXPLAIN shows it: Project over
+        Scan for SELECT, Update or Delete over Scan, Insert alone. The
+        WHERE condition is evaluated inside the scan loop, so it is part
+        of the Scan operator, not an operator of its own.
+
+        EXPLAIN ANALYZE runs the statement and fills in the counters.
+        rows_in_ of a Scan is the slots of the table it went through,
+        rows_skipped_ the ones zone maps and compressed columns ruled out
+        without reading their rows. time_ns_ and bytes_ are of the
+        operator itself, not its children.
+    */
+    struct PlanNode
+    {
+        PlanNode(const std::string& name, const std::string& detail = "")
+        : name_(name), detail_(detail)
+        { }
+
+        std::string             name_;
+        std::string             detail_;    // table, columns or condition
+        std::vector<PlanNode>   children_;
+
+        size_t      rows_in_ = 0;
+        size_t      rows_out_ = 0;
+        size_t      rows_skipped_ = 0;
+        uint64_t    time_ns_ = 0;
+        size_t      bytes_ = 0;
+
+        // Time of the operator and all of its children
+        uint64_t total_ns() const;
+    };
+
+    // Operators on one line, parent first: "Project a <- Scan t filter a == 1".
+    // Operators with more than one input list them in parentheses
+    std::string plan_summary(const PlanNode& plan);
+
+    // Table with a row per operator, children indented under their parent.
+    // With analyzed set it has the counters of every operator as well
+    std::unique_ptr<Table> plan_table(const PlanNode& plan, bool analyzed, ResultPool* pool = nullptr);
+} // namespace memdb
+
+#endif // HEADER_GUARD_COMMAND_PLAN_H
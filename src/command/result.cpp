@@ -1,23 +1,84 @@
 #include "command/result.hpp"
+#include "command/output.hpp"
 #include "database/table.hpp"
 
 namespace memdb 
 {
-    void Result::print(std::ostream& os)
+    ResultPool::~ResultPool() = default;
+
+    std::unique_ptr<Table> ResultPool::acquire(const std::vector<Column>& columns)
+    {
+        std::unique_ptr<Table> table;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!tables_.empty()) {
+                table = std::move(tables_.back());
+                tables_.pop_back();
+            }
+        }
+
+        if (!table)
+            return std::make_unique<Table>("", columns);
+
+        table->reset(columns);
+        return table;
+    }
+
+    void ResultPool::release(std::unique_ptr<Table> table)
+    {
+        // unpin the rows it was selected from before it waits for reuse
+        table->reset({});
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (tables_.size() < RESULT_POOL_CAPACITY)
+            tables_.push_back(std::move(table));
+    }
+
+    size_t ResultPool::size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return tables_.size();
+    }
+
+    void ResultRelease::operator() (Table* table) const
+    {
+        if (pool_)
+            pool_->release(std::unique_ptr<Table>(table));
+        else
+            delete table;
+    }
+
+    void Result::print(std::ostream& os, size_t max_rows)
     {
         if (!status_)
             os << error_;
 
-        if (!table_) 
+        Table* table = get_table();
+        if (!table) 
             return;
 
-        table_->print(os);
+        table->print(os, max_rows);
     }
 
+    void Result::write_csv(OutputBuffer& out) const
+    {
+        if (Table* table = get_table())
+            memdb::write_csv(*table, out);
+    }
+
+    void Result::write_json(OutputBuffer& out) const
+    {
+        if (status_)
+            memdb::write_json(get_table(), out);
+        else
+            write_json_error(error_, out);
+    }
 
-    Result::~Result()
+    void Result::write_binary(OutputBuffer& out) const
     {
-        // if (table_ && table_->name().empty())
-        //     delete table_;
+        if (status_)
+            memdb::write_binary(get_table(), out);
+        else
+            write_binary_error(error_, out);
     }
-} // namespace memdb
\ No newline at end of file
+} // namespace memdb
@@ -3,44 +3,140 @@
 
 #include <ostream>
 #include <memory>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
 
-namespace memdb 
+// Number of released result tables a pool keeps for reuse
+#define RESULT_POOL_CAPACITY 8U
+
+namespace memdb
 {
     class Table;
+    class OutputBuffer;
+    struct Column;
+    struct PlanNode;
+
+    /*
+        Result tables released by the statements of one session, handed out
+        again to the next ones instead of allocating new tables.
+
+        A released table is emptied right away, so it pins no rows of the
+        table it was selected from while it waits in the pool.
+    */
+    class ResultPool
+    {
+    public:
+        ResultPool() = default;
+        ~ResultPool();
+
+        ResultPool(const ResultPool& other)             = delete;
+        ResultPool& operator= (const ResultPool& other) = delete;
+
+        // Empty unnamed table of columns, reused if one was released
+        std::unique_ptr<Table> acquire(const std::vector<Column>& columns);
+
+        // Keep table for reuse, delete it if the pool is full
+        void release(std::unique_ptr<Table> table);
+
+        // Number of tables waiting for reuse
+        size_t size() const;
+
+    private:
+        mutable std::mutex                  mutex_;
+        std::vector<std::unique_ptr<Table>> tables_;
+    };
+
+    // Hands an owned result table back to its pool, or deletes it without one
+    struct ResultRelease
+    {
+        std::shared_ptr<ResultPool> pool_;
 
+        void operator() (Table* table) const;
+    };
+
+    typedef std::unique_ptr<Table, ResultRelease> ResultTable;
+
+    /*
+        Outcome of one statement: an error message, or success with an
+        optional table, and the plan of the statement if it was analyzed.
+
+        The table is either an owned result set, e.g. the output of SELECT,
+        destroyed (or returned to the pool it came from) with the result,
+        or a borrowed table of the catalog, which stays valid while the
+        result exists even if it is dropped. Results are moved, not copied.
+    */
     class Result
     {
     public:
         Result() = delete;
-        Result(const Result& other)             = default;
+        Result(const Result& other)             = delete;
         Result(Result&& other)                  = default;
-        Result& operator=(const Result& other)  = default;
+        Result& operator=(const Result& other)  = delete;
         Result& operator=(Result&& other)       = default;
 
-        ~Result();
+        ~Result() = default;
+
+        // Success without a table
+        Result(std::nullptr_t)
+        : status_(true)
+        { }
+
+        // Owned result set, handed back to pool when the result is destroyed
+        Result(std::unique_ptr<Table> table, std::shared_ptr<ResultPool> pool = nullptr)
+        : owned_(table.release(), ResultRelease{std::move(pool)}), status_(true)
+        { }
 
-        Result(Table* table) 
-        : table_(table), status_(true), error_()
+        // Borrowed table of the catalog
+        Result(std::shared_ptr<Table> table)
+        : shared_table_(std::move(table)), status_(true)
         { }
 
         Result(const char* error)
-        : table_(nullptr), status_(false), error_(error)
+        : status_(false), error_(error)
         { }
 
         Result(const std::string& error)
-        : table_(nullptr), status_(false), error_(error)
+        : status_(false), error_(error)
         { }
 
         bool ok() const             { return status_; }
-        Table* get_table() const    { return table_; }
+        const std::string& error() const    { return error_; }
+        Table* get_table() const    { return owned_ ? owned_.get() : shared_table_.get(); }
+
+        // Set only for tables of the catalog
+        std::shared_ptr<Table> shared_table() const { return shared_table_; }
+
+        // Take the owned result set out of the result, null for borrowed tables
+        ResultTable release()       { return std::move(owned_); }
+
+        // Operators and their counters, for statements run by EXPLAIN ANALYZE
+        // or Command::analyze. nullptr otherwise
+        const PlanNode* plan() const    { return plan_.get(); }
+        void set_plan(std::shared_ptr<const PlanNode> plan) { plan_ = std::move(plan); }
+
+        // Error message, or the table aligned with at most max_rows rows
+        void print(std::ostream& os, size_t max_rows = SIZE_MAX);
+
+        // Table of the result as CSV, nothing for a failed statement
+        void write_csv(OutputBuffer& out) const;
+
+        // Table of the result as JSON, {"error":...} for a failed statement
+        void write_json(OutputBuffer& out) const;
 
-        void print(std::ostream& os);
+        // Result in the binary format of memdb::write_binary, errors included
+        void write_binary(OutputBuffer& out) const;
     private:
-        Table* table_;
-        bool   status_;
-        std::string error_;
+        ResultTable             owned_;
+        std::shared_ptr<Table>  shared_table_;
+        bool                    status_;
+        std::string             error_;
+        std::shared_ptr<const PlanNode>
+                                plan_;
     };
 } // namespace memdb
 
 
-#endif // HEADER_GUARD_COMMAND_RESULT_H
\ No newline at end of file
+#endif // HEADER_GUARD_COMMAND_RESULT_H
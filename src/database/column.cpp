@@ -32,4 +32,15 @@ namespace memdb
         return name_ == other.name_;
     }
 
+    Cell Column::default_value() const
+    {
+        switch (type_)
+        {
+        case CellType::INT32:   return Cell(Int32(0));
+        case CellType::BOOL:    return Cell(false);
+        case CellType::STRING:  return Cell(std::string());
+        default:                return Cell(std::vector<std::byte>());
+        }
+    }
+
 } // namespace memdb
\ No newline at end of file
@@ -5,6 +5,8 @@
 #include <map>
 #include <unordered_map>
 #include "cell/cell.hpp"
+#include "cell/dictionary.hpp"
+#include "database/row.hpp"
 
 namespace memdb 
 {
@@ -15,7 +17,7 @@ namespace memdb
         Autoincrement = 4
     };
 
-    typedef typename std::map<Cell, size_t, CellCompare> Index;
+    typedef typename std::map<Cell, RowId, CellCompare> Index;
 
     struct Column
     {
@@ -23,6 +25,11 @@ namespace memdb
         std::string     name_;
         unsigned char   attributes_;
 
+        // Distinct values of a STRING column, shared with the columns of
+        // tables selected from it. Set by the table
+        std::shared_ptr<Dictionary>
+                        dictionary_;
+
         Column();
         Column(const char *name);
         Column(const std::string& name);
@@ -35,6 +42,9 @@ namespace memdb
         Column& operator= (Column&& other) = default;
 
         bool operator== (const Column& other) const;
+
+        // Value of a cell omitted on insert
+        Cell default_value() const;
     };
 
     struct ColumnHash
@@ -0,0 +1,42 @@
+#include "database/compactor.hpp"
+
+#include <chrono>
+
+namespace memdb
+{
+    Compactor::~Compactor()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        stop_cv_.notify_all();
+        if (thread_.joinable())
+            thread_.join();
+    }
+
+    void Compactor::start(std::function<void()> pass, unsigned interval_ms)
+    {
+        pass_ = std::move(pass);
+        interval_ms_ = interval_ms;
+        thread_ = std::thread(&Compactor::loop, this);
+    }
+
+    void Compactor::loop()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stop_)
+        {
+            stop_cv_.wait_for(lock, std::chrono::milliseconds(interval_ms_));
+            if (stop_)
+                break;
+
+            lock.unlock();
+            try {
+                pass_();
+            }
+            catch (std::exception&) { } // the next pass tries again
+            lock.lock();
+        }
+    }
+} // namespace memdb
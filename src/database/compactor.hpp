@@ -0,0 +1,44 @@
+#ifndef HEADER_GUARD_DATABASE_COMPACTOR_H
+#define HEADER_GUARD_DATABASE_COMPACTOR_H
+
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+#define COMPACTION_INTERVAL_MS 1000U
+
+namespace memdb
+{
+    /*
+        Background thread running a compaction pass every interval.
+
+        The pass itself decides what is worth rewriting, a table that saw
+        no deletes since the last pass costs a look at its segment counters.
+    */
+    class Compactor
+    {
+    public:
+        Compactor() = default;
+        ~Compactor();
+
+        Compactor(const Compactor& other)               = delete;
+        Compactor& operator= (const Compactor& other)   = delete;
+
+        // Run pass every interval_ms until destroyed
+        void start(std::function<void()> pass, unsigned interval_ms = COMPACTION_INTERVAL_MS);
+
+    private:
+        void loop();
+
+        std::function<void()>   pass_;
+        unsigned                interval_ms_ = COMPACTION_INTERVAL_MS;
+
+        std::mutex              mutex_;
+        bool                    stop_ = false;
+        std::condition_variable stop_cv_;
+        std::thread             thread_;
+    };
+} // namespace memdb
+
+#endif // HEADER_GUARD_DATABASE_COMPACTOR_H
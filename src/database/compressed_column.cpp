@@ -0,0 +1,174 @@
+#include "database/compressed_column.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace memdb
+{
+    static void set_bit(uint64_t* words, size_t index)
+    {
+        words[index / 64] |= uint64_t(1) << (index % 64);
+    }
+
+    PackedInts::PackedInts(const std::vector<uint64_t>& values, unsigned width)
+    : width_(width), words_((values.size() * width + 63) / 64, 0)
+    {
+        for (auto i = 0LU; i < values.size() && width_ > 0; ++i)
+        {
+            size_t bit = i * width_;
+            words_[bit / 64] |= values[i] << (bit % 64);
+            if (bit % 64 + width_ > 64)
+                words_[bit / 64 + 1] |= values[i] >> (64 - bit % 64);
+        }
+    }
+
+    uint64_t PackedInts::operator[] (size_t index) const
+    {
+        if (width_ == 0)
+            return 0;
+
+        size_t bit = index * width_;
+        uint64_t value = words_[bit / 64] >> (bit % 64);
+        if (bit % 64 + width_ > 64)
+            value |= words_[bit / 64 + 1] << (64 - bit % 64);
+        return width_ == 64 ? value : value & ((uint64_t(1) << width_) - 1);
+    }
+
+    // values - base packed with the least width that fits them
+    static PackedInts pack(const std::vector<int64_t>& values, int64_t base)
+    {
+        std::vector<uint64_t> codes;
+        uint64_t max = 0;
+        for (int64_t value : values) {
+            codes.push_back(value - base);
+            max = std::max(max, codes.back());
+        }
+        return PackedInts(codes, std::bit_width(max));
+    }
+
+    CompressedColumn::CompressedColumn(const std::vector<int32_t>& values)
+    : encoding_(FrameOfReference), size_(values.size()), base_(0), first_(0)
+    {
+        if (values.empty())
+            return;
+
+        std::vector<int64_t> wide(values.begin(), values.end());
+        int64_t min = *std::min_element(wide.begin(), wide.end());
+        PackedInts frame = pack(wide, min);
+
+        std::vector<int64_t> deltas;
+        for (auto i = 1LU; i < wide.size(); ++i)
+            deltas.push_back(wide[i] - wide[i - 1]);
+        int64_t min_delta = deltas.empty() ? 0 : *std::min_element(deltas.begin(), deltas.end());
+        PackedInts delta = pack(deltas, min_delta);
+
+        std::vector<std::pair<int32_t, uint32_t>> runs;
+        for (auto i = 0LU; i < values.size(); ++i) {
+            if (runs.empty() || runs.back().first != values[i])
+                runs.emplace_back(values[i], i);
+            runs.back().second = i + 1;
+        }
+        size_t runs_bytes = runs.size() * sizeof(runs[0]);
+
+        if (runs_bytes <= std::min(frame.bytes(), delta.bytes())) {
+            encoding_ = RunLength;
+            runs_ = std::move(runs);
+        }
+        else if (frame.bytes() <= delta.bytes()) {
+            encoding_ = FrameOfReference;
+            base_ = min;
+            packed_ = std::move(frame);
+        }
+        else {
+            encoding_ = Delta;
+            base_ = min_delta;
+            first_ = values[0];
+            packed_ = std::move(delta);
+        }
+    }
+
+    size_t CompressedColumn::bytes() const
+    {
+        return encoding_ == RunLength ? runs_.size() * sizeof(runs_[0]) : packed_.bytes();
+    }
+
+    std::vector<int32_t> CompressedColumn::decode() const
+    {
+        std::vector<int32_t> values;
+        values.reserve(size_);
+
+        switch (encoding_)
+        {
+        case RunLength:
+            for (auto &[value, end] : runs_)
+                values.resize(end, value);
+            break;
+
+        case FrameOfReference:
+            for (auto i = 0LU; i < size_; ++i)
+                values.push_back(base_ + packed_[i]);
+            break;
+
+        case Delta:
+        {
+            int64_t value = first_;
+            for (auto i = 0LU; i < size_; ++i) {
+                if (i > 0)
+                    value += base_ + packed_[i - 1];
+                values.push_back(value);
+            }
+            break;
+        }
+        }
+
+        return values;
+    }
+
+    void CompressedColumn::select(int64_t lo, int64_t hi, uint64_t* words) const
+    {
+        if (lo > hi || size_ == 0)
+            return;
+
+        switch (encoding_)
+        {
+        case RunLength:
+        {
+            uint32_t begin = 0;
+            for (auto &[value, end] : runs_) {
+                if (lo <= value && value <= hi)
+                    for (auto i = begin; i < end; ++i)
+                        set_bit(words, i);
+                begin = end;
+            }
+            return;
+        }
+
+        case FrameOfReference:
+        {
+            // compare codes with the range shifted by the minimum, no value is decoded
+            uint64_t max_code = packed_.width() == 0 ? 0 : (uint64_t(-1) >> (64 - packed_.width()));
+            if (hi < base_ || lo - base_ > (int64_t)max_code)
+                return;
+
+            uint64_t first = std::max<int64_t>(lo - base_, 0);
+            uint64_t span = std::min<uint64_t>(hi - base_, max_code) - first;
+            for (auto i = 0LU; i < size_; ++i)
+                if (packed_[i] - first <= span)
+                    set_bit(words, i);
+            return;
+        }
+
+        case Delta:
+        {
+            int64_t value = first_;
+            for (auto i = 0LU; i < size_; ++i) {
+                if (i > 0)
+                    value += base_ + packed_[i - 1];
+                if (lo <= value && value <= hi)
+                    set_bit(words, i);
+            }
+            return;
+        }
+        }
+    }
+} // namespace memdb
@@ -0,0 +1,76 @@
+#ifndef HEADER_GUARD_DATABASE_COMPRESSED_COLUMN_H
+#define HEADER_GUARD_DATABASE_COMPRESSED_COLUMN_H
+
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+namespace memdb
+{
+    // Unsigned integers of one bit width packed into 64-bit words
+    class PackedInts
+    {
+    public:
+        PackedInts() = default;
+        PackedInts(const std::vector<uint64_t>& values, unsigned width);
+
+        uint64_t operator[] (size_t index) const;
+
+        unsigned width() const  { return width_; }
+        size_t bytes() const    { return words_.size() * sizeof(uint64_t); }
+
+    private:
+        unsigned                width_ = 0;
+        std::vector<uint64_t>   words_;
+    };
+
+    /*
+        Read-only compressed copy of the values of an INT32 column in a sealed
+        segment, one value per slot. The smallest of three encodings is used:
+
+            FrameOfReference    value - minimum, bit-packed
+            Delta               first value, then differences to the previous
+                                value, themselves frame-of-reference packed
+            RunLength           (value, end of run) for every run of equal values
+
+        select works on the encoded form: runs are tested once, packed values
+        are compared with the range shifted by the minimum, deltas are summed
+        as they are read.
+    */
+    class CompressedColumn
+    {
+    public:
+        enum Encoding
+        {
+            FrameOfReference,
+            Delta,
+            RunLength
+        };
+
+        CompressedColumn(const std::vector<int32_t>& values);
+
+        Encoding encoding() const   { return encoding_; }
+        size_t size() const         { return size_; }
+
+        // Memory taken by the encoded values
+        size_t bytes() const;
+
+        std::vector<int32_t> decode() const;
+
+        // Set bit i of words for every value i within [lo, hi]
+        void select(int64_t lo, int64_t hi, uint64_t* words) const;
+
+    private:
+        Encoding    encoding_;
+        size_t      size_;
+        int64_t     base_;      // minimum value or minimum difference
+        int32_t     first_;     // first value of Delta
+        PackedInts  packed_;
+
+        std::vector<std::pair<int32_t, uint32_t>>
+                    runs_;      // value and end of every run of RunLength
+    };
+} // namespace memdb
+
+#endif // HEADER_GUARD_DATABASE_COMPRESSED_COLUMN_H
@@ -0,0 +1,31 @@
+#include "database/cursor.hpp"
+
+namespace memdb
+{
+    Cursor::Cursor(std::shared_ptr<Table> table, const std::vector<std::string>& columns,
+        const Expression& where, std::shared_ptr<TransactionManager> manager,
+        uint64_t snapshot_ts)
+    : table_(std::move(table)), columns_(columns), where_(where.bind_condition(*table_)),
+      manager_(std::move(manager)), view_(*manager_, snapshot_ts),
+      segments_(table_->segments()), exhausted_(false)
+    {
+        for (auto& name : columns_)
+        {
+            bool found = false;
+            for (auto& column : table_->columns())
+                found = found || column.name_ == name;
+            if (!found)
+                throw UnexistingColumnException(name);
+        }
+    }
+
+    std::unique_ptr<Table> Cursor::fetch(size_t count, ResultPool* pool)
+    {
+        std::vector<const Row*> rows;
+        if (!exhausted_)
+            exhausted_ = !table_->scan(*segments_, view_.ts(), where_, position_, count, rows);
+
+        // the result registers the snapshot again, it may outlive the cursor
+        return table_->project(columns_, std::move(rows), segments_, view_.ts(), pool);
+    }
+} // namespace memdb
@@ -0,0 +1,61 @@
+#ifndef HEADER_GUARD_DATABASE_CURSOR_H
+#define HEADER_GUARD_DATABASE_CURSOR_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "database/table.hpp"
+#include "database/transaction_manager.hpp"
+#include "expression/expression.hpp"
+
+namespace memdb
+{
+    class ResultPool;
+
+    /*
+        Server-side cursor over the rows a SELECT matches, declared with
+        DECLARE and read a batch at a time with FETCH.
+
+        The cursor registers the snapshot it was declared at and holds the
+        segment list of that moment, then finds its rows while fetching:
+        every fetch resumes the scan where the previous one stopped and
+        returns a projection of the rows it found. An open cursor keeps no
+        rows of its own, so its memory follows the fetch size, not the size
+        of the result. Like every snapshot it holds back garbage collection
+        of the versions it can see until it is closed.
+    */
+    class Cursor
+    {
+    public:
+        // Cursor over columns of the rows of table that match where, visible
+        // at snapshot_ts of manager. Caller holds a ReadView of snapshot_ts
+        // until the constructor returns. Throws for unknown columns and type
+        // errors in where before any row is read
+        Cursor(std::shared_ptr<Table> table, const std::vector<std::string>& columns,
+            const Expression& where, std::shared_ptr<TransactionManager> manager,
+            uint64_t snapshot_ts);
+
+        Cursor(const Cursor& other)             = delete;
+        Cursor& operator= (const Cursor& other) = delete;
+
+        // Result table of the next count rows, fewer once the rows run out.
+        // The table comes from pool if given
+        std::unique_ptr<Table> fetch(size_t count, ResultPool* pool = nullptr);
+
+        // True once every row was fetched
+        bool exhausted() const { return exhausted_; }
+
+    private:
+        std::shared_ptr<Table>                  table_;
+        std::vector<std::string>                columns_;
+        Expression                              where_;     // bound to table_
+        std::shared_ptr<TransactionManager>     manager_;
+        TransactionManager::ReadView            view_;
+        std::shared_ptr<const SegmentList>      segments_;
+        Table::ScanPosition                     position_;
+        bool                                    exhausted_;
+    };
+} // namespace memdb
+
+#endif // HEADER_GUARD_DATABASE_CURSOR_H
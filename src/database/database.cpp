@@ -1,25 +1,59 @@
 #include "database/database.hpp"
-#include "parser/parse_exception.hpp"
+#include "storage/snapshot.hpp"
+#include "storage/codec.hpp"
+#include "expression/expression.hpp"
+
+#include <filesystem>
+#include <algorithm>
 
 namespace memdb
 {
+    Database::Database()
+    {
+        compactor_.start([this] { compact(); });
+    }
 
-    Result Database::execute(const std::string& query)
+    Database::Database(const DurabilityOptions& options)
+    : options_(options)
     {
-        Parser p(query);
-        Command c;
+        std::error_code error;
+        std::filesystem::create_directories(options_.directory_, error);
+        if (error)
+            throw WalException(options_.directory_, "cannot create directory: " + error.message());
 
-        try 
-        {
-            p.parse(c);
-        }
-        catch (ParseException& ex)
-        {
-            return Result(ex.what());
-        }
+        std::string snapshot_path = options_.directory_ + "/snapshot";
+        uint64_t snapshot_lsn = 0;
 
-        // this must be safe, try catch is inside
-        return c.execute(this);
+        if (std::filesystem::exists(snapshot_path))
+            for (auto& table : Snapshot::load(snapshot_path, snapshot_lsn)) {
+                table->attach(transactions_);
+                tables_[table->name()] = table;
+            }
+
+        // records are replayed with no log attached, so they are not logged again
+        auto wal = std::make_unique<WriteAheadLog>(options_.directory_ + "/wal",
+            options_.sync_policy_, options_.sync_interval_ms_);
+
+        // only statements that succeeded are logged, so every record applies
+        wal->recover(snapshot_lsn, [this] (const WalRecord& record) {
+            try {
+                apply(record);
+            }
+            catch (DatabaseException& ex) {
+                std::string reason = ex.what();
+                if (!reason.empty() && reason.back() == '\n')
+                    reason.pop_back();
+                throw WalException(options_.directory_ + "/wal", "cannot replay a record: " + reason);
+            }
+        });
+
+        wal_ = std::move(wal);
+        compactor_.start([this] { compact(); });
+    }
+
+    Result Database::execute(const std::string& query)
+    {
+        return default_session_.execute(query);
     }
 
     Result Database::execute(const char* query)
@@ -27,29 +61,309 @@ namespace memdb
         return execute(std::string(query));
     }
 
-    void Database::add_table(Table* table) 
+    uint64_t Database::add_table(Table* table) 
     {
+        std::shared_ptr<Table> owned(table);
         std::string name = table->name();
-        
+        table->attach(transactions_);
+
+        std::unique_lock<std::shared_mutex> lock(catalog_mutex_);
         if (tables_.find(name) != tables_.end())
             throw TableAlreadyExistException(name);
 
-        tables_[name] = std::shared_ptr<Table>(table);
+        uint64_t lsn = log(WalRecord::create_table(name, table->columns()));
+        tables_[name] = std::move(owned);
+        return lsn;
     }
 
-    Table* Database::get_table(const std::string& name)
+    std::shared_ptr<Table> Database::get_table(const std::string& name)
     {
-        if (tables_.find(name) == tables_.end())
+        std::shared_lock<std::shared_mutex> lock(catalog_mutex_);
+
+        auto it = tables_.find(name);
+        if (it == tables_.end())
             throw TableDoNotExistException(name);
 
-        return tables_.at(name).get();
+        return it->second;
     }
 
-    void Database::drop_table(const std::string& name)
+    uint64_t Database::drop_table(const std::string& name)
     {
-        if (tables_.find(name) == tables_.end())
+        std::unique_lock<std::shared_mutex> lock(catalog_mutex_);
+
+        auto it = tables_.find(name);
+        if (it == tables_.end())
             throw TableDoNotExistException(name);
 
-        tables_.erase(name);
+        uint64_t lsn = log(WalRecord::drop_table(name));
+        tables_.erase(it);
+        return lsn;
+    }
+
+    std::shared_ptr<TransactionManager> Database::transactions()
+    {
+        return transactions_;
+    }
+
+    std::vector<Table*> Database::CatalogView::pointers() const
+    {
+        std::vector<Table*> tables;
+        for (auto& table : tables_)
+            tables.push_back(table.get());
+        return tables;
+    }
+
+    Metrics& Database::metrics()
+    {
+        return metrics_;
+    }
+
+    MetricsSnapshot Database::metrics_snapshot()
+    {
+        MetricsSnapshot snapshot = metrics_.snapshot();
+
+        std::vector<std::shared_ptr<Table>> tables;
+        {
+            std::shared_lock<std::shared_mutex> lock(catalog_mutex_);
+            for (auto &[name, table] : tables_)
+                tables.push_back(table);
+        }
+        std::sort(tables.begin(), tables.end(),
+            [] (auto& lhs, auto& rhs) { return lhs->name() < rhs->name(); });
+
+        // one table locked at a time, writers of the others go on
+        for (auto& table : tables) {
+            auto lock = table->read_lock();
+            snapshot.tables_.push_back({table->name(), table->size(), table->bytes()});
+        }
+        return snapshot;
+    }
+
+    void Database::write_metrics(OutputBuffer& out)
+    {
+        write_prometheus(metrics_snapshot(), out);
+    }
+
+    SlowLog& Database::slow_log()
+    {
+        return slow_log_;
+    }
+
+    Database::CatalogView Database::read_catalog()
+    {
+        CatalogView view;
+        view.catalog_lock_ = std::shared_lock<std::shared_mutex>(catalog_mutex_);
+
+        for (auto &[name, table] : tables_)
+            view.tables_.push_back(table);
+
+        std::sort(view.tables_.begin(), view.tables_.end(),
+            [] (auto& lhs, auto& rhs) { return lhs->name() < rhs->name(); });
+
+        for (auto& table : view.tables_)
+            view.table_locks_.push_back(table->read_lock());
+
+        return view;
+    }
+
+    void Database::save(const std::string& path)
+    {
+        std::lock_guard<std::mutex> lock(snapshot_mutex_);
+        CatalogView view = read_catalog();
+        Snapshot::save(path, view.pointers());
+    }
+
+    void Database::background_save(const std::string& path)
+    {
+        std::lock_guard<std::mutex> lock(snapshot_mutex_);
+
+        // the child gets a copy of memory with all tables consistent,
+        // the locks are released in the parent as soon as fork returns
+        CatalogView view = read_catalog();
+        bgsave_.start(path, view.pointers(), wal_ ? wal_->last_lsn() : 0);
+    }
+
+    BackgroundSaveStatus Database::background_save_status()
+    {
+        std::lock_guard<std::mutex> lock(snapshot_mutex_);
+        return bgsave_.status();
+    }
+
+    void Database::load(const std::string& path)
+    {
+        // catalog is replaced only if the whole snapshot was read
+        std::unordered_map<std::string, std::shared_ptr<Table>> tables;
+        for (auto& table : Snapshot::load(path)) {
+            table->attach(transactions_);
+            tables[table->name()] = table;
+        }
+
+        {
+            std::unique_lock<std::shared_mutex> lock(catalog_mutex_);
+            tables_ = std::move(tables);
+        }
+
+        // loaded tables are not in the log, they become the new recovery point
+        checkpoint();
+    }
+
+    void Database::checkpoint()
+    {
+        if (!wal_)
+            return;
+
+        std::lock_guard<std::mutex> lock(snapshot_mutex_);
+        CatalogView view = read_catalog();
+        Snapshot::save(options_.directory_ + "/snapshot", view.pointers(), wal_->last_lsn());
+        wal_->reset();
+    }
+
+    size_t Database::compact()
+    {
+        std::vector<std::shared_ptr<Table>> tables;
+        {
+            std::shared_lock<std::shared_mutex> lock(catalog_mutex_);
+            for (auto &[name, table] : tables_)
+                tables.push_back(table);
+        }
+
+        size_t released = 0;
+        for (auto& table : tables) {
+            auto lock = table->write_lock();
+            released += table->compact();
+        }
+        return released;
+    }
+
+    uint64_t Database::log(const WalRecord& record)
+    {
+        if (!wal_)
+            return 0;
+        return wal_->append(record);
+    }
+
+    void Database::commit(uint64_t lsn)
+    {
+        if (wal_)
+            wal_->commit(lsn);
+    }
+
+    void Database::apply(const WalRecord& record)
+    {
+        Decoder in(record.payload_);
+
+        if (record.type_ == WalTransaction) {
+            apply_transaction(in);
+            return;
+        }
+
+        std::string name = in.get_string();
+
+        switch (record.type_)
+        {
+        case WalCreateTable:
+            add_table(new Table(name, in.get_columns()));
+            return;
+
+        case WalDropTable:
+            drop_table(name);
+            return;
+
+        default:
+            break;
+        }
+
+        auto table = get_table(name);
+        auto lock = table->write_lock();
+
+        switch (record.type_)
+        {
+        case WalInsert:
+            table->insert(in.get_cells());
+            return;
+
+        case WalInsertNamed:
+        {
+            std::unordered_map<std::string, Cell> data;
+            for (auto i = in.get<uint32_t>(); i > 0; --i) {
+                std::string column = in.get_string();
+                data[column] = in.get_cell();
+            }
+            table->insert(data);
+            return;
+        }
+
+        case WalUpdate:
+        {
+            std::unordered_map<std::string, Expression> set;
+            for (auto i = in.get<uint32_t>(); i > 0; --i) {
+                std::string column = in.get_string();
+                set[column] = Expression::decode(in);
+            }
+            Expression where = Expression::decode(in);
+            table->update(set, where);
+            return;
+        }
+
+        case WalDelete:
+            table->drop(Expression::decode(in));
+            return;
+
+        default:
+            throw CorruptedRecordException();
+        }
+    }
+
+    void Database::apply_transaction(Decoder& in)
+    {
+        struct Changes
+        {
+            std::shared_ptr<Table>      table_;
+            std::vector<RowVersion*>    ended_;
+            std::vector<Row>            inserted_;
+        };
+        std::vector<Changes> changes;
+
+        for (auto t = in.get<uint32_t>(); t > 0; --t)
+        {
+            std::string name = in.get_string();
+
+            std::vector<RowId> removed(in.get<uint32_t>());
+            for (auto& id : removed)
+                id = in.get<uint64_t>();
+
+            std::vector<std::pair<RowId, std::vector<Cell>>> inserted(in.get<uint32_t>());
+            for (auto &[id, cells] : inserted) {
+                id = in.get<uint64_t>();
+                cells = in.get_cells();
+            }
+
+            Changes table;
+            try {
+                table.table_ = get_table(name);
+            }
+            catch (TableDoNotExistException&) {
+                continue; // the table was dropped while the transaction ran
+            }
+
+            // recovery runs alone, live versions are exactly the current rows
+            table.ended_ = table.table_->live_versions(removed);
+            if (std::find(table.ended_.begin(), table.ended_.end(), nullptr) != table.ended_.end())
+                throw CorruptedRecordException();
+
+            for (auto &[id, cells] : inserted) {
+                table.table_->check_row(cells);
+                table.inserted_.emplace_back(table.table_.get(), std::move(cells));
+                table.inserted_.back().set_id(id);
+            }
+
+            changes.push_back(std::move(table));
+        }
+
+        TransactionManager::WriteStamp stamp(*transactions_);
+        UndoLog undo;
+        for (auto& table : changes)
+            table.table_->apply(table.ended_, std::move(table.inserted_), stamp.ts(), undo);
+        undo.release();
     }
-} // namespace memdb
\ No newline at end of file
+} // namespace memdb
@@ -1,32 +1,160 @@
 #ifndef HEADER_GUARD_DATABASE_DATABASE_H
 #define HEADER_GUARD_DATABASE_DATABASE_H
 
+#include <memory>
+#include <shared_mutex>
+#include <mutex>
+
 #include "database/table.hpp"
 #include "command/command.hpp"
+#include "storage/wal.hpp"
+#include "storage/background_save.hpp"
+#include "database/session.hpp"
+#include "database/compactor.hpp"
+#include "database/metrics.hpp"
+#include "database/slow_log.hpp"
 
 namespace memdb
 {
+    class Decoder;
+
+    // Where and how a durable database keeps its data between runs
+    struct DurabilityOptions
+    {
+        std::string directory_;                     // holds "snapshot" and "wal" files
+        SyncPolicy  sync_policy_ = SyncEveryCommit;
+        unsigned    sync_interval_ms_ = 100;        // period of SyncInterval
+    };
+
+    /*
+        Catalog of tables, safe to use from many threads.
+
+        The catalog has its own reader/writer lock, separate from the locks of
+        the tables, so looking a table up never waits for queries on it.
+        Tables are handed out as shared pointers: a dropped table leaves the
+        catalog at once but lives on while a command or a Result still uses it.
+        All tables take row version timestamps from one TransactionManager.
+
+        Every mutating command appends its log record under the lock it needs
+        to apply the change (the catalog lock for CREATE and DROP, the table
+        write lock for the rest). A snapshot taken under all those locks therefore
+        contains the effect of every record up to the log's last lsn.
+    */
     class Database
     {
     public:
-        Database() = default;
+        // In-memory database
+        Database();
 
+        // Durable database: recover from the latest snapshot and log in options.directory_,
+        // then log every mutating command
+        Database(const DurabilityOptions& options);
+
+        // Run query in the default session, shared by every caller of execute
         Result execute(const std::string& query);
         Result execute(const char* query);
 
-        void 
+        // Log creation of the table and add it to the catalog, return lsn of the record
+        uint64_t
         add_table(Table* table);
 
-        Table*
+        std::shared_ptr<Table>
         get_table(const std::string& table_name);
 
-        void
+        // Log removal of the table and remove it from the catalog, return lsn of the record
+        uint64_t
         drop_table(const std::string& table_name);
 
-        // TODO: add 'Result execute(string)' method
+        // Timestamps of row versions of all tables
+        std::shared_ptr<TransactionManager>
+        transactions();
+
+        // Write all tables to a binary snapshot
+        void
+        save(const std::string& path);
+
+        // Replace all tables with the contents of a snapshot
+        void
+        load(const std::string& path);
+
+        // Start writing a snapshot from a forked child, return without waiting for it
+        void
+        background_save(const std::string& path);
+
+        // Progress of the running background save or outcome of the last one
+        BackgroundSaveStatus
+        background_save_status();
+
+        // Write the recovery snapshot and start an empty log. No-op for in-memory database
+        void
+        checkpoint();
+
+        // Compact the segments of every table, return number of segments released.
+        // Also runs in the background every COMPACTION_INTERVAL_MS
+        size_t
+        compact();
+
+        // Append record of a mutating command to the log, return its lsn.
+        // Commands log before they apply, under the lock of the table they change,
+        // so a record is replayed with the same outcome
+        uint64_t
+        log(const WalRecord& record);
+
+        // Wait until the record is durable according to the sync policy
+        void
+        commit(uint64_t lsn);
+
+        // Statements run on the database, updated by Session and Command
+        Metrics&
+        metrics();
+
+        // Metrics summed over threads, with the rows and memory of every table
+        MetricsSnapshot
+        metrics_snapshot();
+
+        // metrics_snapshot() in the Prometheus text format, for scrapers
+        void
+        write_metrics(OutputBuffer& out);
+
+        // Statements slower than its threshold, see SlowLog::configure
+        SlowLog&
+        slow_log();
+
     private:
+        // Tables sorted by name, each one read-locked, and the catalog read-locked.
+        // Nothing can change until the view is destroyed
+        struct CatalogView
+        {
+            std::shared_lock<std::shared_mutex>                 catalog_lock_;
+            std::vector<std::shared_ptr<Table>>                 tables_;
+            std::vector<std::shared_lock<std::shared_mutex>>    table_locks_;
+
+            std::vector<Table*> pointers() const;
+        };
+
+        CatalogView read_catalog();
+
+        // Replay one logged command
+        void apply(const WalRecord& record);
+        void apply_transaction(Decoder& in);
+
         std::unordered_map<std::string, std::shared_ptr<Table>>
             tables_;
+        std::shared_mutex               catalog_mutex_;     // guards tables_
+
+        std::shared_ptr<TransactionManager>
+                                        transactions_ = std::make_shared<TransactionManager>();
+
+        DurabilityOptions               options_;
+        std::unique_ptr<WriteAheadLog>  wal_;       // null for in-memory database and during recovery
+
+        std::mutex                      snapshot_mutex_;    // one snapshot is written at a time
+        BackgroundSave                  bgsave_;
+        Compactor                       compactor_;     // stopped before the tables go
+        Metrics                         metrics_;
+        SlowLog                         slow_log_;
+
+        Session                         default_session_{*this};    // destroyed first
     };
 } // namespace memdb
 
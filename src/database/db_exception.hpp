@@ -1,7 +1,9 @@
 #ifndef HEADER_GUARD_DB_EXCEPTIONS_H
 #define HEADER_GUARD_DB_EXCEPTIONS_H
 
+#include <cstdint>
 #include <exception>
+#include <string>
 
 namespace memdb
 {
@@ -29,30 +31,28 @@ namespace memdb
 
     class TableAlreadyExistException : public DatabaseException
     {
-        const std::string table_name_;
+        const std::string what_;
     public:
         TableAlreadyExistException(const std::string& table_name)
-        : table_name_(table_name) {}
+        : what_("Table named \"" + table_name + "\" already exist.\n") {}
 
         ~TableAlreadyExistException() = default;
 
         const char* what() const throw() {
-            auto what_ = "Table named \"" + table_name_ + "\" already exist.\n";
             return what_.c_str(); 
         }
     };
 
     class TableDoNotExistException : public DatabaseException
     {
-        const std::string table_name_;
+        const std::string what_;
     public:
         TableDoNotExistException(const std::string& table_name)
-        : table_name_(table_name) {}
+        : what_("Table named \"" + table_name + "\" do not exist.\n") {}
 
         ~TableDoNotExistException() = default;
 
         const char* what() const throw() {
-            auto what_ = "Table named \"" + table_name_ + "\" do not exist.\n";
             return what_.c_str(); 
         }
     };
@@ -70,16 +70,14 @@ namespace memdb
     public:
         IncompatibleTypeOperatorException(
             std::string op, std::string type) :
-        op_(op), type_(type) {}
+        what_("Type " + type + " is incompatible with operator " + op + '\n') {}
 
         const char* what() const throw() {
-            std::string what_ = "Type " + type_ + " is incompatible with operator " + op_ + '\n';
             return what_.c_str(); 
         }
 
     private:
-        std::string op_;
-        std::string type_;
+        std::string what_;
     };
 
 
@@ -87,30 +85,28 @@ namespace memdb
     {
     public:
         DifferentTypesException(
-            std::string op) : op_(op ) { }
+            std::string op) : what_("Operator " + op + " do not maintain different types\n") { }
 
         const char* what() const throw() {
-            std::string what_ = "Operator " + op_ + " do not maintain different types\n";
             return what_.c_str(); 
         }
 
     private:
-        std::string op_;
+        std::string what_;
     };
 
     class DifferentSizeException: public DatabaseException
     {
     public:
         DifferentSizeException(
-            std::string op) : op_(op ) { }
+            std::string op) : what_("Operator " + op + " do not maintain different size of operands\n") { }
 
         const char* what() const throw() {
-            std::string what_ = "Operator " + op_ + " do not maintain different size of operands\n";
             return what_.c_str(); 
         }
 
     private:
-        std::string op_;
+        std::string what_;
     };
 
 
@@ -126,29 +122,27 @@ namespace memdb
     {
     public:
         UnexistingColumnException(
-            std::string name) : name_(name) { }
+            std::string name) : what_("Requested column " + name + " does not exist\n") { }
 
         const char* what() const throw() {
-            std::string what_ = "Requested column " + name_ + " does not exist\n";
             return what_.c_str(); 
         }
     private:
-        std::string name_;
+        std::string what_;
     };
 
     class InvaludNumberOfOperandsException: public DatabaseException
     {
     public:
         InvaludNumberOfOperandsException(
-            std::string op) : op_(op ) { }
+            std::string op) : what_("Invalud number of operands provided to operator " + op + "\n") { }
 
         const char* what() const throw() {
-            std::string what_ = "Invalud number of operands provided to operator " + op_ + "\n";
             return what_.c_str(); 
         }
 
     private:
-        std::string op_;
+        std::string what_;
     };
 
 
@@ -168,6 +162,171 @@ namespace memdb
         }
     };
 
+    class SnapshotException: public DatabaseException
+    {
+    public:
+        SnapshotException(
+            std::string path, std::string reason) 
+        : what_("Snapshot \"" + path + "\": " + reason + "\n") { }
+
+        const char* what() const throw() {
+            return what_.c_str(); 
+        }
+
+    private:
+        std::string what_;
+    };
+
+    class WalException: public DatabaseException
+    {
+    public:
+        WalException(
+            std::string path, std::string reason) 
+        : what_("Write-ahead log \"" + path + "\": " + reason + "\n") { }
+
+        const char* what() const throw() {
+            return what_.c_str(); 
+        }
+
+    private:
+        std::string what_;
+    };
+
+    class CorruptedRecordException: public DatabaseException
+    {
+    public:
+        const char* what() const throw() {
+            return "Corrupted or truncated binary record\n"; 
+        }
+    };
+
+    class TransactionConflictException: public DatabaseException
+    {
+    public:
+        TransactionConflictException(std::string table)
+        : what_("Transaction aborted: rows of table \"" + table + "\" were changed concurrently\n") { }
+
+        const char* what() const throw() {
+            return what_.c_str(); 
+        }
+
+    private:
+        std::string what_;
+    };
+
+    class TransactionStateException: public DatabaseException
+    {
+    public:
+        TransactionStateException(std::string reason)
+        : what_("Transaction: " + reason + "\n") { }
+
+        const char* what() const throw() {
+            return what_.c_str(); 
+        }
+
+    private:
+        std::string what_;
+    };
+
+    class UnboundParameterException: public DatabaseException
+    {
+    public:
+        UnboundParameterException(size_t number)
+        : what_("Parameter $" + std::to_string(number) + " has no value\n") { }
+
+        const char* what() const throw() {
+            return what_.c_str(); 
+        }
+
+    private:
+        std::string what_;
+    };
+
+    class UnknownStatementException: public DatabaseException
+    {
+    public:
+        UnknownStatementException(uint32_t statement)
+        : what_("Prepared statement " + std::to_string(statement) + " does not exist\n") { }
+
+        const char* what() const throw() {
+            return what_.c_str(); 
+        }
+
+    private:
+        std::string what_;
+    };
+
+    class CursorException: public DatabaseException
+    {
+    public:
+        CursorException(std::string reason)
+        : what_("Cursor: " + reason + "\n") { }
+
+        const char* what() const throw() {
+            return what_.c_str(); 
+        }
+
+    private:
+        std::string what_;
+    };
+
+    class ServerException: public DatabaseException
+    {
+    public:
+        ServerException(std::string reason)
+        : what_("Server: " + reason + "\n") { }
+
+        const char* what() const throw() {
+            return what_.c_str(); 
+        }
+
+    private:
+        std::string what_;
+    };
+
+    class ClientException: public DatabaseException
+    {
+    public:
+        ClientException(std::string reason)
+        : what_("Client: " + reason + "\n") { }
+
+        const char* what() const throw() {
+            return what_.c_str(); 
+        }
+
+    private:
+        std::string what_;
+    };
+
+    class SlowLogException: public DatabaseException
+    {
+    public:
+        SlowLogException(
+            std::string path, std::string reason) 
+        : what_("Slow query log \"" + path + "\": " + reason + "\n") { }
+
+        const char* what() const throw() {
+            return what_.c_str(); 
+        }
+
+    private:
+        std::string what_;
+    };
+
+    class StatementInTransactionException: public DatabaseException
+    {
+    public:
+        StatementInTransactionException(std::string statement)
+        : what_(statement + " is not allowed inside a transaction\n") { }
+
+        const char* what() const throw() {
+            return what_.c_str(); 
+        }
+
+    private:
+        std::string what_;
+    };
+
 } // namespace memdb 
 
 #endif // HEADER_GUARD_DB_EXCEPTIONS_H
\ No newline at end of file
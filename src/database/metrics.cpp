@@ -0,0 +1,325 @@
+#include "database/metrics.hpp"
+#include "database/table.hpp"
+#include "command/output.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cmath>
+
+namespace memdb
+{
+    const char* command_name(CommandType type)
+    {
+        static const char* names[CommandTypeCount] = {
+            "create_table", "insert", "update", "select", "delete", "join",
+            "create_index", "save", "load", "drop_table", "bgsave", "bgsave_status",
+            "begin", "commit", "rollback", "declare", "fetch", "close",
+            "explain", "explain_analyze"
+        };
+        return type < CommandTypeCount ? names[type] : "unknown";
+    }
+
+    //
+    // Histograms
+    //
+
+    size_t LatencyHistogram::bucket(uint64_t ns)
+    {
+        if (ns < HISTOGRAM_SUB_BUCKETS)
+            return ns;
+
+        // the top bits below the leading one pick the sub-bucket
+        size_t exponent = std::bit_width(ns) - 1;
+        if (exponent >= HISTOGRAM_MAX_EXPONENT)
+            return HISTOGRAM_BUCKETS - 1;
+        size_t shift = exponent - std::countr_zero(HISTOGRAM_SUB_BUCKETS);
+        return (exponent - 2) * HISTOGRAM_SUB_BUCKETS + ((ns >> shift) & (HISTOGRAM_SUB_BUCKETS - 1));
+    }
+
+    uint64_t LatencyHistogram::upper_bound(size_t bucket)
+    {
+        if (bucket < HISTOGRAM_SUB_BUCKETS)
+            return bucket;
+
+        size_t exponent = bucket / HISTOGRAM_SUB_BUCKETS + 2;
+        size_t shift = exponent - std::countr_zero(HISTOGRAM_SUB_BUCKETS);
+        uint64_t lower = uint64_t(HISTOGRAM_SUB_BUCKETS + bucket % HISTOGRAM_SUB_BUCKETS) << shift;
+        return lower + (uint64_t(1) << shift) - 1;
+    }
+
+    void LatencyHistogram::record(uint64_t ns)
+    {
+        buckets_[bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+        sum_ns_.fetch_add(ns, std::memory_order_relaxed);
+    }
+
+    void HistogramSnapshot::add(const LatencyHistogram& histogram)
+    {
+        for (auto i = 0LU; i < HISTOGRAM_BUCKETS; ++i) {
+            uint64_t count = histogram.buckets_[i].load(std::memory_order_relaxed);
+            buckets_[i] += count;
+            count_ += count;
+        }
+        sum_ns_ += histogram.sum_ns_.load(std::memory_order_relaxed);
+    }
+
+    uint64_t HistogramSnapshot::quantile(double q) const
+    {
+        if (count_ == 0)
+            return 0;
+
+        uint64_t rank = std::max<uint64_t>(1, uint64_t(std::ceil(q * count_)));
+        uint64_t seen = 0;
+        for (auto i = 0LU; i < HISTOGRAM_BUCKETS; ++i) {
+            seen += buckets_[i];
+            if (seen >= rank)
+                return LatencyHistogram::upper_bound(i);
+        }
+        return LatencyHistogram::upper_bound(HISTOGRAM_BUCKETS - 1);
+    }
+
+    //
+    // Metrics
+    //
+
+    Metrics::Metrics()
+    : shards_(std::make_unique<std::array<Shard, METRICS_SHARDS>>())
+    { }
+
+    Metrics::~Metrics() = default;
+
+    Metrics::Shard& Metrics::shard()
+    {
+        // threads take the shards in turn, once
+        static std::atomic<unsigned> next_thread{0};
+        thread_local unsigned index = next_thread.fetch_add(1, std::memory_order_relaxed) % METRICS_SHARDS;
+        return (*shards_)[index];
+    }
+
+    void Metrics::parsed(CommandType type, uint64_t ns)
+    {
+        if (type < CommandTypeCount)
+            shard().commands_[type].parse_.record(ns);
+    }
+
+    void Metrics::parse_failed()
+    {
+        shard().parse_errors_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void Metrics::executed(CommandType type, uint64_t ns, bool ok, size_t rows_scanned, size_t rows_returned)
+    {
+        if (type >= CommandTypeCount)
+            return;
+
+        CommandCounters& counters = shard().commands_[type];
+        counters.executed_.fetch_add(1, std::memory_order_relaxed);
+        if (!ok)
+            counters.failed_.fetch_add(1, std::memory_order_relaxed);
+        counters.rows_scanned_.fetch_add(rows_scanned, std::memory_order_relaxed);
+        counters.rows_returned_.fetch_add(rows_returned, std::memory_order_relaxed);
+        counters.execute_.record(ns);
+    }
+
+    MetricsSnapshot Metrics::snapshot() const
+    {
+        MetricsSnapshot res;
+        for (const Shard& shard : *shards_)
+        {
+            for (auto t = 0LU; t < CommandTypeCount; ++t) {
+                const CommandCounters& counters = shard.commands_[t];
+                CommandSnapshot& command = res.commands_[t];
+                command.executed_ += counters.executed_.load(std::memory_order_relaxed);
+                command.failed_ += counters.failed_.load(std::memory_order_relaxed);
+                command.rows_scanned_ += counters.rows_scanned_.load(std::memory_order_relaxed);
+                command.rows_returned_ += counters.rows_returned_.load(std::memory_order_relaxed);
+                command.parse_.add(counters.parse_);
+                command.execute_.add(counters.execute_);
+            }
+            res.parse_errors_ += shard.parse_errors_.load(std::memory_order_relaxed);
+        }
+        return res;
+    }
+
+    //
+    // Output
+    //
+
+    static bool ran(const CommandSnapshot& command)
+    {
+        return command.executed_ != 0 || command.parse_.count_ != 0;
+    }
+
+    std::unique_ptr<Table> command_stats_table(const MetricsSnapshot& metrics)
+    {
+        auto table = std::make_unique<Table>("", std::vector<Column>{
+            Column(CellType::STRING, "command", 0),
+            Column(CellType::INT32, "executed", 0),
+            Column(CellType::INT32, "failed", 0),
+            Column(CellType::INT32, "parse_p50_us", 0),
+            Column(CellType::INT32, "exec_p50_us", 0),
+            Column(CellType::INT32, "exec_p99_us", 0),
+            Column(CellType::INT32, "exec_max_us", 0),
+            Column(CellType::INT32, "rows_scanned", 0),
+            Column(CellType::INT32, "rows_returned", 0)
+        });
+
+        for (auto t = 0LU; t < CommandTypeCount; ++t)
+        {
+            const CommandSnapshot& command = metrics.commands_[t];
+            if (!ran(command))
+                continue;
+
+            table->insert(std::vector<Cell>{
+                Cell(std::string(command_name(CommandType(t)))),
+                clipped_int(command.executed_),
+                clipped_int(command.failed_),
+                clipped_int(command.parse_.quantile(0.5) / 1000),
+                clipped_int(command.execute_.quantile(0.5) / 1000),
+                clipped_int(command.execute_.quantile(0.99) / 1000),
+                clipped_int(command.execute_.quantile(1.0) / 1000),
+                clipped_int(command.rows_scanned_),
+                clipped_int(command.rows_returned_)
+            });
+        }
+        return table;
+    }
+
+    std::unique_ptr<Table> table_stats_table(const MetricsSnapshot& metrics)
+    {
+        auto table = std::make_unique<Table>("", std::vector<Column>{
+            Column(CellType::STRING, "table", 0),
+            Column(CellType::INT32, "rows", 0),
+            Column(CellType::INT32, "bytes", 0)
+        });
+
+        for (auto& usage : metrics.tables_)
+            table->insert(std::vector<Cell>{
+                Cell(usage.name_.substr(0, MAX_STRING_DATA)),
+                clipped_int(usage.rows_),
+                clipped_int(usage.bytes_)
+            });
+        return table;
+    }
+
+    static void append_seconds(uint64_t ns, OutputBuffer& out)
+    {
+        char digits[32];
+        auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), double(ns) / 1e9);
+        out.append(std::string_view(digits, end - digits));
+    }
+
+    static void append_header(std::string_view name, std::string_view help, std::string_view type,
+        OutputBuffer& out)
+    {
+        out.append("# HELP ");
+        out.append(name);
+        out.put(' ');
+        out.append(help);
+        out.append("\n# TYPE ");
+        out.append(name);
+        out.put(' ');
+        out.append(type);
+        out.put('\n');
+    }
+
+    // name{labels} and a space, the value is appended by the caller
+    static void append_sample(std::string_view name, std::string_view labels, OutputBuffer& out)
+    {
+        out.append(name);
+        if (!labels.empty()) {
+            out.put('{');
+            out.append(labels);
+            out.put('}');
+        }
+        out.put(' ');
+    }
+
+    static std::string command_label(size_t type)
+    {
+        return std::string("command=\"") + command_name(CommandType(type)) + "\"";
+    }
+
+    static void append_counter(const MetricsSnapshot& metrics, std::string_view name,
+        std::string_view help, uint64_t CommandSnapshot::* field, OutputBuffer& out)
+    {
+        append_header(name, help, "counter", out);
+        for (auto t = 0LU; t < CommandTypeCount; ++t)
+        {
+            const CommandSnapshot& command = metrics.commands_[t];
+            if (!ran(command))
+                continue;
+            append_sample(name, command_label(t), out);
+            out.append_int(command.*field);
+            out.put('\n');
+        }
+    }
+
+    static void append_summary(const MetricsSnapshot& metrics, std::string_view name,
+        std::string_view help, HistogramSnapshot CommandSnapshot::* field, OutputBuffer& out)
+    {
+        static const std::pair<const char*, double> quantiles[] = {
+            {"0.5", 0.5}, {"0.9", 0.9}, {"0.99", 0.99}, {"0.999", 0.999}};
+
+        std::string sum_name = std::string(name) + "_sum";
+        std::string count_name = std::string(name) + "_count";
+
+        append_header(name, help, "summary", out);
+        for (auto t = 0LU; t < CommandTypeCount; ++t)
+        {
+            const HistogramSnapshot& histogram = metrics.commands_[t].*field;
+            if (histogram.count_ == 0)
+                continue;
+
+            std::string label = command_label(t);
+            for (auto &[text, q] : quantiles) {
+                append_sample(name, label + ",quantile=\"" + text + "\"", out);
+                append_seconds(histogram.quantile(q), out);
+                out.put('\n');
+            }
+            append_sample(sum_name, label, out);
+            append_seconds(histogram.sum_ns_, out);
+            out.put('\n');
+            append_sample(count_name, label, out);
+            out.append_int(histogram.count_);
+            out.put('\n');
+        }
+    }
+
+    static void append_gauge(const MetricsSnapshot& metrics, std::string_view name,
+        std::string_view help, size_t TableUsage::* field, OutputBuffer& out)
+    {
+        append_header(name, help, "gauge", out);
+        for (auto& usage : metrics.tables_) {
+            append_sample(name, "table=\"" + usage.name_ + "\"", out);
+            out.append_int(usage.*field);
+            out.put('\n');
+        }
+    }
+
+    void write_prometheus(const MetricsSnapshot& metrics, OutputBuffer& out)
+    {
+        append_counter(metrics, "memdb_statements_total",
+            "Statements executed, by type", &CommandSnapshot::executed_, out);
+        append_counter(metrics, "memdb_statement_errors_total",
+            "Statements that returned an error, by type", &CommandSnapshot::failed_, out);
+        append_counter(metrics, "memdb_rows_scanned_total",
+            "Row versions read by table scans, by type of statement", &CommandSnapshot::rows_scanned_, out);
+        append_counter(metrics, "memdb_rows_returned_total",
+            "Rows of result sets, by type of statement", &CommandSnapshot::rows_returned_, out);
+
+        append_header("memdb_parse_errors_total", "Queries that did not parse", "counter", out);
+        append_sample("memdb_parse_errors_total", "", out);
+        out.append_int(metrics.parse_errors_);
+        out.put('\n');
+
+        append_summary(metrics, "memdb_parse_duration_seconds",
+            "Time to parse a query, by type of statement", &CommandSnapshot::parse_, out);
+        append_summary(metrics, "memdb_execute_duration_seconds",
+            "Time to execute a statement, by type", &CommandSnapshot::execute_, out);
+
+        append_gauge(metrics, "memdb_table_rows", "Live rows of a table", &TableUsage::rows_, out);
+        append_gauge(metrics, "memdb_table_bytes", "Memory taken by a table, an estimate", &TableUsage::bytes_, out);
+    }
+} // namespace memdb
@@ -0,0 +1,159 @@
+#ifndef HEADER_GUARD_DATABASE_METRICS_H
+#define HEADER_GUARD_DATABASE_METRICS_H
+
+#include <array>
+#include <memory>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "parser/parser.hpp"
+
+// Threads update one of this many shards of the metrics
+#define METRICS_SHARDS 8U
+
+// Buckets per power of two of a latency histogram, 8 keeps values within 12.5%
+#define HISTOGRAM_SUB_BUCKETS 8U
+
+// Latencies up to 2^HISTOGRAM_MAX_EXPONENT ns (about 18 minutes), longer ones count as that
+#define HISTOGRAM_MAX_EXPONENT 40U
+
+#define HISTOGRAM_BUCKETS ((HISTOGRAM_MAX_EXPONENT - 2U) * HISTOGRAM_SUB_BUCKETS)
+
+namespace memdb
+{
+    class Table;
+    class OutputBuffer;
+
+    // Lower case name of the statement in metrics, e.g. "create_table"
+    const char* command_name(CommandType type);
+
+    /*
+        Latency histogram with buckets of logarithmic width, in the manner
+        of HdrHistogram: values below HISTOGRAM_SUB_BUCKETS have a bucket
+        each, every power of two above is split into HISTOGRAM_SUB_BUCKETS
+        buckets. Recording is one relaxed increment.
+    */
+    class LatencyHistogram
+    {
+    public:
+        void record(uint64_t ns);
+
+        // Bucket of a latency, and the largest latency of a bucket
+        static size_t bucket(uint64_t ns);
+        static uint64_t upper_bound(size_t bucket);
+
+    private:
+        friend struct HistogramSnapshot;
+
+        std::array<std::atomic<uint64_t>, HISTOGRAM_BUCKETS>
+                                buckets_{};
+        std::atomic<uint64_t>   sum_ns_{0};
+    };
+
+    // Histogram merged from the shards at one point in time
+    struct HistogramSnapshot
+    {
+        std::array<uint64_t, HISTOGRAM_BUCKETS> buckets_{};
+        uint64_t    count_ = 0;
+        uint64_t    sum_ns_ = 0;
+
+        void add(const LatencyHistogram& histogram);
+
+        // Upper bound of the bucket holding the q-th quantile, 0 if empty
+        uint64_t quantile(double q) const;
+    };
+
+    // Counters of one type of statement in one shard
+    struct CommandCounters
+    {
+        std::atomic<uint64_t>   executed_{0};
+        std::atomic<uint64_t>   failed_{0};
+        std::atomic<uint64_t>   rows_scanned_{0};
+        std::atomic<uint64_t>   rows_returned_{0};
+        LatencyHistogram        parse_;
+        LatencyHistogram        execute_;
+    };
+
+    // Counters of one type of statement summed over the shards
+    struct CommandSnapshot
+    {
+        uint64_t            executed_ = 0;
+        uint64_t            failed_ = 0;
+        uint64_t            rows_scanned_ = 0;     // row versions read by table scans
+        uint64_t            rows_returned_ = 0;    // rows of result sets
+        HistogramSnapshot   parse_;
+        HistogramSnapshot   execute_;
+    };
+
+    // Rows and memory of a table of the catalog
+    struct TableUsage
+    {
+        std::string name_;
+        size_t      rows_;
+        size_t      bytes_;
+    };
+
+    struct MetricsSnapshot
+    {
+        std::array<CommandSnapshot, CommandTypeCount>
+                                commands_;
+        uint64_t                parse_errors_ = 0;
+        std::vector<TableUsage> tables_;
+    };
+
+    /*
+        Counters and latency histograms of the statements run on a database,
+        by type of statement. Parsing is timed apart from execution.
+
+        Every thread updates a shard of its own (threads beyond
+        METRICS_SHARDS share them) with relaxed atomic increments, so
+        sessions on different threads do not contend on counters.
+        A snapshot sums the shards; it is not atomic as a whole.
+    */
+    class Metrics
+    {
+    public:
+        Metrics();
+        ~Metrics();
+
+        Metrics(const Metrics& other)               = delete;
+        Metrics& operator= (const Metrics& other)   = delete;
+
+        void parsed(CommandType type, uint64_t ns);
+        void parse_failed();
+        void executed(CommandType type, uint64_t ns, bool ok, size_t rows_scanned, size_t rows_returned);
+
+        // Shards summed, without tables_
+        MetricsSnapshot snapshot() const;
+
+    private:
+        struct alignas(64) Shard
+        {
+            std::array<CommandCounters, CommandTypeCount>
+                                    commands_;
+            std::atomic<uint64_t>   parse_errors_{0};
+        };
+
+        Shard& shard();
+
+        std::unique_ptr<std::array<Shard, METRICS_SHARDS>>
+            shards_;
+    };
+
+    // Table of the statements run so far: counts, latency quantiles in
+    // microseconds and rows, one row per type of statement that ran
+    std::unique_ptr<Table> command_stats_table(const MetricsSnapshot& metrics);
+
+    // Table of the rows and memory of every table of the catalog
+    std::unique_ptr<Table> table_stats_table(const MetricsSnapshot& metrics);
+
+    // Metrics in the Prometheus text exposition format: counters of
+    // statements and rows, latencies as summaries in seconds and the
+    // rows and bytes of every table as gauges
+    void write_prometheus(const MetricsSnapshot& metrics, OutputBuffer& out);
+} // namespace memdb
+
+#endif // HEADER_GUARD_DATABASE_METRICS_H
@@ -4,17 +4,20 @@
 namespace memdb
 {
     Row::Row(Table* table, const std::vector<Cell>& data) :
-        table_(table), data_(data)
+        table_(table), data_(data), id_(0)
     { }
 
     Row::Row(Table* table, std::vector<Cell>&& data) :
-        table_(table), data_(data)
+        table_(table), data_(std::move(data)), id_(0)
     { }
 
     Row::Row(Table* table, const std::unordered_map<std::string, Cell>& data) :
-        table_(table)
+        table_(table), id_(0)
     {
-        data_.resize(table->width());
+        // omitted columns get default values of their type
+        for (auto &column : table->columns())
+            data_.push_back(column.default_value());
+
         for (auto &[name, cell]: data) {
             data_[table->column_position(name)] = cell;
         }
@@ -33,4 +36,12 @@ namespace memdb
     {
         return table_;
     }
+
+    void hash_column(const std::vector<const Row*>& rows, size_t position,
+        std::vector<size_t>& hashes)
+    {
+        hashes.resize(rows.size());
+        for (auto i = 0LU; i < rows.size(); ++i)
+            hashes[i] = (*rows[i])[position].hash();
+    }
 } // namespace memdb
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define HEADER_GUARD_DATABASE_ROW_H
 
 #include <vector>
+#include <cstdint>
 #include <string>
 #include <unordered_map>
 
@@ -11,6 +12,10 @@ namespace memdb
 {
     class Table;
 
+    // Identity of a row within its table. Assigned on insert, kept by updates
+    // and never reused; 0 means not assigned yet
+    typedef uint64_t RowId;
+
     class Row
     {
     public:
@@ -28,6 +33,9 @@ namespace memdb
         Row(Table* table, std::unordered_map<std::string, Cell> const &data);
 
         size_t size() const { return data_.size(); }
+        RowId id() const { return id_; }
+        void set_id(RowId id) { id_ = id; }
+        const std::vector<Cell>& cells() const { return data_; }
 
         Cell& operator[] (size_t index);
         const Cell& operator[] (size_t index) const;
@@ -36,7 +44,14 @@ namespace memdb
     private:
         Table* table_;
         std::vector<Cell> data_;
+        RowId id_;
     };
+
+    // Hash of the cell at position in every row, hashes[i] for rows[i].
+    // The batch primitive for hash tables over a column: joins, grouping,
+    // distinct values and hash indexes
+    void hash_column(const std::vector<const Row*>& rows, size_t position,
+        std::vector<size_t>& hashes);
 } // namespace memdb
 
 #endif // HEADER_GUARD_DATABASE_ROW_H
\ No newline at end of file
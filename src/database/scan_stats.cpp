@@ -0,0 +1,43 @@
+#include "database/scan_stats.hpp"
+
+namespace memdb
+{
+    static thread_local ScanStats* current_stats = nullptr;
+
+    ScanStats* ScanStats::current()
+    {
+        return current_stats;
+    }
+
+    void ScanStats::add_matched(size_t rows, size_t bytes)
+    {
+        if (ScanStats* stats = current_stats) {
+            stats->rows_matched_ += rows;
+            stats->bytes_ += bytes;
+        }
+    }
+
+    void ScanStats::add(const ScanStats& other)
+    {
+        segments_ += other.segments_;
+        skipped_zone_ += other.skipped_zone_;
+        skipped_sealed_ += other.skipped_sealed_;
+        rows_read_ += other.rows_read_;
+        rows_matched_ += other.rows_matched_;
+        bytes_ += other.bytes_;
+        scan_ns_ += other.scan_ns_;
+    }
+
+    ScanStats::Scope::Scope(ScanStats& stats)
+    : stats_(&stats), outer_(current_stats)
+    {
+        current_stats = &stats;
+    }
+
+    ScanStats::Scope::~Scope()
+    {
+        current_stats = outer_;
+        if (outer_)
+            outer_->add(*stats_);
+    }
+} // namespace memdb
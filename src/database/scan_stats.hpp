@@ -0,0 +1,54 @@
+#ifndef HEADER_GUARD_DATABASE_SCAN_STATS_H
+#define HEADER_GUARD_DATABASE_SCAN_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace memdb
+{
+    /*
+        What the table scans of a statement did, for EXPLAIN ANALYZE.
+
+        Scans add to the ScanStats of their thread while a Scope is open
+        there, looking it up once per scan. Every statement runs in a
+        scope for the metrics of the database; EXPLAIN ANALYZE opens inner
+        ones per operator, whose counts go to the enclosing scope as well
+        when they close.
+    */
+    struct ScanStats
+    {
+        size_t      segments_ = 0;          // segments of the scanned tables
+        size_t      skipped_zone_ = 0;      // slots of segments their zone maps ruled out
+        size_t      skipped_sealed_ = 0;    // slots the compressed columns ruled out
+        size_t      rows_read_ = 0;         // versions read, visible or not
+        size_t      rows_matched_ = 0;      // rows the WHERE condition held for
+        size_t      bytes_ = 0;             // selection vectors and new rows
+        uint64_t    scan_ns_ = 0;           // time in scan loops
+
+        // Stats of the innermost scope open on this thread, nullptr if none
+        static ScanStats* current();
+
+        // Rows a statement found matching and the bytes it allocated for them
+        static void add_matched(size_t rows, size_t bytes);
+
+        // Add the counts of other
+        void add(const ScanStats& other);
+
+        // Collect into stats until destroyed, then add them to the outer scope
+        class Scope
+        {
+        public:
+            Scope(ScanStats& stats);
+            ~Scope();
+
+            Scope(const Scope& other)               = delete;
+            Scope& operator= (const Scope& other)   = delete;
+
+        private:
+            ScanStats* stats_;
+            ScanStats* outer_;
+        };
+    };
+} // namespace memdb
+
+#endif // HEADER_GUARD_DATABASE_SCAN_STATS_H
@@ -0,0 +1,112 @@
+#include "database/segment.hpp"
+
+namespace memdb
+{
+    void RowVersion::reuse(Row&& row, uint64_t begin_ts)
+    {
+        // hide the slot from readers that pick up the new end_ts_ below
+        begin_ts_ = TIMESTAMP_INFINITY;
+        row_.emplace(std::move(row));
+        end_ts_ = TIMESTAMP_INFINITY;
+        begin_ts_ = begin_ts;
+    }
+
+    Segment::Segment(const std::vector<Column>& columns)
+    : versions_(new RowVersion[SEGMENT_CAPACITY]), size_(0), occupied_(0), zone_map_(columns), bitmap_{}
+    { }
+
+    void Segment::mark(size_t index, bool occupied)
+    {
+        uint64_t bit = uint64_t(1) << (index % word_bits);
+        if (occupied)
+            bitmap_[index / word_bits] |= bit;
+        else
+            bitmap_[index / word_bits] &= ~bit;
+    }
+
+    RowVersion& Segment::append(Row&& row, uint64_t begin_ts)
+    {
+        RowVersion& version = versions_[size_];
+        version.row_.emplace(std::move(row));
+        version.begin_ts_ = begin_ts;
+        version.end_ts_ = TIMESTAMP_INFINITY;
+        zone_map_.add(*version.row_);
+
+        mark(size_, true);
+        occupied_++;
+        size_++;
+        return version;
+    }
+
+    RowVersion& Segment::reuse(size_t index, Row&& row, uint64_t begin_ts)
+    {
+        // readers that can see the new row start after this
+        sealed_.store(nullptr);
+
+        RowVersion& version = versions_[index];
+        version.reuse(std::move(row), begin_ts);
+        zone_map_.add(*version.row_);
+
+        mark(index, true);
+        occupied_++;
+        return version;
+    }
+
+    size_t Segment::bytes() const
+    {
+        size_t bytes = sizeof(Segment) + SEGMENT_CAPACITY * sizeof(RowVersion);
+        for_each_occupied([&] (const RowVersion& version) {
+            if (version.row_)
+                bytes += version.row_->cells().capacity() * sizeof(Cell);
+        });
+
+        if (auto sealed = sealed_.load())
+            for (auto& column : *sealed)
+                if (column)
+                    bytes += column->bytes();
+        return bytes;
+    }
+
+    void Segment::seal(const std::vector<Column>& columns)
+    {
+        auto sealed = std::make_shared<SealedColumns>(columns.size());
+
+        for (auto c = 0LU; c < columns.size(); ++c)
+        {
+            if (columns[c].type_ != CellType::INT32)
+                continue;
+
+            // empty slots repeat the previous value, they are never selected anyway
+            std::vector<int32_t> values(size_, 0);
+            for_each_occupied([&] (const RowVersion& version) {
+                values[&version - versions_.get()] = (*version.row_)[c].get_int();
+            });
+            for (auto i = 1LU; i < size_; ++i)
+                if (!(bitmap_[i / word_bits] & (uint64_t(1) << (i % word_bits))))
+                    values[i] = values[i - 1];
+
+            (*sealed)[c] = std::make_unique<const CompressedColumn>(values);
+        }
+
+        sealed_.store(std::move(sealed));
+    }
+
+    size_t Segment::collect(uint64_t oldest_ts, std::vector<size_t>& freed)
+    {
+        size_t collected = 0;
+        for_each_occupied([&] (RowVersion& version)
+        {
+            if (version.end_ts_ > oldest_ts)
+                return;
+
+            size_t index = &version - versions_.get();
+            mark(index, false);
+            version.row_.reset();
+            freed.push_back(index);
+            collected++;
+        });
+
+        occupied_ -= collected;
+        return collected;
+    }
+} // namespace memdb
@@ -0,0 +1,197 @@
+#ifndef HEADER_GUARD_DATABASE_SEGMENT_H
+#define HEADER_GUARD_DATABASE_SEGMENT_H
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <vector>
+#include <array>
+#include <bit>
+#include <cstdint>
+
+#include "database/row.hpp"
+#include "database/column.hpp"
+#include "database/zone_map.hpp"
+#include "database/compressed_column.hpp"
+#include "database/transaction_manager.hpp"
+
+#define SEGMENT_CAPACITY 1024U
+
+// Full segments with at least this many empty slots are rewritten by compaction
+#define COMPACTION_MIN_EMPTY (SEGMENT_CAPACITY / 2)
+
+namespace memdb
+{
+    // One bit per slot of a segment
+    typedef std::array<uint64_t, SEGMENT_CAPACITY / 64> SlotMask;
+
+    // Number of bits set in mask among the first size slots
+    inline size_t count_slots(const SlotMask& mask, size_t size)
+    {
+        size_t count = 0;
+        for (auto w = 0LU; w * 64 < size; ++w) {
+            uint64_t word = mask[w];
+            if (size - w * 64 < 64)
+                word &= (uint64_t(1) << (size - w * 64)) - 1;
+            count += std::popcount(word);
+        }
+        return count;
+    }
+
+    // Compressed INT32 columns of a sealed segment, nullptr for other columns
+    typedef std::vector<std::unique_ptr<const CompressedColumn>> SealedColumns;
+
+    // One version of a row, visible to snapshots in [begin_ts_, end_ts_)
+    struct RowVersion
+    {
+        std::atomic<uint64_t>   begin_ts_{TIMESTAMP_INFINITY};
+        std::atomic<uint64_t>   end_ts_{TIMESTAMP_INFINITY};
+        std::optional<Row>      row_;   // reset once no snapshot can see the version
+
+        // end_ts_ is read first: a slot being reused gets begin_ts_ = INFINITY
+        // before its end_ts_ is reset, so a reader never sees the old begin
+        // together with the new end
+        bool visible(uint64_t ts) const { return ts < end_ts_ && begin_ts_ <= ts; }
+        bool live() const               { return end_ts_ == TIMESTAMP_INFINITY; }
+
+        // Put row into a slot that was collected. Caller holds the table write
+        // lock, no snapshot can see the version that occupied it
+        void reuse(Row&& row, uint64_t begin_ts);
+    };
+
+    /*
+        Fixed-capacity block of row version slots, the row group of a table.
+
+        There is a single writer at a time (it holds the table write lock).
+        A version is constructed before the size is increased, so readers
+        that only look at the first size() versions never see a half-built one.
+        Published rows are never modified, changes only set end_ts_ of a version
+        (the tombstone) and store a new one. Slots of collected versions are
+        handed back to the table, which reuses them before appending.
+
+        A bitmap marks the slots holding a version, scans skip empty slots
+        a word at a time. A zone map bounds the values stored in the segment,
+        scans skip the whole segment if the WHERE condition cannot hold there.
+
+        A full segment is sealed by compaction: its INT32 columns get a
+        compressed copy that scans filter on before any row is looked at.
+        Reusing a slot drops the copy until the segment is sealed again.
+    */
+    class Segment
+    {
+    public:
+        Segment(const std::vector<Column>& columns);
+
+        Segment(const Segment& other)               = delete;
+        Segment& operator= (const Segment& other)   = delete;
+
+        size_t size() const     { return size_; }
+        bool full() const       { return size_ == SEGMENT_CAPACITY; }
+
+        // Number of slots holding a version. Only stable under the table lock
+        size_t occupied() const { return occupied_; }
+
+        const ZoneMap& zone_map() const { return zone_map_; }
+
+        // Memory taken by the slots, the cells of their rows and the
+        // compressed columns, an estimate. Only stable under the table lock
+        size_t bytes() const;
+
+        RowVersion& operator[] (size_t index)               { return versions_[index]; }
+        const RowVersion& operator[] (size_t index) const   { return versions_[index]; }
+
+        // Store row in the next free slot and publish it. Segment must not be full
+        RowVersion& append(Row&& row, uint64_t begin_ts);
+
+        // Store row in the empty slot index, below size()
+        RowVersion& reuse(size_t index, Row&& row, uint64_t begin_ts);
+
+        // Build compressed copies of the INT32 columns. Caller holds the table write lock
+        void seal(const std::vector<Column>& columns);
+
+        // Compressed columns, nullptr if the segment is not sealed
+        std::shared_ptr<const SealedColumns> sealed() const { return sealed_.load(); }
+
+        // Drop rows of versions that ended at or before oldest_ts and add
+        // their slot indexes to freed, return how many
+        size_t collect(uint64_t oldest_ts, std::vector<size_t>& freed);
+
+        // Call f for every slot holding a version, only slots set in mask if given
+        template <typename F>
+        void for_each_occupied(F f, const SlotMask* mask = nullptr) const;
+
+        // Call f for the slots holding a version from index from on, as
+        // for_each_occupied, until f returns false. Return the index after
+        // the slot f stopped at, size() if it never did
+        template <typename F>
+        size_t scan_occupied(size_t from, F f, const SlotMask* mask = nullptr) const;
+
+    private:
+        static const size_t word_bits = 64;
+
+        void mark(size_t index, bool occupied);
+
+        std::unique_ptr<RowVersion[]>   versions_;
+        std::atomic<size_t>             size_;
+        size_t                          occupied_;
+        ZoneMap                         zone_map_;
+
+        std::atomic<uint64_t>
+            bitmap_[SEGMENT_CAPACITY / word_bits];  // bit set for a slot holding a version
+
+        std::atomic<std::shared_ptr<const SealedColumns>>
+                                        sealed_;
+    };
+
+    // Segments of a table, replaced as a whole when one is added or released
+    typedef std::vector<std::shared_ptr<Segment>> SegmentList;
+
+    template <typename F>
+    void Segment::for_each_occupied(F f, const SlotMask* mask) const
+    {
+        size_t size = size_;
+
+        for (auto w = 0LU; w * word_bits < size; ++w)
+        {
+            uint64_t word = bitmap_[w];
+            if (mask)
+                word &= (*mask)[w];
+            if (size - w * word_bits < word_bits)
+                word &= (uint64_t(1) << (size - w * word_bits)) - 1;
+
+            while (word) {
+                size_t index = w * word_bits + std::countr_zero(word);
+                word &= word - 1;
+                f(versions_[index]);
+            }
+        }
+    }
+
+    template <typename F>
+    size_t Segment::scan_occupied(size_t from, F f, const SlotMask* mask) const
+    {
+        size_t size = size_;
+
+        for (auto w = from / word_bits; w * word_bits < size; ++w)
+        {
+            uint64_t word = bitmap_[w];
+            if (mask)
+                word &= (*mask)[w];
+            if (size - w * word_bits < word_bits)
+                word &= (uint64_t(1) << (size - w * word_bits)) - 1;
+            if (w == from / word_bits)
+                word &= ~uint64_t(0) << (from % word_bits);
+
+            while (word) {
+                size_t index = w * word_bits + std::countr_zero(word);
+                word &= word - 1;
+                if (!f(versions_[index]))
+                    return index + 1;
+            }
+        }
+
+        return size;
+    }
+} // namespace memdb
+
+#endif // HEADER_GUARD_DATABASE_SEGMENT_H
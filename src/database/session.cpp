@@ -0,0 +1,153 @@
+#include "database/session.hpp"
+#include "database/database.hpp"
+#include "parser/parser.hpp"
+#include "parser/parse_exception.hpp"
+
+#include <chrono>
+
+namespace memdb
+{
+    Session::Session(Database& database)
+    : database_(database), results_(std::make_shared<ResultPool>())
+    { }
+
+    Result Session::execute(const std::string& query)
+    {
+        Command c;
+
+        try 
+        {
+            c = parse(query);
+        }
+        catch (ParseException& ex)
+        {
+            return Result(ex.what());
+        }
+
+        // this must be safe, try catch is inside
+        return c.execute(this);
+    }
+
+    Command Session::parse(const std::string& query)
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto text = std::make_shared<const std::string>(query);
+        Parser p(*text);
+        Command c;
+
+        try
+        {
+            p.parse(c);
+        }
+        catch (ParseException&)
+        {
+            database_.metrics().parse_failed();
+            throw;
+        }
+
+        uint64_t parse_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        database_.metrics().parsed(c.type(), parse_ns);
+        c.set_source(std::move(text), parse_ns);
+        return c;
+    }
+
+    uint32_t Session::prepare(const std::string& query)
+    {
+        Command c = parse(query);
+
+        uint32_t handle = next_statement_++;
+        statements_.emplace(handle, std::move(c));
+        return handle;
+    }
+
+    Command Session::bind(uint32_t statement, const std::vector<Cell>& parameters) const
+    {
+        auto it = statements_.find(statement);
+        if (it == statements_.end())
+            throw UnknownStatementException(statement);
+        return it->second.bind(parameters);
+    }
+
+    Result Session::execute(uint32_t statement, const std::vector<Cell>& parameters)
+    {
+        Command bound;
+        try
+        {
+            bound = bind(statement, parameters);
+        }
+        catch (DatabaseException& ex)
+        {
+            return Result(ex.what());
+        }
+
+        return bound.execute(this);
+    }
+
+    bool Session::deallocate(uint32_t statement)
+    {
+        return statements_.erase(statement) != 0;
+    }
+
+    Database& Session::database()
+    {
+        return database_;
+    }
+
+    Transaction* Session::transaction()
+    {
+        return transaction_.get();
+    }
+
+    std::shared_ptr<ResultPool> Session::results()
+    {
+        return results_;
+    }
+
+    void Session::begin()
+    {
+        if (transaction_)
+            throw TransactionStateException("transaction is already in progress");
+
+        transaction_ = std::make_unique<Transaction>(database_);
+    }
+
+    void Session::commit()
+    {
+        if (!transaction_)
+            throw TransactionStateException("no transaction in progress");
+
+        // the transaction is over whether it commits or conflicts
+        std::unique_ptr<Transaction> transaction = std::move(transaction_);
+        transaction->commit();
+    }
+
+    void Session::rollback()
+    {
+        if (!transaction_)
+            throw TransactionStateException("no transaction in progress");
+
+        // nothing was applied, the write set is simply dropped
+        transaction_.reset();
+    }
+
+    void Session::declare(const std::string& name, std::unique_ptr<Cursor> cursor)
+    {
+        if (!cursors_.emplace(name, std::move(cursor)).second)
+            throw CursorException("cursor \"" + name + "\" already exists");
+    }
+
+    Cursor& Session::cursor(const std::string& name)
+    {
+        auto it = cursors_.find(name);
+        if (it == cursors_.end())
+            throw CursorException("cursor \"" + name + "\" does not exist");
+        return *it->second;
+    }
+
+    void Session::close(const std::string& name)
+    {
+        if (!cursors_.erase(name))
+            throw CursorException("cursor \"" + name + "\" does not exist");
+    }
+} // namespace memdb
@@ -0,0 +1,93 @@
+#ifndef HEADER_GUARD_DATABASE_SESSION_H
+#define HEADER_GUARD_DATABASE_SESSION_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "command/command.hpp"
+#include "command/result.hpp"
+#include "database/cursor.hpp"
+#include "database/transaction.hpp"
+
+namespace memdb
+{
+    class Database;
+
+    /*
+        Connection state of one client: the transaction opened by BEGIN, the
+        cursors opened by DECLARE, the prepared statements and the pool its
+        result tables are recycled through.
+
+        Cursors belong to the session, not to a transaction: they stay open
+        after COMMIT or ROLLBACK until CLOSE or the end of the session.
+
+        Without an open transaction every statement commits on its own.
+        A session is meant for one thread at a time; concurrent clients
+        each use a session of their own.
+    */
+    class Session
+    {
+    public:
+        Session(Database& database);
+
+        Session(const Session& other)               = delete;
+        Session& operator= (const Session& other)   = delete;
+
+        Result execute(const std::string& query);
+
+        // Parse query into a command, timed in the metrics of the database.
+        // Throws ParseException
+        Command parse(const std::string& query);
+
+        // Parse query once and keep it under a new handle. Parameters $n
+        // stand for values given at every execution. Throws ParseException
+        uint32_t prepare(const std::string& query);
+
+        // Prepared statement with values of its parameters, ready to run.
+        // UnknownStatementException, UnboundParameterException
+        Command bind(uint32_t statement, const std::vector<Cell>& parameters) const;
+
+        // Run a prepared statement with values of its parameters
+        Result execute(uint32_t statement, const std::vector<Cell>& parameters);
+
+        // Forget a prepared statement, false if there is none under the handle
+        bool deallocate(uint32_t statement);
+
+        Database& database();
+
+        // Open transaction or null
+        Transaction* transaction();
+
+        // Tables of released results, reused for the next ones
+        std::shared_ptr<ResultPool> results();
+
+        void begin();
+        void commit();
+        void rollback();
+
+        // Keep cursor under name, throw CursorException if the name is taken
+        void declare(const std::string& name, std::unique_ptr<Cursor> cursor);
+
+        // Open cursor of name, throw CursorException if there is none
+        Cursor& cursor(const std::string& name);
+
+        void close(const std::string& name);
+
+    private:
+        Database&                       database_;
+        std::unique_ptr<Transaction>    transaction_;
+        std::shared_ptr<ResultPool>     results_;
+
+        std::map<std::string, std::unique_ptr<Cursor>>
+                                        cursors_;
+
+        std::unordered_map<uint32_t, Command>
+                                        statements_;    // prepared
+        uint32_t                        next_statement_ = 1;
+    };
+} // namespace memdb
+
+#endif // HEADER_GUARD_DATABASE_SESSION_H
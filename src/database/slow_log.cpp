@@ -0,0 +1,240 @@
+#include "database/slow_log.hpp"
+#include "database/table.hpp"
+#include "database/db_exception.hpp"
+
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace memdb
+{
+    static bool word_char(char c)
+    {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+    }
+
+    std::string normalize_query(std::string_view query)
+    {
+        std::string res;
+        res.reserve(query.size());
+
+        for (auto i = 0LU; i < query.size(); )
+        {
+            char c = query[i];
+            bool word_start = res.empty() || !word_char(res.back());
+
+            if (std::isspace(static_cast<unsigned char>(c))) {
+                while (i < query.size() && std::isspace(static_cast<unsigned char>(query[i])))
+                    ++i;
+                if (!res.empty() && i < query.size())
+                    res += ' ';
+                continue;
+            }
+
+            // strings up to the closing quote, escaped quotes included
+            if (c == '"' || c == '\'') {
+                for (++i; i < query.size() && query[i] != c; ++i)
+                    if (query[i] == '\\')
+                        ++i;
+                ++i;
+                res += '?';
+                continue;
+            }
+
+            // numbers and 0x bytes, not digits of names or parameters $n
+            if (word_start && std::isdigit(static_cast<unsigned char>(c))) {
+                while (i < query.size() && std::isalnum(static_cast<unsigned char>(query[i])))
+                    ++i;
+                res += '?';
+                continue;
+            }
+
+            res += c;
+            ++i;
+        }
+        return res;
+    }
+
+    static std::string format_time(std::chrono::system_clock::time_point time)
+    {
+        std::time_t seconds = std::chrono::system_clock::to_time_t(time);
+        std::tm utc;
+        gmtime_r(&seconds, &utc);
+
+        char text[32];
+        size_t length = std::strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%SZ", &utc);
+        return std::string(text, length);
+    }
+
+    static void append_quoted(std::string& line, std::string_view text)
+    {
+        line += '"';
+        for (char c : text) {
+            if (c == '"' || c == '\\')
+                line += '\\';
+            line += c == '\n' ? ' ' : c;
+        }
+        line += '"';
+    }
+
+    // key=value pairs on one line
+    static std::string format_line(const SlowQuery& query)
+    {
+        std::string line = "time=" + format_time(query.time_)
+            + " parse_us=" + std::to_string(query.parse_ns_ / 1000)
+            + " exec_us=" + std::to_string(query.execute_ns_ / 1000)
+            + " rows_scanned=" + std::to_string(query.rows_scanned_)
+            + " rows_skipped=" + std::to_string(query.rows_skipped_)
+            + " rows_returned=" + std::to_string(query.rows_returned_)
+            + " ok=" + (query.ok_ ? "true" : "false")
+            + " plan=";
+        append_quoted(line, query.plan_);
+        line += " query=";
+        append_quoted(line, query.query_);
+        line += '\n';
+        return line;
+    }
+
+    SlowLog::~SlowLog()
+    {
+        stop_writer();
+    }
+
+    void SlowLog::configure(const SlowLogOptions& options)
+    {
+        stop_writer();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        threshold_us_ = options.threshold_us_;
+        capacity_ = options.capacity_;
+        while (entries_.size() > capacity_)
+            entries_.pop_front();
+
+        path_ = options.path_;
+        if (path_.empty())
+            return;
+
+        fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd_ < 0)
+            throw SlowLogException(path_, std::string("cannot open for writing: ") + strerror(errno));
+        writer_ = std::thread(&SlowLog::write_loop, this);
+    }
+
+    void SlowLog::set_threshold(uint64_t threshold_us)
+    {
+        threshold_us_ = threshold_us;
+    }
+
+    void SlowLog::record(SlowQuery&& query)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (capacity_ == 0 && fd_ < 0)
+            return;
+
+        if (fd_ >= 0) {
+            pending_.push_back(format_line(query));
+            queued_++;
+            wake_cv_.notify_one();
+        }
+
+        entries_.push_back(std::move(query));
+        while (entries_.size() > capacity_)
+            entries_.pop_front();
+    }
+
+    std::vector<SlowQuery> SlowLog::entries() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return std::vector<SlowQuery>(entries_.begin(), entries_.end());
+    }
+
+    void SlowLog::flush()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        uint64_t target = queued_;
+        wake_cv_.notify_one();
+        while (written_ < target && writer_.joinable())
+            written_cv_.wait_for(lock, std::chrono::milliseconds(SLOW_LOG_FLUSH_MS));
+    }
+
+    void SlowLog::write_loop()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true)
+        {
+            if (pending_.empty() && !stop_)
+                wake_cv_.wait_for(lock, std::chrono::milliseconds(SLOW_LOG_FLUSH_MS));
+
+            std::vector<std::string> lines;
+            lines.swap(pending_);
+            bool stop = stop_;
+
+            // the file is written without the lock, queries keep queueing
+            lock.unlock();
+            for (auto& line : lines)
+                for (size_t done = 0; done < line.size(); ) {
+                    ssize_t count = ::write(fd_, line.data() + done, line.size() - done);
+                    if (count < 0 && errno == EINTR)
+                        continue;
+                    if (count <= 0)
+                        break;      // a full disk loses lines, not queries
+                    done += count;
+                }
+            lock.lock();
+
+            written_ += lines.size();
+            written_cv_.notify_all();
+            if (stop && pending_.empty())
+                return;
+        }
+    }
+
+    void SlowLog::stop_writer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!writer_.joinable())
+                return;
+            stop_ = true;
+        }
+        wake_cv_.notify_one();
+        writer_.join();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        ::close(fd_);
+        fd_ = -1;
+        stop_ = false;
+    }
+
+    std::unique_ptr<Table> slow_log_table(const std::vector<SlowQuery>& entries)
+    {
+        auto table = std::make_unique<Table>("", std::vector<Column>{
+            Column(CellType::STRING, "time", 0),
+            Column(CellType::STRING, "query", 0),
+            Column(CellType::INT32, "parse_us", 0),
+            Column(CellType::INT32, "exec_us", 0),
+            Column(CellType::INT32, "rows_scanned", 0),
+            Column(CellType::INT32, "rows_skipped", 0),
+            Column(CellType::INT32, "rows_returned", 0),
+            Column(CellType::STRING, "plan", 0)
+        });
+
+        // long queries and plans are clipped to fit the cells
+        for (auto& entry : entries)
+            table->insert(std::vector<Cell>{
+                Cell(format_time(entry.time_)),
+                Cell(entry.query_.substr(0, MAX_STRING_DATA)),
+                clipped_int(entry.parse_ns_ / 1000),
+                clipped_int(entry.execute_ns_ / 1000),
+                clipped_int(entry.rows_scanned_),
+                clipped_int(entry.rows_skipped_),
+                clipped_int(entry.rows_returned_),
+                Cell(entry.plan_.substr(0, MAX_STRING_DATA))
+            });
+        return table;
+    }
+} // namespace memdb
@@ -0,0 +1,120 @@
+#ifndef HEADER_GUARD_DATABASE_SLOW_LOG_H
+#define HEADER_GUARD_DATABASE_SLOW_LOG_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Statements taking longer than this are recorded unless configured otherwise
+#define SLOW_LOG_THRESHOLD_MS 100U
+
+// Slow statements kept in memory, the oldest go first
+#define SLOW_LOG_CAPACITY 128U
+
+// The file writer wakes at least this often
+#define SLOW_LOG_FLUSH_MS 200U
+
+namespace memdb
+{
+    class Table;
+
+    // What to record and where
+    struct SlowLogOptions
+    {
+        uint64_t    threshold_us_ = SLOW_LOG_THRESHOLD_MS * 1000;  // UINT64_MAX turns the log off
+        size_t      capacity_ = SLOW_LOG_CAPACITY;
+        std::string path_;      // file the entries are appended to, none if empty
+    };
+
+    // One statement that took longer than the threshold
+    struct SlowQuery
+    {
+        std::chrono::system_clock::time_point
+                    time_;          // when it finished
+        std::string query_;         // text with literals replaced by ?, see normalize_query
+        uint64_t    parse_ns_;      // 0 for prepared statements, parsed beforehand
+        uint64_t    execute_ns_;
+        size_t      rows_scanned_;
+        size_t      rows_skipped_;  // ruled out by zone maps and compressed columns
+        size_t      rows_returned_;
+        std::string plan_;          // operators, parent first: "Project a <- Scan t filter a == ?"
+        bool        ok_;
+    };
+
+    // Query with string, bytes and number literals replaced by ? and runs of
+    // whitespace by one space, so the statements of one shape look alike
+    std::string normalize_query(std::string_view query);
+
+    /*
+        Statements slower than a threshold, kept in a ring of the latest
+        capacity ones and optionally appended to a file as lines of
+        key=value pairs.
+
+        Checking a statement against the threshold is one atomic load, the
+        rest happens for slow statements only. The file is written by a
+        thread of the log, a query thread only queues its entry.
+    */
+    class SlowLog
+    {
+    public:
+        SlowLog() = default;
+        ~SlowLog();
+
+        SlowLog(const SlowLog& other)               = delete;
+        SlowLog& operator= (const SlowLog& other)   = delete;
+
+        // Replace the options. Entries in memory are kept, up to the new
+        // capacity. Throws SlowLogException if the file cannot be opened
+        void configure(const SlowLogOptions& options);
+
+        void set_threshold(uint64_t threshold_us);
+        uint64_t threshold_us() const   { return threshold_us_.load(std::memory_order_relaxed); }
+
+        // True if a statement that took ns is recorded
+        bool slow(uint64_t ns) const    { return ns / 1000 >= threshold_us(); }
+
+        void record(SlowQuery&& query);
+
+        // Entries in memory, oldest first
+        std::vector<SlowQuery> entries() const;
+
+        // Wait until queued entries are in the file
+        void flush();
+
+    private:
+        void write_loop();
+        void stop_writer();
+
+        std::atomic<uint64_t>   threshold_us_{SLOW_LOG_THRESHOLD_MS * 1000};
+
+        mutable std::mutex      mutex_;
+        size_t                  capacity_ = SLOW_LOG_CAPACITY;
+        std::deque<SlowQuery>   entries_;
+
+        // file writer, guarded by mutex_
+        int                     fd_ = -1;
+        std::string             path_;
+        std::vector<std::string>
+                                pending_;       // lines not written yet
+        uint64_t                queued_ = 0;    // lines ever queued
+        uint64_t                written_ = 0;   // lines ever written
+        bool                    stop_ = false;
+        std::condition_variable wake_cv_;       // lines queued or stop
+        std::condition_variable written_cv_;    // written_ moved on
+        std::thread             writer_;
+    };
+
+    // Table of the entries: time, query, timings in microseconds, rows and plan
+    std::unique_ptr<Table> slow_log_table(const std::vector<SlowQuery>& entries);
+} // namespace memdb
+
+#endif // HEADER_GUARD_DATABASE_SLOW_LOG_H
@@ -1,22 +1,55 @@
 #include "database/table.hpp"
 #include "expression/expression.hpp"
+#include "command/result.hpp"
+#include "command/output.hpp"
+#include "database/scan_stats.hpp"
+
+#include <unordered_set>
+#include <algorithm>
+#include <chrono>
 
 namespace memdb
 {
     // Construct with string name and vector of columns
     Table::Table(const std::string& table_name, const std::vector<Column>& columns) 
-    : name_(table_name), columns_(columns)
+    : name_(table_name), columns_(columns), manager_(std::make_shared<TransactionManager>()),
+      segments_(std::make_shared<const SegmentList>()), size_(0), garbage_(0),
+      compactions_(0), next_row_id_(1), gc_threshold_(SEGMENT_CAPACITY)
     {
-        for (auto i = 0LU; i < columns_.size(); ++i)
-            column_positions_[columns_[i].name_] = i;
+        index_columns();
     }
 
     // Construct with char* name and vector of columns
     Table::Table(const char* table_name, const std::vector<Column>& columns) 
-    : name_(table_name), columns_(columns)
+    : Table(std::string(table_name), columns)
+    { }
+
+    void Table::reset(const std::vector<Column>& columns)
+    {
+        projection_.reset();
+
+        name_.clear();
+        columns_ = columns;
+        index_columns();
+
+        if (!segments_.load()->empty())
+            segments_ = std::make_shared<const SegmentList>();
+        free_slots_.clear();
+        size_ = 0;
+        garbage_ = 0;
+        compactions_ = 0;
+        next_row_id_ = 1;
+        gc_threshold_ = SEGMENT_CAPACITY;
+    }
+
+    void Table::index_columns()
     {
-        for (auto i = 0LU; i < columns_.size(); ++i)
+        column_positions_.clear();
+        for (auto i = 0LU; i < columns_.size(); ++i) {
             column_positions_[columns_[i].name_] = i;
+            if (columns_[i].type_ == CellType::STRING && !columns_[i].dictionary_)
+                columns_[i].dictionary_ = std::make_shared<Dictionary>();
+        }
     }
 
     std::string Table::name() 
@@ -31,7 +64,26 @@ namespace memdb
 
     size_t Table::size() const 
     {
-        return rows_.size();
+        return size_ + (projection_ ? projection_->rows_.size() : 0);
+    }
+
+    size_t Table::versions() const
+    {
+        size_t versions = 0;
+        for (auto& segment : *segments_.load())
+            versions += segment->occupied();
+        return versions;
+    }
+
+    size_t Table::bytes() const
+    {
+        size_t bytes = sizeof(Table);
+        for (auto& segment : *segments_.load())
+            bytes += segment->bytes();
+        for (auto& column : columns_)
+            if (column.dictionary_)
+                bytes += column.dictionary_->bytes();
+        return bytes;
     }
 
     size_t Table::column_position(const std::string& column_name) const
@@ -39,172 +91,612 @@ namespace memdb
         return column_positions_.at(column_name);
     }
 
-    void Table::insert(const std::vector<Cell>& data)
+    const std::vector<Column>& Table::columns() const
     {
-        rows_[this->size() + 1] = std::shared_ptr<Row>(new Row(this, data));
+        return columns_;
     }
 
-    void Table::insert(std::vector<Cell>&& data)
+    std::shared_lock<std::shared_mutex> Table::read_lock() const
     {
-        rows_[this->size() + 1] = std::shared_ptr<Row>(new Row(this, data));
+        return std::shared_lock<std::shared_mutex>(mutex_);
     }
 
-    void Table::insert(const std::unordered_map<std::string, Cell>& data)
+    std::unique_lock<std::shared_mutex> Table::write_lock()
     {
-        rows_[this->size() + 1] = std::shared_ptr<Row>(new Row(this, data));
+        return std::unique_lock<std::shared_mutex>(mutex_);
     }
 
-    // Query select method
-    // Allocates new table
-    Table* Table::select(
-        const std::vector<std::string>& columns, const Expression& where)
+    void Table::attach(std::shared_ptr<TransactionManager> manager)
     {
-        // Create column list of new table
-        std::vector<Column> res_columns;
+        for (auto& segment : *segments_.load())
+            segment->for_each_occupied([] (RowVersion& version)
+            {
+                if (version.live()) {
+                    version.begin_ts_ = 0;
+                    return;
+                }
+                // history of the old timestamps is invisible from now on
+                version.begin_ts_ = 0;
+                version.end_ts_ = 0;
+            });
 
-        for (auto col_name : columns) // run through every selected column name
-            res_columns.push_back(columns_[column_positions_[col_name]]);
-        // Allocate new table
-        
-        Table* res = new Table("", res_columns);
+        manager_ = std::move(manager);
+    }
 
-        // initialize new row with the width of new table
-        auto res_row = std::vector<Cell>(res->width());
+    void Table::collect_garbage()
+    {
+        uint64_t oldest_ts = manager_->oldest_snapshot();
 
-        // go through every row in the table
-        for (auto &[row_i, row] : rows_)
+        std::vector<size_t> freed;
+        for (auto& segment : *segments_.load())
         {
-            if (!where.evaluate(row.get()).get_bool())
-                continue;
+            freed.clear();
+            garbage_ -= segment->collect(oldest_ts, freed);
+            for (size_t index : freed)
+                free_slots_.push_back({segment.get(), index});
+        }
+
+        // versions a long snapshot still sees are not rescanned on every write
+        gc_threshold_ = garbage_ + std::max<size_t>(SEGMENT_CAPACITY, size_ / 2);
+    }
 
-            // assign new row cells to old row cells
-            for (auto i = 0LU; i < res->width(); ++i)
-                res_row[i] = (*row)[              
-                    column_positions_[               
-                        res_columns[i].name_ // (1) name of column
-                        ]                    // (2) index of column with this name in the old table 
-                    ];                       // (3) column on this index 
+    template <typename F>
+    void Table::for_each_visible(const SegmentList& segments, uint64_t ts, F f,
+        const Expression* where) const
+    {
+        for_each_candidate(segments, where, [&] (const RowVersion& version) {
+            return !version.visible(ts) || f(*version.row_);
+        });
+    }
 
-            // move new row to new table
-            res->insert(std::move(res_row));
+    template <typename F>
+    bool Table::for_each_candidate(const SegmentList& segments, const Expression* where, F f) const
+    {
+        ScanStats* stats = ScanStats::current();
+        if (stats) {
+            auto start = std::chrono::steady_clock::now();
+            stats->segments_ += segments.size();
+            bool finished = scan_candidates(segments, where, [&] (auto& version) {
+                stats->rows_read_++;
+                return f(version);
+            }, stats);
+            stats->scan_ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            return finished;
         }
 
-        return res;
+        return scan_candidates(segments, where, f, nullptr);
     }
 
-    void Table::drop(const Expression& where)
+    template <typename F>
+    bool Table::scan_candidates(const SegmentList& segments, const Expression* where, F f,
+        ScanStats* stats) const
     {
-        auto It = rows_.begin();
-        while (It != rows_.end())
+        for (auto& segment : segments)
         {
-            if (!where.evaluate(It->second.get()).get_bool()) {
-                It++;
+            if (!may_match(*segment, where)) {
+                if (stats)
+                    stats->skipped_zone_ += segment->size();
                 continue;
             }
 
-            It = rows_.erase(It);
+            SlotMask mask;
+            bool masked = false;
+            if (where)
+                if (auto sealed = segment->sealed())
+                    masked = where->candidates(*this, *sealed, mask);
+            if (masked && stats)
+                stats->skipped_sealed_ += segment->size() - count_slots(mask, segment->size());
+
+            bool more = true;
+            segment->scan_occupied(0, [&] (auto& version) {
+                return more = f(version);
+            }, masked ? &mask : nullptr);
+            if (!more)
+                return false;
         }
+        return true;
     }
 
-    void Table::update(
-        const std::unordered_map<std::string, Expression>& assignment, const Expression& where)
+    std::shared_ptr<const SegmentList> Table::segments() const
+    {
+        return segments_.load();
+    }
+
+    std::vector<RowVersion*> Table::visible_versions(uint64_t snapshot_ts,
+        const SegmentList& segments, const Expression* where) const
     {
-        for (auto &[i, row] : rows_)
+        std::vector<RowVersion*> versions;
+
+        for_each_candidate(segments, where, [&] (RowVersion& version) {
+            if (version.visible(snapshot_ts))
+                versions.push_back(&version);
+            return true;
+        });
+
+        return versions;
+    }
+
+    size_t Table::scan_estimate(const Expression& where) const
+    {
+        // zone maps judge a bound condition, one that does not bind yet
+        // (parameters, errors reported when it runs) reads every segment
+        Expression bound;
+        try {
+            bound = where.bind_condition(*this);
+        }
+        catch (DatabaseException&) { }
+
+        size_t rows = projection_ ? projection_->rows_.size() : 0;
+        for (auto& segment : *segments_.load())
+            if (may_match(*segment, &bound))
+                rows += segment->size();
+        return rows;
+    }
+
+    bool Table::scan(const SegmentList& segments, uint64_t snapshot_ts, const Expression& where,
+        ScanPosition& position, size_t count, std::vector<const Row*>& rows) const
+    {
+        for (; count > 0 && position.segment_ < segments.size(); ++position.segment_, position.slot_ = 0)
         {
-            if (!where.evaluate(row.get()).get_bool())
+            const Segment& segment = *segments[position.segment_];
+            if (!may_match(segment, &where))
                 continue;
 
-            for (auto &[col_name, rhs] : assignment)
-            {
-                (*row)[column_positions_[col_name]] = rhs.evaluate(row.get());
-            }
+            SlotMask mask;
+            bool masked = false;
+            if (auto sealed = segment.sealed())
+                masked = where.candidates(*this, *sealed, mask);
+
+            position.slot_ = segment.scan_occupied(position.slot_, [&] (const RowVersion& version) {
+                if (version.visible(snapshot_ts) && where.matches(&*version.row_)) {
+                    rows.push_back(&*version.row_);
+                    --count;
+                }
+                return count > 0;
+            }, masked ? &mask : nullptr);
+
+            // the rest of the segment is left for the next call
+            if (count == 0 && position.slot_ < segment.size())
+                break;
         }
+
+        return position.segment_ < segments.size();
     }
 
-    void print_head_aligned(std::ostream& os, const std::vector<Column>& columns, size_t alignment)
+    std::vector<RowVersion*> Table::live_versions(const Expression* where) const
     {
-        std::string bar = std::string((alignment + 3)*columns.size() + 1, '-') + '\n';
+        std::vector<RowVersion*> versions;
+        if (!where)
+            versions.reserve(size_);
+
+        for_each_candidate(*segments_.load(), where, [&] (RowVersion& version) {
+            if (version.live())
+                versions.push_back(&version);
+            return true;
+        });
 
-        os << bar;
+        return versions;
+    }
+
+    bool Table::may_match(const Segment& segment, const Expression* where) const
+    {
+        return !where || where->may_match(*this, segment.zone_map());
+    }
 
-        for (auto &col : columns) {
-            os << "| ";
-            os << col.name_;
-            os << std::string(alignment - col.name_.size(), ' ');
-            os << ' ';
+    std::vector<RowVersion*> Table::live_versions(const std::vector<RowId>& ids) const
+    {
+        std::unordered_map<RowId, size_t> positions;
+        for (auto i = 0LU; i < ids.size(); ++i)
+            positions.emplace(ids[i], i);
+
+        std::vector<RowVersion*> versions(ids.size(), nullptr);
+        for (RowVersion* version : live_versions()) {
+            auto it = positions.find(version->row_->id());
+            if (it != positions.end())
+                versions[it->second] = version;
         }
-        os << "|\n";
+
+        return versions;
     }
 
-    void print_row_aligned(std::ostream& os, const Row& row, size_t alignment)
-    {   
-        // positions indicating how much of each sell are already printed
-        std::vector<size_t> printed(row.size(), 0);
+    RowId Table::next_row_id() const
+    {
+        return next_row_id_;
+    }
 
-        std::string bar = std::string((alignment + 3)*row.size() + 1, '-') + '\n';
-        os << bar;
+    RowVersion& Table::append(Row&& row, uint64_t ts)
+    {
+        if (row.id() == 0)
+            row.set_id(next_row_id_++);
+        else
+            next_row_id_ = std::max(next_row_id_, row.id() + 1);
+
+        // strings are stored in the dictionaries of their columns. Results (unnamed
+        // tables) share the dictionaries of the table they were selected from and
+        // keep cells as they are, so values the table never stored do not grow it
+        if (!name_.empty())
+            for (auto i = 0LU; i < row.size(); ++i)
+                if (columns_[i].dictionary_)
+                    row[i] = columns_[i].dictionary_->encode(row[i]);
+
+        if (!free_slots_.empty()) {
+            Slot slot = free_slots_.back();
+            free_slots_.pop_back();
+            return slot.segment_->reuse(slot.index_, std::move(row), ts);
+        }
 
-        // print untill all cells will fit
-        bool fit = false;
-        while (!fit) {
-            fit = true;
+        auto segments = segments_.load();
 
-            // run through every cell in row
-            for (auto i = 0LU; i < row.size(); i++) {
-                std::string cur = row[i].ToString();
-                os << "| ";
+        if (segments->empty() || segments->back()->full()) {
+            auto grown = std::make_shared<SegmentList>(*segments);
+            grown->push_back(std::make_shared<Segment>(columns_));
+            segments = grown;
+            segments_ = segments;
+        }
 
-                // if all cell is printed, print spaces to align
-                if (printed[i] >= cur.size()) {
-                    os << std::string(alignment + 1, ' ');
-                    continue;
-                }
+        return segments->back()->append(std::move(row), ts);
+    }
 
-                if (cur.size() - printed[i] <= alignment) 
-                {
-                    // print last chunk of string
-                    std::string last_chunk = std::string(cur.begin() + printed[i], cur.end());
-                    os << last_chunk;
-                    os << std::string(alignment - last_chunk.size(), ' ');
-                    os << " ";
-                    printed[i] = cur.size();
-                }
-                else {
-                    // print another chunk of string
-                    os << std::string(cur.begin() + printed[i], cur.begin() + alignment);
-                    os << " ";
-                    printed[i] += alignment;
-                    fit = false;
-                }
+    void Table::apply(const std::vector<RowVersion*>& ended, std::vector<Row>&& inserted,
+        uint64_t ts, UndoLog& undo)
+    {
+        for (RowVersion* version : ended) {
+            version->end_ts_ = ts;
+            size_--;
+            garbage_++;
+            undo.ended(this, version);
+        }
+
+        for (auto& row : inserted) {
+            RowVersion& version = append(std::move(row), ts);
+            size_++;
+            undo.appended(this, &version);
+        }
+    }
+
+    void Table::apply_statement(const std::vector<RowVersion*>& ended, std::vector<Row>&& inserted)
+    {
+        {
+            TransactionManager::WriteStamp stamp(*manager_);
+            UndoLog undo;   // rolled back before the stamp is published, if apply throws
+            apply(ended, std::move(inserted), stamp.ts(), undo);
+            undo.release();
+        }
+
+        collect_garbage_if_needed();
+    }
+
+    void Table::undo_append(RowVersion* version)
+    {
+        // empty lifetime, no snapshot ever sees it
+        version->end_ts_ = version->begin_ts_.load();
+        size_--;
+        garbage_++;
+    }
+
+    void Table::undo_end(RowVersion* version)
+    {
+        version->end_ts_ = TIMESTAMP_INFINITY;
+        size_++;
+        garbage_--;
+    }
+
+    size_t Table::compact()
+    {
+        collect_garbage_if_needed();
+        size_t released = rewrite_sparse_segments();
+
+        // full segments only change again when a slot is reused
+        for (auto& segment : *segments_.load())
+            if (segment->full() && !segment->sealed())
+                segment->seal(columns_);
+
+        return released;
+    }
+
+    size_t Table::rewrite_sparse_segments()
+    {
+        auto segments = segments_.load();
+
+        // the last segment is still being appended to
+        std::vector<bool> sparse(segments->size(), false);
+        size_t sparse_count = 0, versions = 0;
+        for (auto i = 0LU; i + 1 < segments->size(); ++i)
+        {
+            Segment& segment = *(*segments)[i];
+            if (segment.full() && SEGMENT_CAPACITY - segment.occupied() >= COMPACTION_MIN_EMPTY) {
+                sparse[i] = true;
+                sparse_count++;
+                versions += segment.occupied();
             }
+        }
+
+        size_t dense_count = (versions + SEGMENT_CAPACITY - 1) / SEGMENT_CAPACITY;
+        if (dense_count >= sparse_count)
+            return 0;
+
+        // copies keep timestamps and ids, readers of the old list still see the originals.
+        // Dense segments go where the sparse ones were, the last segment stays last
+        auto compacted = std::make_shared<SegmentList>();
+        std::shared_ptr<Segment> dense;
+
+        for (auto i = 0LU; i < segments->size(); ++i)
+        {
+            if (!sparse[i]) {
+                compacted->push_back((*segments)[i]);
+                continue;
+            }
+
+            (*segments)[i]->for_each_occupied([&] (const RowVersion& version)
+            {
+                if (!dense || dense->full()) {
+                    dense = std::make_shared<Segment>(columns_);
+                    compacted->push_back(dense);
+                }
+
+                Row row(this, version.row_->cells());
+                row.set_id(version.row_->id());
 
-            os << "|\n";
+                RowVersion& copy = dense->append(std::move(row), version.begin_ts_);
+                copy.end_ts_ = version.end_ts_.load();
+            });
         }
+
+        std::unordered_set<Segment*> released;
+        for (auto i = 0LU; i < segments->size(); ++i)
+            if (sparse[i])
+                released.insert((*segments)[i].get());
+
+        std::erase_if(free_slots_, [&] (const Slot& slot) {
+            return released.count(slot.segment_) != 0;
+        });
+
+        compactions_++;
+        segments_ = std::shared_ptr<const SegmentList>(std::move(compacted));
+
+        return sparse_count - dense_count;
     }
 
-    void Table::print(std::ostream& os)
+    uint64_t Table::compactions() const
     {
-        size_t alignment = 0;
+        return compactions_;
+    }
 
+    void Table::collect_garbage_if_needed()
+    {
+        if (garbage_ >= gc_threshold_)
+            collect_garbage();
+    }
 
-        for (auto &col : columns_)
-            alignment = std::max(alignment, col.name_.size());
+    void Table::check_row(const std::vector<Cell>& data) const
+    {
+        if (data.size() != columns_.size())
+            throw IncompatibleTableRowException();
 
-        std::string bar = std::string((alignment + 3)*columns_.size() + 1, '-') + '\n';
+        for (auto i = 0LU; i < data.size(); ++i)
+            if (data[i].get_type() != columns_[i].type_)
+                throw IncompatibleTableRowException();
+    }
 
-        os << '\n';
-        if (!name_.empty()) {
-            os << "TABLE \"";
-            os << name_ << "\"\n";
+    std::vector<std::pair<size_t, Expression>> Table::bind_assignment(
+        const std::unordered_map<std::string, Expression>& assignment) const
+    {
+        std::vector<std::pair<size_t, Expression>> bound;
+        for (auto &[col_name, rhs] : assignment)
+        {
+            auto it = column_positions_.find(col_name);
+            if (it == column_positions_.end())
+                throw UnexistingColumnException(col_name);
+
+            Expression expression = rhs.bind(*this);
+            if (expression.type() != columns_[it->second].type_)
+                throw IncompatibleTableRowException();
+            bound.emplace_back(it->second, std::move(expression));
         }
+        return bound;
+    }
 
+    void Table::insert_row(Row&& row)
+    {
+        std::vector<Row> inserted;
+        inserted.push_back(std::move(row));
+        apply_statement({}, std::move(inserted));
+    }
+
+    void Table::insert(const std::vector<Cell>& data)
+    {
+        check_row(data);
+        insert_row(Row(this, data));
+    }
 
-        print_head_aligned(os, columns_, alignment);
+    void Table::insert(std::vector<Cell>&& data)
+    {
+        check_row(data);
+        insert_row(Row(this, std::move(data)));
+    }
+
+    void Table::insert(const std::unordered_map<std::string, Cell>& data)
+    {
+        Row row(this, data);
+        for (auto i = 0LU; i < row.size(); ++i)
+            if (row[i].get_type() != columns_[i].type_)
+                throw IncompatibleTableRowException();
 
-        for (auto &[i, row] : rows_)
-            print_row_aligned(os, *row, alignment);
+        insert_row(std::move(row));
+    }
+
+    // Query select method
+    // Allocates new table
+    std::unique_ptr<Table> Table::select(
+        const std::vector<std::string>& columns, const Expression& where, ResultPool* pool)
+    {
+        // a result is selected from as a plain table
+        materialize();
+
+        TransactionManager::ReadView view(*manager_);
+        return select(columns, where, view.ts(), pool);
+    }
+
+    std::unique_ptr<Table> Table::select(const std::vector<std::string>& columns,
+        const Expression& condition, uint64_t snapshot_ts, ResultPool* pool)
+    {
+        // type errors are reported before any row is read
+        Expression where = condition.bind_condition(*this);
+
+        // go through every row visible in the snapshot, only keep its address
+        auto segments = segments_.load();
+        std::vector<const Row*> rows;
+        for_each_visible(*segments, snapshot_ts, [&] (const Row& row)
+        {
+            if (where.matches(&row))
+                rows.push_back(&row);
+            return true;
+        }, &where);
+        ScanStats::add_matched(rows.size(), rows.capacity() * sizeof(const Row*));
+
+        return project(columns, std::move(rows), std::move(segments), snapshot_ts, pool);
+    }
+
+    std::unique_ptr<Table> Table::project(const std::vector<std::string>& columns,
+        std::vector<const Row*>&& rows, std::shared_ptr<const SegmentList> segments,
+        uint64_t snapshot_ts, ResultPool* pool) const
+    {
+        // Create column list of new table
+        auto projection = std::make_unique<Projection>();
+        std::vector<Column> res_columns;
+
+        for (auto& col_name : columns) { // run through every selected column name
+            auto it = column_positions_.find(col_name);
+            if (it == column_positions_.end())
+                throw UnexistingColumnException(col_name);
+            projection->positions_.push_back(it->second);
+            res_columns.push_back(columns_[it->second]);
+        }
+
+        // the snapshot stays registered with the source table while the result lives
+        projection->manager_ = manager_;
+        projection->view_ = std::make_unique<TransactionManager::ReadView>(*manager_, snapshot_ts);
+        projection->segments_ = std::move(segments);
+        projection->rows_ = std::move(rows);
+
+        std::unique_ptr<Table> res = pool ? pool->acquire(res_columns)
+            : std::make_unique<Table>("", res_columns);
+        res->projection_ = std::move(projection);
+        return res;
+    }
+
+    void Table::materialize()
+    {
+        if (!projection_)
+            return;
+
+        std::unique_ptr<Projection> projection = std::move(projection_);
+
+        std::vector<Row> inserted;
+        inserted.reserve(projection->rows_.size());
+        for (const Row* row : projection->rows_)
+        {
+            std::vector<Cell> data(columns_.size());
+            for (auto i = 0LU; i < data.size(); ++i)
+                data[i] = (*row)[projection->positions_[i]];
+            inserted.emplace_back(this, std::move(data));
+        }
+
+        if (!inserted.empty())
+            apply_statement({}, std::move(inserted));
+    }
+
+    void Table::drop(const Expression& condition)
+    {
+        materialize();
+
+        // type errors are reported before any row is read
+        Expression where = condition.bind_condition(*this);
+        std::vector<RowVersion*> dropped;
+        for (RowVersion* version : live_versions(&where))
+            if (where.matches(&*version->row_))
+                dropped.push_back(version);
+        ScanStats::add_matched(dropped.size(), dropped.capacity() * sizeof(RowVersion*));
+
+        if (!dropped.empty())
+            apply_statement(dropped, {});
+    }
+
+    void Table::update(
+        const std::unordered_map<std::string, Expression>& assignment, const Expression& condition)
+    {
+        materialize();
+
+        // type errors are reported before any row is read
+        Expression where = condition.bind_condition(*this);
+
+        auto set = bind_assignment(assignment);
+
+        // new versions are computed first, so a failing expression changes nothing
+        std::vector<RowVersion*> ended;
+        std::vector<Row> inserted;
+        for (RowVersion* version : live_versions(&where))
+        {
+            const Row& row = *version->row_;
+            if (!where.matches(&row))
+                continue;
+
+            std::vector<Cell> data = row.cells();
+            for (auto &[position, rhs] : set)
+                data[position] = rhs.evaluate(&row);
+
+            ended.push_back(version);
+            inserted.emplace_back(this, std::move(data));
+            inserted.back().set_id(row.id());
+        }
+        ScanStats::add_matched(ended.size(), ended.capacity() * sizeof(RowVersion*)
+            + inserted.capacity() * sizeof(Row) + inserted.size() * columns_.size() * sizeof(Cell));
+
+        if (!ended.empty())
+            apply_statement(ended, std::move(inserted));
+    }
+
+
+    void Table::for_each_row(const std::function<void(const Row&, const std::vector<size_t>&)>& f,
+        size_t limit) const
+    {
+        size_t count = 0;
+
+        // projected rows are read straight from the table they were selected from
+        if (projection_)
+            for (const Row* row : projection_->rows_) {
+                if (count++ == limit)
+                    return;
+                f(*row, projection_->positions_);
+            }
+        if (count >= limit)
+            return;
+
+        std::vector<size_t> positions(columns_.size());
+        for (auto i = 0LU; i < positions.size(); ++i)
+            positions[i] = i;
+
+        TransactionManager::ReadView view(*manager_);
+        auto segments = segments_.load();
+        for_each_visible(*segments, view.ts(), [&] (const Row& row) {
+            f(row, positions);
+            return ++count < limit;
+        });
+    }
+
+    void Table::print(std::ostream& os, size_t max_rows) const
+    {
+        OutputBuffer out(os);
+
+        out.put('\n');
+        if (!name_.empty()) {
+            out.append("TABLE \"");
+            out.append(name_);
+            out.append("\"\n");
+        }
 
-        os << bar;     
+        write_aligned(*this, out, max_rows);
     }
 
 
@@ -4,32 +4,69 @@
 #include <ostream>
 #include <string>
 #include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <functional>
 
 #include "database/row.hpp"
 #include "database/column.hpp"
+#include "database/segment.hpp"
+#include "database/transaction_manager.hpp"
+#include "database/undo_log.hpp"
 #include "database/db_exception.hpp"
 
 namespace memdb
 {
     /* 
         Table of a relational database with fixed name and set of columns
+
+        Rows are kept as versions in slots of fixed-size segments (multi-version
+        concurrency control). Changes never touch a published row: insert
+        stores a version, delete ends one, update does both, all stamped with
+        one write timestamp of the table's TransactionManager. Every row has
+        a RowId that its later versions keep.
+
+        Readers (size, select, print) take no lock: they scan the versions
+        visible at their snapshot timestamp while writers keep going.
+        Writers are serialised by the table lock: callers hold write_lock()
+        around insert, update and drop. read_lock() only keeps writers out,
+        e.g. while the whole catalog is written to a snapshot.
+
+        Ended versions are reclaimed once no active snapshot can see them,
+        their slots go to a free list and are filled before the table grows.
+        Compaction copies the versions of mostly empty segments into dense new
+        ones; readers already scanning the old segments keep them alive.
+
+        A table returned by select is a projection: it refers to the selected
+        versions of the source table and the columns picked from them instead
+        of holding copies. The versions are pinned for as long as the result
+        lives. Rows are copied in only when the result is updated, deleted
+        from or selected from; inserted rows are stored next to the projected
+        ones. Results belong to their caller and are not shared.
     */
 
     class Expression;
+    class ResultPool;
+    class Snapshot;
+    struct ScanStats;
 
     class Table 
     {
     public:
         // Tables are not default constructible or copyable
-        Table()                                 = default;
+        Table()                                 = delete;
         Table(const Table& other)               = delete;
         Table& operator= (const Table& other)   = delete;
 
-        // Tables are movable
-        Table(Table&& other)                    = default;
-        Table& operator= (Table&& other)        = default;
+        // Tables are shared by address and are not movable either
+        Table(Table&& other)                    = delete;
+        Table& operator= (Table&& other)        = delete;
 
-        // Construct with name and map of columns
+        // Construct with name and map of columns.
+        // Until attached to a database the table has timestamps of its own
         Table(const std::string& table_name, 
             const std::vector<Column>& columns);
 
@@ -39,9 +76,101 @@ namespace memdb
         
         std::string name();     // Table name
         size_t width() const;   // Number of columns
-        size_t size() const;    // Number of rows
+        size_t size() const;    // Number of live rows, projected ones included
+        size_t versions() const;    // Number of row versions kept in memory, under a table lock
+        size_t bytes() const;       // Memory of segments, rows and dictionaries, an estimate, under a table lock
         size_t column_position(const std::string& column_name) const;
 
+        const std::vector<Column>& columns() const;
+
+        std::shared_lock<std::shared_mutex> read_lock() const;
+        std::unique_lock<std::shared_mutex> write_lock();
+
+        // Take timestamps from manager from now on. Must be called before
+        // the table is shared: live rows become visible to every snapshot
+        void attach(std::shared_ptr<TransactionManager> manager);
+
+        // Reclaim versions no active snapshot can see. Caller holds write_lock()
+        void collect_garbage();
+
+        // Collect garbage if enough versions ended since the last time. Caller holds write_lock()
+        void collect_garbage_if_needed();
+
+        // Collect garbage if needed, then rewrite full segments with at least
+        // COMPACTION_MIN_EMPTY empty slots into fewer dense ones and seal the
+        // full ones. Return number of segments released. Caller holds write_lock()
+        size_t compact();
+
+        // Number of compactions so far. Pointers to versions taken before
+        // a compaction may refer to released segments
+        uint64_t compactions() const;
+
+        // Make this an empty unnamed table of columns, for reuse as a result.
+        // Drops the rows and the projection, keeps allocated memory where it can
+        void reset(const std::vector<Column>& columns);
+
+        // Throw IncompatibleTableRowException if row does not match the columns
+        void check_row(const std::vector<Cell>& data) const;
+
+        // Bind the right-hand sides of an UPDATE to the columns they are
+        // assigned to. Throw before any row is read if a column is unknown
+        // or an expression does not give the type of its column
+        std::vector<std::pair<size_t, Expression>> bind_assignment(
+            const std::unordered_map<std::string, Expression>& assignment) const;
+
+        //
+        // Multi-version access for transactions
+        //
+
+        // Current list of segments. Versions found in it stay in memory while
+        // the list is held, even if compaction releases their segments
+        std::shared_ptr<const SegmentList> segments() const;
+
+        // Versions of segments visible at snapshot_ts, except for segments where
+        // rows cannot match where. Caller keeps a ReadView of that timestamp and
+        // holds segments, see segments(), while it uses the versions
+        std::vector<RowVersion*> visible_versions(uint64_t snapshot_ts,
+            const SegmentList& segments, const Expression* where = nullptr) const;
+
+        // Slots a scan with where looks at: those of the segments whose zone
+        // maps do not rule where out. Reads no row and takes no lock, so it
+        // is cheap enough to judge a query before running it
+        size_t scan_estimate(const Expression& where) const;
+
+        // Where a scan stopped: the next slot to look at and its segment
+        struct ScanPosition
+        {
+            size_t segment_ = 0;
+            size_t slot_    = 0;
+        };
+
+        // Append up to count rows visible at snapshot_ts in segments that match
+        // where to rows, starting at position and moving it past them. Return
+        // false once all segments are scanned. where is bound to the table;
+        // caller keeps a ReadView of snapshot_ts and holds segments
+        bool scan(const SegmentList& segments, uint64_t snapshot_ts, const Expression& where,
+            ScanPosition& position, size_t count, std::vector<const Row*>& rows) const;
+
+        // Result table of columns over rows, which are versions visible at
+        // snapshot_ts stored in segments. Rows are not copied, see Table.
+        // The table comes from pool if given
+        std::unique_ptr<Table> project(const std::vector<std::string>& columns,
+            std::vector<const Row*>&& rows, std::shared_ptr<const SegmentList> segments,
+            uint64_t snapshot_ts, ResultPool* pool = nullptr) const;
+
+        // Live versions of rows with the given ids, in the same order, nullptr
+        // for ids not found. Caller holds write_lock()
+        std::vector<RowVersion*> live_versions(const std::vector<RowId>& ids) const;
+
+        // Id the next new row gets. Caller holds write_lock()
+        RowId next_row_id() const;
+
+        // End versions and store checked rows, all stamped with ts. Rows without
+        // an id get the next ones. Caller holds write_lock() and the WriteStamp
+        // of ts; changes are recorded in undo
+        void apply(const std::vector<RowVersion*>& ended, std::vector<Row>&& inserted,
+            uint64_t ts, UndoLog& undo);
+
         //
         // Query methods
         //
@@ -53,13 +182,98 @@ namespace memdb
         void update(const std::unordered_map<std::string, Expression>& assignment, 
             const Expression& where);
 
-        Table* select(const std::vector<std::string>& columns, const Expression& where);
+        // Result tables come from pool if given
+        std::unique_ptr<Table> select(const std::vector<std::string>& columns,
+            const Expression& where, ResultPool* pool = nullptr);
+
+        // Select from the rows visible at snapshot_ts. Caller keeps a ReadView
+        // of that timestamp registered, so versions it sees are not reclaimed.
+        // Rows still projected from another table are not seen
+        std::unique_ptr<Table> select(const std::vector<std::string>& columns,
+            const Expression& where, uint64_t snapshot_ts, ResultPool* pool = nullptr);
 
         void drop(const Expression& where);
 
-        void print(std::ostream& os);
+        // Aligned table of at most max_rows rows, see write_aligned
+        void print(std::ostream& os, size_t max_rows = SIZE_MAX) const;
+
+        // Call f(row, positions) for at most limit rows of the table at the last
+        // published timestamp, projected rows first. Cells of row at positions
+        // are the columns of the table in order
+        void for_each_row(const std::function<void(const Row&, const std::vector<size_t>&)>& f,
+            size_t limit = SIZE_MAX) const;
 
     private:
+        // Rows of the source table a result refers to. The registered snapshot
+        // keeps the versions from being collected, the segment list keeps their
+        // segments from being freed by compaction
+        struct Projection
+        {
+            std::shared_ptr<TransactionManager>     manager_;   // of the source table
+            std::unique_ptr<TransactionManager::ReadView>
+                                                    view_;
+            std::shared_ptr<const SegmentList>      segments_;
+            std::vector<size_t>                     positions_; // source column of every column
+            std::vector<const Row*>                 rows_;      // selection vector
+        };
+
+        // Snapshot reads and writes rows column by column
+        friend class Snapshot;
+        friend class UndoLog;
+
+        // Empty slot of a segment
+        struct Slot
+        {
+            Segment*    segment_;
+            size_t      index_;
+        };
+
+        // Call f for every row of segments visible at snapshot ts until f
+        // returns false, skip segments where rows cannot match where
+        template <typename F>
+        void for_each_visible(const SegmentList& segments, uint64_t ts, F f,
+            const Expression* where = nullptr) const;
+
+        // Call f for every version in segments where rows can match where until
+        // f returns false, skipping slots the compressed columns of sealed
+        // segments rule out. False if f stopped the scan
+        template <typename F>
+        bool for_each_candidate(const SegmentList& segments, const Expression* where, F f) const;
+
+        // for_each_candidate, counting skipped slots into stats unless it is null
+        template <typename F>
+        bool scan_candidates(const SegmentList& segments, const Expression* where, F f,
+            ScanStats* stats) const;
+
+        // Copy projected rows into the table and drop the projection
+        void materialize();
+
+        // Map column names to positions, give STRING columns a dictionary
+        void index_columns();
+
+        // Versions not ended yet, only stable under write_lock()
+        std::vector<RowVersion*> live_versions(const Expression* where = nullptr) const;
+
+        // False if no row of segment can match where, judging by its zone map
+        bool may_match(const Segment& segment, const Expression* where) const;
+
+        // Copy versions of mostly empty segments into dense new ones, return
+        // number of segments released
+        size_t rewrite_sparse_segments();
+
+        // Store a version of row created at ts in a free slot or a new one
+        RowVersion& append(Row&& row, uint64_t ts);
+
+        // Insert a checked row
+        void insert_row(Row&& row);
+
+        // Apply changes of one statement under a timestamp of its own
+        void apply_statement(const std::vector<RowVersion*>& ended, std::vector<Row>&& inserted);
+
+        // Revert changes of a failed batch
+        void undo_append(RowVersion* version);
+        void undo_end(RowVersion* version);
+
         std::string
             name_;          // Table name
 
@@ -69,8 +283,35 @@ namespace memdb
         std::vector<Column>
             columns_;
 
-        std::unordered_map<size_t, std::shared_ptr<Row>> 
-            rows_;          // List of rows
+        std::shared_ptr<TransactionManager>
+            manager_;       // Timestamps of versions
+
+        std::atomic<std::shared_ptr<const SegmentList>>
+            segments_;      // Replaced as a whole when a segment is added
+
+        std::atomic<size_t>
+            size_;          // Number of live rows
+
+        size_t
+            garbage_;       // Ended versions not reclaimed yet
+
+        std::vector<Slot>
+            free_slots_;    // Slots of reclaimed versions, reused first
+
+        std::atomic<uint64_t>
+            compactions_;   // Number of compactions
+
+        RowId
+            next_row_id_;   // Id of the next new row
+
+        std::unique_ptr<Projection>
+            projection_;    // Rows of the table selected from, if not materialized yet
+
+        size_t
+            gc_threshold_;  // Value of garbage_ that triggers collection
+
+        mutable std::shared_mutex
+            mutex_;         // Serialises writers
     };
 } // namespace memdb
 
@@ -0,0 +1,252 @@
+#include "database/transaction.hpp"
+#include "database/database.hpp"
+#include "expression/expression.hpp"
+#include "database/scan_stats.hpp"
+
+namespace memdb
+{
+    Transaction::Transaction(Database& database)
+    : database_(database), view_(*database.transactions())
+    { }
+
+    uint64_t Transaction::snapshot_ts() const
+    {
+        return view_.ts();
+    }
+
+    Transaction::TableWrites& Transaction::writes(const std::shared_ptr<Table>& table, uint64_t compactions)
+    {
+        TableWrites& writes = writes_[table->name()];
+        if (!writes.table_) {
+            writes.table_ = table;
+            writes.compactions_ = compactions;
+        }
+        else if (writes.table_ != table)
+            throw TransactionConflictException(table->name()); // dropped and created again
+
+        return writes;
+    }
+
+    void Transaction::refresh_ended(TableWrites& own)
+    {
+        if (own.table_->compactions() == own.compactions_)
+            return;
+
+        // at the snapshot every id has at most one visible version
+        own.ended_.clear();
+        auto segments = own.table_->segments();
+        for (RowVersion* version : own.table_->visible_versions(view_.ts(), *segments))
+            if (own.ended_ids_.count(version->row_->id()))
+                own.ended_.push_back(version);
+        own.compactions_ = own.table_->compactions();
+    }
+
+    std::vector<RowVersion*> Transaction::visible_versions(const std::shared_ptr<Table>& table,
+        const Expression& where, const SegmentList& segments)
+    {
+        std::vector<RowVersion*> versions = table->visible_versions(view_.ts(), segments, &where);
+
+        auto it = writes_.find(table->name());
+        if (it == writes_.end() || it->second.ended_ids_.empty())
+            return versions;
+
+        std::vector<RowVersion*> remaining;
+        for (RowVersion* version : versions)
+            if (!it->second.ended_ids_.count(version->row_->id()))
+                remaining.push_back(version);
+        return remaining;
+    }
+
+    void Transaction::insert(std::shared_ptr<Table> table, std::vector<Cell>&& data)
+    {
+        table->check_row(data);
+        writes(table, table->compactions()).inserted_.emplace_back(table.get(), std::move(data));
+    }
+
+    void Transaction::insert(std::shared_ptr<Table> table, const std::unordered_map<std::string, Cell>& data)
+    {
+        Row row(table.get(), data);
+        table->check_row(row.cells());
+        writes(table, table->compactions()).inserted_.push_back(std::move(row));
+    }
+
+    void Transaction::update(std::shared_ptr<Table> table,
+        const std::unordered_map<std::string, Expression>& assignment, const Expression& condition)
+    {
+        // type errors are reported before any row is read
+        Expression where = condition.bind_condition(*table);
+        auto set = table->bind_assignment(assignment);
+
+        auto new_cells = [&] (const Row& row) {
+            std::vector<Cell> data = row.cells();
+            for (auto &[position, rhs] : set)
+                data[position] = rhs.evaluate(&row);
+            return data;
+        };
+
+        // the statement is evaluated completely before the write set changes,
+        // segments keep the versions in memory meanwhile
+        uint64_t compactions = table->compactions();
+        auto segments = table->segments();
+        std::vector<std::pair<RowVersion*, std::vector<Cell>>> replaced;
+        for (RowVersion* version : visible_versions(table, where, *segments))
+            if (where.matches(&*version->row_))
+                replaced.emplace_back(version, new_cells(*version->row_));
+        ScanStats::add_matched(replaced.size(), replaced.capacity() * sizeof(replaced[0])
+            + replaced.size() * table->columns().size() * sizeof(Cell));
+
+        TableWrites& own = writes(table, compactions);
+
+        std::vector<std::pair<size_t, std::vector<Cell>>> changed;
+        for (auto i = 0LU; i < own.inserted_.size(); ++i)
+            if (where.matches(&own.inserted_[i]))
+                changed.emplace_back(i, new_cells(own.inserted_[i]));
+
+        for (auto &[i, data] : changed) {
+            RowId id = own.inserted_[i].id();
+            own.inserted_[i] = Row(table.get(), std::move(data));
+            own.inserted_[i].set_id(id);
+        }
+
+        for (auto &[version, data] : replaced) {
+            own.ended_.push_back(version);
+            own.ended_ids_.insert(version->row_->id());
+            own.inserted_.emplace_back(table.get(), std::move(data));
+            own.inserted_.back().set_id(version->row_->id());
+        }
+    }
+
+    void Transaction::drop(std::shared_ptr<Table> table, const Expression& condition)
+    {
+        // type errors are reported before any row is read
+        Expression where = condition.bind_condition(*table);
+        uint64_t compactions = table->compactions();
+        auto segments = table->segments();
+        std::vector<RowVersion*> dropped;
+        for (RowVersion* version : visible_versions(table, where, *segments))
+            if (where.matches(&*version->row_))
+                dropped.push_back(version);
+        ScanStats::add_matched(dropped.size(), dropped.capacity() * sizeof(RowVersion*));
+
+        std::vector<bool> keep;
+        auto it = writes_.find(table->name());
+        if (it != writes_.end() && it->second.table_ == table)
+            for (auto& row : it->second.inserted_)
+                keep.push_back(!where.matches(&row));
+
+        TableWrites& own = writes(table, compactions);
+
+        std::vector<Row> kept;
+        for (auto i = 0LU; i < keep.size(); ++i)
+            if (keep[i])
+                kept.push_back(std::move(own.inserted_[i]));
+        own.inserted_ = std::move(kept);
+
+        for (RowVersion* version : dropped) {
+            own.ended_.push_back(version);
+            own.ended_ids_.insert(version->row_->id());
+        }
+    }
+
+    std::unique_ptr<Table> Transaction::select(std::shared_ptr<Table> table,
+        const std::vector<std::string>& columns, const Expression& condition, ResultPool* pool)
+    {
+        // type errors are reported before any row is read
+        Expression where = condition.bind_condition(*table);
+
+        // rows of the snapshot are projected, not copied
+        auto segments = table->segments();
+        std::vector<const Row*> rows;
+        for (RowVersion* version : visible_versions(table, where, *segments))
+            if (where.matches(&*version->row_))
+                rows.push_back(&*version->row_);
+        ScanStats::add_matched(rows.size(), rows.capacity() * sizeof(const Row*));
+
+        std::unique_ptr<Table> res = table->project(columns, std::move(rows), segments, view_.ts(), pool);
+
+        // own rows may change before commit, the result gets copies
+        auto it = writes_.find(table->name());
+        if (it != writes_.end() && it->second.table_ == table)
+            for (auto& row : it->second.inserted_)
+            {
+                if (!where.matches(&row))
+                    continue;
+
+                std::vector<Cell> res_row(columns.size());
+                for (auto i = 0LU; i < columns.size(); ++i)
+                    res_row[i] = row[table->column_position(columns[i])];
+                res->insert(std::move(res_row));
+            }
+
+        return res;
+    }
+
+    bool Transaction::changes(const std::shared_ptr<Table>& table) const
+    {
+        auto it = writes_.find(table->name());
+        return it != writes_.end() && it->second.table_ == table
+            && (!it->second.ended_.empty() || !it->second.inserted_.empty());
+    }
+
+    void Transaction::commit()
+    {
+        // statements that matched nothing leave no reason to lock a table
+        std::erase_if(writes_, [] (auto& entry) {
+            return entry.second.ended_.empty() && entry.second.inserted_.empty();
+        });
+
+        if (writes_.empty())
+            return;
+
+        // a table dropped meanwhile takes the changes with it, as for a single statement
+        for (auto &[name, own] : writes_)
+            if (database_.get_table(name) != own.table_)
+                throw TransactionConflictException(name);
+
+        std::vector<std::unique_lock<std::shared_mutex>> locks;
+        for (auto &[name, own] : writes_)
+            locks.push_back(own.table_->write_lock());
+
+        // first committer wins: every replaced version must still be the latest one
+        for (auto &[name, own] : writes_) {
+            refresh_ended(own);
+            for (RowVersion* version : own.ended_)
+                if (!version->live())
+                    throw TransactionConflictException(name);
+        }
+
+        // new rows get their ids now, so the log record names every row it touches
+        std::vector<WalTableChanges> changes;
+        for (auto &[name, own] : writes_)
+        {
+            RowId next_id = own.table_->next_row_id();
+
+            WalTableChanges table{name, {}, {}};
+            for (RowVersion* version : own.ended_)
+                table.removed_.push_back(version->row_->id());
+            for (auto& row : own.inserted_) {
+                if (row.id() == 0)
+                    row.set_id(next_id++);
+                table.inserted_.push_back(&row);
+            }
+            changes.push_back(std::move(table));
+        }
+        uint64_t lsn = database_.log(WalRecord::transaction(changes));
+
+        {
+            TransactionManager::WriteStamp stamp(*database_.transactions());
+            UndoLog undo;
+            for (auto &[name, own] : writes_)
+                own.table_->apply(own.ended_, std::move(own.inserted_), stamp.ts(), undo);
+            undo.release();
+        }
+
+        for (auto &[name, own] : writes_)
+            own.table_->collect_garbage_if_needed();
+
+        writes_.clear();
+        locks.clear();
+
+        database_.commit(lsn);
+    }
+} // namespace memdb
@@ -0,0 +1,97 @@
+#ifndef HEADER_GUARD_DATABASE_TRANSACTION_H
+#define HEADER_GUARD_DATABASE_TRANSACTION_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <unordered_map>
+
+#include "database/table.hpp"
+#include "database/transaction_manager.hpp"
+
+namespace memdb
+{
+    class Database;
+
+    /*
+        Multi-statement transaction with snapshot isolation.
+
+        All statements read the snapshot taken at BEGIN together with the
+        transaction's own changes. Changes are buffered in a private write set
+        per table and touch no table until commit.
+
+        Commit is optimistic: with the write locks of all written tables held
+        (taken once each, in name order) it checks that no version the
+        transaction replaces was ended by someone else since the snapshot,
+        then applies the whole write set under one write timestamp, so other
+        readers see all of it or nothing. A conflict aborts the transaction.
+    */
+    class Transaction
+    {
+    public:
+        Transaction(Database& database);
+
+        Transaction(const Transaction& other)               = delete;
+        Transaction& operator= (const Transaction& other)   = delete;
+
+        uint64_t snapshot_ts() const;
+
+        //
+        // Statements, buffered in the write set
+        //
+
+        void insert(std::shared_ptr<Table> table, std::vector<Cell>&& data);
+        void insert(std::shared_ptr<Table> table, const std::unordered_map<std::string, Cell>& data);
+
+        void update(std::shared_ptr<Table> table,
+            const std::unordered_map<std::string, Expression>& assignment, const Expression& where);
+
+        void drop(std::shared_ptr<Table> table, const Expression& where);
+
+        // Result table of the selected rows as the transaction sees them,
+        // from pool if given
+        std::unique_ptr<Table> select(std::shared_ptr<Table> table,
+            const std::vector<std::string>& columns, const Expression& where,
+            ResultPool* pool = nullptr);
+
+        // True if the write set holds changes to table
+        bool changes(const std::shared_ptr<Table>& table) const;
+
+        // Validate and apply the write set, throw TransactionConflictException if
+        // another transaction changed the same rows first. Transaction cannot be used afterwards
+        void commit();
+
+    private:
+        // Changes to one table
+        struct TableWrites
+        {
+            std::shared_ptr<Table>          table_;
+            std::vector<RowVersion*>        ended_;     // snapshot versions deleted or replaced
+            std::unordered_set<RowId>       ended_ids_;
+            std::vector<Row>                inserted_;  // new rows, may change again before commit
+            uint64_t                        compactions_;   // of the table when ended_ was started
+        };
+
+        // Write set of table. compactions is the table's count read before
+        // the versions the statement ends were looked up
+        TableWrites& writes(const std::shared_ptr<Table>& table, uint64_t compactions);
+
+        // Look ended versions up again by id if the table was compacted since
+        void refresh_ended(TableWrites& own);
+
+        // Snapshot versions of segments the transaction has not ended yet, where
+        // they may match. The caller holds segments while it uses the versions
+        std::vector<RowVersion*> visible_versions(const std::shared_ptr<Table>& table,
+            const Expression& where, const SegmentList& segments);
+
+        Database&                       database_;
+        TransactionManager::ReadView    view_;
+
+        std::map<std::string, TableWrites>
+            writes_;    // ordered by table name, the order tables are locked in
+    };
+} // namespace memdb
+
+#endif // HEADER_GUARD_DATABASE_TRANSACTION_H
@@ -0,0 +1,85 @@
+#include "database/transaction_manager.hpp"
+
+#include <algorithm>
+
+namespace memdb
+{
+    TransactionManager::TransactionManager()
+    : clock_(0), committed_(0)
+    { }
+
+    TransactionManager::ReadView::ReadView(TransactionManager& manager)
+    : manager_(manager), ts_(manager.register_reader())
+    { }
+
+    TransactionManager::ReadView::ReadView(TransactionManager& manager, uint64_t ts)
+    : manager_(manager), ts_(ts)
+    {
+        manager.register_reader(ts);
+    }
+
+    TransactionManager::ReadView::~ReadView()
+    {
+        manager_.unregister_reader(ts_);
+    }
+
+    TransactionManager::WriteStamp::WriteStamp(TransactionManager& manager)
+    : manager_(manager), ts_(++manager.clock_)
+    { }
+
+    TransactionManager::WriteStamp::~WriteStamp()
+    {
+        manager_.publish(ts_);
+    }
+
+    uint64_t TransactionManager::last_committed() const
+    {
+        return committed_;
+    }
+
+    uint64_t TransactionManager::oldest_snapshot()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // read under the lock, so a reader registering meanwhile is not missed
+        uint64_t oldest = committed_;
+        if (!readers_.empty())
+            oldest = std::min(oldest, readers_.begin()->first);
+        return oldest;
+    }
+
+    uint64_t TransactionManager::register_reader()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        uint64_t ts = committed_;
+        readers_[ts]++;
+        return ts;
+    }
+
+    void TransactionManager::register_reader(uint64_t ts)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        readers_[ts]++;
+    }
+
+    void TransactionManager::unregister_reader(uint64_t ts)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto it = readers_.find(ts);
+        if (--it->second == 0)
+            readers_.erase(it);
+    }
+
+    void TransactionManager::publish(uint64_t ts)
+    {
+        // wait for all earlier writes, they may run on other tables
+        uint64_t committed;
+        while ((committed = committed_) != ts - 1)
+            committed_.wait(committed);
+
+        committed_ = ts;
+        committed_.notify_all();
+    }
+} // namespace memdb
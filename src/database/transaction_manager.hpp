@@ -0,0 +1,90 @@
+#ifndef HEADER_GUARD_DATABASE_TRANSACTION_MANAGER_H
+#define HEADER_GUARD_DATABASE_TRANSACTION_MANAGER_H
+
+#include <atomic>
+#include <mutex>
+#include <map>
+#include <cstdint>
+
+#define TIMESTAMP_INFINITY UINT64_MAX
+
+namespace memdb
+{
+    /*
+        Source of timestamps for multi-version tables.
+
+        Every write gets the next timestamp of the clock and stamps the versions it
+        creates and ends with it. The timestamp is published, i.e. becomes visible
+        to readers, when the write is done, strictly in the order timestamps were
+        handed out: a reader that takes the last published timestamp as its snapshot
+        sees every earlier write completely and no part of a later one.
+
+        Active read snapshots are registered, so the oldest of them tells which
+        ended versions no reader can see anymore.
+    */
+    class TransactionManager
+    {
+    public:
+        TransactionManager();
+
+        TransactionManager(const TransactionManager& other)             = delete;
+        TransactionManager& operator= (const TransactionManager& other) = delete;
+
+        // Registered snapshot of the last published timestamp
+        class ReadView
+        {
+        public:
+            ReadView(TransactionManager& manager);
+
+            // Another registration of ts, which a live ReadView already holds
+            ReadView(TransactionManager& manager, uint64_t ts);
+            ~ReadView();
+
+            ReadView(const ReadView& other)             = delete;
+            ReadView& operator= (const ReadView& other) = delete;
+
+            uint64_t ts() const { return ts_; }
+
+        private:
+            TransactionManager& manager_;
+            uint64_t            ts_;
+        };
+
+        // Timestamp of one write, published when destroyed
+        class WriteStamp
+        {
+        public:
+            WriteStamp(TransactionManager& manager);
+            ~WriteStamp();
+
+            WriteStamp(const WriteStamp& other)             = delete;
+            WriteStamp& operator= (const WriteStamp& other) = delete;
+
+            uint64_t ts() const { return ts_; }
+
+        private:
+            TransactionManager& manager_;
+            uint64_t            ts_;
+        };
+
+        // Last published timestamp
+        uint64_t last_committed() const;
+
+        // Versions that ended at or before this timestamp are invisible to every reader
+        uint64_t oldest_snapshot();
+
+    private:
+        uint64_t register_reader();
+        void register_reader(uint64_t ts);
+        void unregister_reader(uint64_t ts);
+        void publish(uint64_t ts);
+
+        std::atomic<uint64_t>   clock_;         // last handed out timestamp
+        std::atomic<uint64_t>   committed_;     // last published timestamp, notified on change
+
+        std::mutex                  mutex_;
+        std::map<uint64_t, size_t>  readers_;   // snapshot timestamp to number of readers
+    };
+} // namespace memdb
+
+#endif // HEADER_GUARD_DATABASE_TRANSACTION_MANAGER_H
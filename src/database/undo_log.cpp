@@ -0,0 +1,37 @@
+#include "database/undo_log.hpp"
+#include "database/table.hpp"
+
+namespace memdb
+{
+    UndoLog::~UndoLog()
+    {
+        rollback();
+    }
+
+    void UndoLog::appended(Table* table, RowVersion* version)
+    {
+        entries_.push_back({table, version, true});
+    }
+
+    void UndoLog::ended(Table* table, RowVersion* version)
+    {
+        entries_.push_back({table, version, false});
+    }
+
+    void UndoLog::rollback()
+    {
+        for (auto it = entries_.rbegin(); it != entries_.rend(); ++it)
+        {
+            if (it->appended_)
+                it->table_->undo_append(it->version_);
+            else
+                it->table_->undo_end(it->version_);
+        }
+        entries_.clear();
+    }
+
+    void UndoLog::release()
+    {
+        entries_.clear();
+    }
+} // namespace memdb
@@ -0,0 +1,49 @@
+#ifndef HEADER_GUARD_DATABASE_UNDO_LOG_H
+#define HEADER_GUARD_DATABASE_UNDO_LOG_H
+
+#include <vector>
+
+#include "database/segment.hpp"
+
+namespace memdb
+{
+    class Table;
+
+    /*
+        Changes made to tables under a write timestamp that is not published yet.
+
+        If applying a batch fails halfway, the changes already made are reverted
+        before the timestamp is published, so readers never see any of them.
+        Destroying the log without release() rolls it back.
+    */
+    class UndoLog
+    {
+    public:
+        UndoLog() = default;
+        ~UndoLog();
+
+        UndoLog(const UndoLog& other)               = delete;
+        UndoLog& operator= (const UndoLog& other)   = delete;
+
+        void appended(Table* table, RowVersion* version);
+        void ended(Table* table, RowVersion* version);
+
+        // Revert all recorded changes, latest first
+        void rollback();
+
+        // Keep the changes
+        void release();
+
+    private:
+        struct Entry
+        {
+            Table*      table_;
+            RowVersion* version_;
+            bool        appended_;  // otherwise ended
+        };
+
+        std::vector<Entry> entries_;
+    };
+} // namespace memdb
+
+#endif // HEADER_GUARD_DATABASE_UNDO_LOG_H
@@ -0,0 +1,51 @@
+#include "database/zone_map.hpp"
+
+#include <limits>
+
+namespace memdb
+{
+    static bool has_range(CellType type)
+    {
+        return type == CellType::INT32 || type == CellType::BOOL;
+    }
+
+    static int32_t range_value(const Cell& cell)
+    {
+        return cell.get_type() == CellType::INT32 ? cell.get_int() : cell.get_bool();
+    }
+
+    ZoneMap::ZoneMap(const std::vector<Column>& columns)
+    : min_(new std::atomic<int32_t>[columns.size()]), max_(new std::atomic<int32_t>[columns.size()])
+    {
+        for (auto i = 0LU; i < columns.size(); ++i) {
+            types_.push_back(columns[i].type_);
+            min_[i] = std::numeric_limits<int32_t>::max();
+            max_[i] = std::numeric_limits<int32_t>::min();
+        }
+    }
+
+    void ZoneMap::add(const Row& row)
+    {
+        for (auto i = 0LU; i < types_.size(); ++i)
+        {
+            if (!has_range(types_[i]))
+                continue;
+
+            int32_t value = range_value(row[i]);
+            if (value < min_[i])
+                min_[i] = value;
+            if (value > max_[i])
+                max_[i] = value;
+        }
+    }
+
+    bool ZoneMap::range(size_t position, int32_t& min, int32_t& max) const
+    {
+        if (position >= types_.size() || !has_range(types_[position]))
+            return false;
+
+        min = min_[position];
+        max = max_[position];
+        return true;
+    }
+} // namespace memdb
@@ -0,0 +1,44 @@
+#ifndef HEADER_GUARD_DATABASE_ZONE_MAP_H
+#define HEADER_GUARD_DATABASE_ZONE_MAP_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+#include "database/row.hpp"
+#include "database/column.hpp"
+
+namespace memdb
+{
+    /*
+        Minimum and maximum of every INT32 and BOOL column over all rows ever
+        stored in a segment (row group).
+
+        Bounds only widen, deleted rows stay covered until the segment is
+        rewritten by compaction. The single writer widens them before the row
+        is published, so a reader never sees a visible row outside the bounds.
+    */
+    class ZoneMap
+    {
+    public:
+        ZoneMap(const std::vector<Column>& columns);
+
+        ZoneMap(const ZoneMap& other)               = delete;
+        ZoneMap& operator= (const ZoneMap& other)   = delete;
+
+        // Widen the bounds to cover row
+        void add(const Row& row);
+
+        // Bounds of the column at position, false if the column type has none.
+        // min > max while no row was added
+        bool range(size_t position, int32_t& min, int32_t& max) const;
+
+    private:
+        std::vector<CellType>                       types_;
+        std::unique_ptr<std::atomic<int32_t>[]>     min_;
+        std::unique_ptr<std::atomic<int32_t>[]>     max_;
+    };
+} // namespace memdb
+
+#endif // HEADER_GUARD_DATABASE_ZONE_MAP_H
@@ -1,4 +1,8 @@
 #include "expression/expression.hpp"
+#include "storage/codec.hpp"
+
+#include <limits>
+#include <algorithm>
 
 namespace memdb
 {
@@ -7,13 +11,53 @@ namespace memdb
     : root_(root)
     { }
 
-    Cell Expression::evaluate(Row* row) const
+    Cell Expression::evaluate(const Row* row) const
     {
         if (!row) return false;
         if (!root_) return true;
         return root_->evaluate(row);
     }
 
+    bool Expression::matches(const Row* row) const
+    {
+        return !root_ || root_->evaluate_bool(row);
+    }
+
+    CellType Expression::type() const
+    {
+        return root_ ? root_->type() : CellType::BOOL;
+    }
+
+    bool Expression::may_match(const Table& table, const ZoneMap& zone) const
+    {
+        if (!root_) return true;
+        return root_->may_be_true(table, zone);
+    }
+
+    bool Expression::candidates(const Table& table, const SealedColumns& sealed, SlotMask& mask) const
+    {
+        return root_ && root_->candidates(table, sealed, mask);
+    }
+
+    Expression Expression::bind(const Table& table) const
+    {
+        return root_ ? Expression(root_->bind(table)) : *this;
+    }
+
+    Expression Expression::bind_condition(const Table& table) const
+    {
+        Expression bound = bind(table);
+        if (bound.type() != CellType::BOOL)
+            throw IncorrectWhereStatementException();
+        return bound;
+    }
+
+    Expression Expression::bind_parameters(const std::vector<Cell>& values) const
+    {
+        ExpressionNodePointer root = root_ ? root_->bind_parameters(values) : nullptr;
+        return root ? Expression(root) : *this;
+    }
+
     static const std::unordered_map<Operation, std::string>
         op_to_str = {
             { ADD, "+"},
@@ -50,14 +94,42 @@ namespace memdb
         lhs_(std::move(lhs)), rhs_(std::move(rhs)), op_(op)
     { }
 
-    Cell ValueExpression::evaluate(Row* row)
+    Cell ValueExpression::evaluate(const Row* row)
     {
+        if (position_ != unbound)
+            return (*row)[position_];
+
         Table* table = row->get_table();
         return (*row)[table->column_position(column_name_)];
     }
 
-    Cell UnaryExpression::evaluate(Row* row)
+    Int32 ValueExpression::evaluate_int(const Row* row)
+    {
+        return position_ != unbound ? (*row)[position_].int_value() : evaluate(row).get_int();
+    }
+
+    Bool ValueExpression::evaluate_bool(const Row* row)
+    {
+        return position_ != unbound ? (*row)[position_].bool_value() : evaluate(row).get_bool();
+    }
+
+    Int32 ExpressionNode::evaluate_int(const Row* row)
+    {
+        return evaluate(row).get_int();
+    }
+
+    Bool ExpressionNode::evaluate_bool(const Row* row)
     {
+        return evaluate(row).get_bool();
+    }
+
+    Cell UnaryExpression::evaluate(const Row* row)
+    {
+        if (kernel_ == IntKernel)
+            return Cell(evaluate_int(row));
+        if (kernel_ == BoolKernel)
+            return Cell(evaluate_bool(row));
+
         switch (op_)
         {
         case NEG:   return -(lhs_->evaluate(row));
@@ -67,8 +139,29 @@ namespace memdb
         }
     }
 
-    Cell BinaryExpression::evaluate(Row* row)
+    Int32 UnaryExpression::evaluate_int(const Row* row)
     {
+        if (kernel_ != IntKernel)
+            return ExpressionNode::evaluate_int(row);
+
+        Int32 value = lhs_->evaluate_int(row);
+        return op_ == NEG ? -value : ~value;
+    }
+
+    Bool UnaryExpression::evaluate_bool(const Row* row)
+    {
+        if (kernel_ != BoolKernel)
+            return ExpressionNode::evaluate_bool(row);
+
+        // ! and ~ are both negation for Bool
+        return !lhs_->evaluate_bool(row);
+    }
+
+    Cell BinaryExpression::evaluate(const Row* row)
+    {
+        if (kernel_ != GenericKernel)
+            return type_ == CellType::INT32 ? Cell(evaluate_int(row)) : Cell(evaluate_bool(row));
+
         switch (op_)
         {
         case ADD:   return (lhs_->evaluate(row)) +  (rhs_->evaluate(row));
@@ -91,14 +184,536 @@ namespace memdb
         }
     }
 
+    Int32 BinaryExpression::evaluate_int(const Row* row)
+    {
+        if (kernel_ != IntKernel || type_ != CellType::INT32)
+            return ExpressionNode::evaluate_int(row);
+
+        Int32 lhs = lhs_->evaluate_int(row);
+        Int32 rhs = rhs_->evaluate_int(row);
+        switch (op_)
+        {
+        case ADD:   return lhs + rhs;
+        case SUB:   return lhs - rhs;
+        case MUL:   return lhs * rhs;
+        case XOR:   return lhs ^ rhs;
+        case BAND:  return lhs & rhs;
+        case BOR:   return lhs | rhs;
+        case DIV:
+            if (!rhs)
+                throw DivisionByZeroException();
+            return lhs / rhs;
+        default:
+            if (!rhs)
+                throw DivisionByZeroException();
+            return lhs % rhs;
+        }
+    }
+
+    Bool BinaryExpression::evaluate_bool(const Row* row)
+    {
+        if (kernel_ == IntKernel)
+        {
+            Int32 lhs = lhs_->evaluate_int(row);
+            Int32 rhs = rhs_->evaluate_int(row);
+            switch (op_)
+            {
+            case  EQ:   return lhs == rhs;
+            case NEQ:   return lhs != rhs;
+            case  LE:   return lhs <  rhs;
+            case LEQ:   return lhs <= rhs;
+            case  GR:   return lhs >  rhs;
+            case GEQ:   return lhs >= rhs;
+            default:    return ExpressionNode::evaluate_bool(row);
+            }
+        }
+
+        if (kernel_ == BoolKernel)
+        {
+            // both sides are evaluated, as the Cell operators do
+            Bool lhs = lhs_->evaluate_bool(row);
+            Bool rhs = rhs_->evaluate_bool(row);
+            switch (op_)
+            {
+            case AND:   return lhs && rhs;
+            case  OR:   return lhs || rhs;
+            case XOR: case NEQ:
+                        return lhs != rhs;
+            case BAND:  return lhs && rhs;
+            case BOR:   return lhs || rhs;
+            case  EQ:   return lhs == rhs;
+            case  LE:   return lhs <  rhs;
+            case LEQ:   return lhs <= rhs;
+            case  GR:   return lhs >  rhs;
+            default:    return lhs >= rhs;
+            }
+        }
+
+        return ExpressionNode::evaluate_bool(row);
+    }
+
 
     ConstExpression::ConstExpression(const Cell& data) :
     data_(data)
     { }
 
-    Cell ConstExpression::evaluate(Row* row)
+    Cell ConstExpression::evaluate(const Row* row)
     {
         (void)row;
         return data_;
-    } 
-} // namespace memdb
\ No newline at end of file
+    }
+
+    Int32 ConstExpression::evaluate_int(const Row* row)
+    {
+        (void)row;
+        return data_.get_int();
+    }
+
+    Bool ConstExpression::evaluate_bool(const Row* row)
+    {
+        (void)row;
+        return data_.get_bool();
+    }
+
+
+    //
+    // Pruning by zone maps
+    //
+
+    bool ExpressionNode::may_be_true(const Table& table, const ZoneMap& zone) const
+    {
+        (void)table;
+        (void)zone;
+        return true;
+    }
+
+    // Operation with swapped operands: 5 < a is a > 5
+    static Operation mirror(Operation op)
+    {
+        switch (op)
+        {
+        case  LE:   return GR;
+        case LEQ:   return GEQ;
+        case  GR:   return LE;
+        case GEQ:   return LEQ;
+        default:    return op;
+        }
+    }
+
+    bool BinaryExpression::may_be_true(const Table& table, const ZoneMap& zone) const
+    {
+        switch (op_)
+        {
+        case AND:   return lhs_->may_be_true(table, zone) && rhs_->may_be_true(table, zone);
+        case  OR:   return lhs_->may_be_true(table, zone) || rhs_->may_be_true(table, zone);
+        case  EQ: case NEQ: case LE: case LEQ: case GR: case GEQ:
+            break;
+        default:    return true;
+        }
+
+        // only a column compared with a constant is judged, bind gave them
+        // one type. Everything else is left to evaluate
+        Operation op = op_;
+        auto column = dynamic_cast<const ValueExpression*>(lhs_.get());
+        auto constant = dynamic_cast<const ConstExpression*>(rhs_.get());
+        if (!column || !constant) {
+            column = dynamic_cast<const ValueExpression*>(rhs_.get());
+            constant = dynamic_cast<const ConstExpression*>(lhs_.get());
+            op = mirror(op);
+        }
+        if (!column || !constant)
+            return true;
+
+        int32_t min, max;
+        const Cell& value = constant->value();
+        if (!zone.range(column->position(), min, max))
+            return true;
+
+        if (min > max)
+            return false;   // no rows
+
+        int32_t x = value.get_type() == CellType::INT32 ? value.get_int() : value.get_bool();
+        switch (op)
+        {
+        case  EQ:   return min <= x && x <= max;
+        case NEQ:   return min != x || max != x;
+        case  LE:   return min < x;
+        case LEQ:   return min <= x;
+        case  GR:   return max > x;
+        default:    return max >= x;
+        }
+    }
+
+    bool ExpressionNode::candidates(const Table& table, const SealedColumns& sealed, SlotMask& mask) const
+    {
+        (void)table;
+        (void)sealed;
+        (void)mask;
+        return false;
+    }
+
+    bool BinaryExpression::candidates(const Table& table, const SealedColumns& sealed, SlotMask& mask) const
+    {
+        if (op_ == AND || op_ == OR)
+        {
+            SlotMask rhs_mask;
+            bool lhs = lhs_->candidates(table, sealed, mask);
+            bool rhs = rhs_->candidates(table, sealed, rhs_mask);
+
+            // either side narrows a conjunction, a disjunction needs both
+            if (op_ == AND && lhs && rhs)
+                for (auto w = 0LU; w < mask.size(); ++w)
+                    mask[w] &= rhs_mask[w];
+            else if (op_ == AND && rhs)
+                mask = rhs_mask;
+            else if (op_ == OR && lhs && rhs)
+                for (auto w = 0LU; w < mask.size(); ++w)
+                    mask[w] |= rhs_mask[w];
+            else if (op_ == OR)
+                return false;
+
+            return lhs || rhs;
+        }
+
+        Operation op = op_;
+        auto column = dynamic_cast<const ValueExpression*>(lhs_.get());
+        auto constant = dynamic_cast<const ConstExpression*>(rhs_.get());
+        if (!column || !constant) {
+            column = dynamic_cast<const ValueExpression*>(rhs_.get());
+            constant = dynamic_cast<const ConstExpression*>(lhs_.get());
+            op = mirror(op);
+        }
+        if (!column || !constant || !constant->value().is_int())
+            return false;
+
+        const CompressedColumn* compressed = sealed[column->position()].get();
+        if (!compressed)
+            return false;
+
+        // values making the comparison true, != is the two ranges around x
+        int64_t x = constant->value().get_int();
+        int64_t min = std::numeric_limits<int32_t>::min(), max = std::numeric_limits<int32_t>::max();
+        mask.fill(0);
+
+        switch (op)
+        {
+        case  EQ:   compressed->select(x, x, mask.data()); return true;
+        case NEQ:
+            compressed->select(min, x - 1, mask.data());
+            compressed->select(x + 1, max, mask.data());
+            return true;
+        case  LE:   compressed->select(min, x - 1, mask.data()); return true;
+        case LEQ:   compressed->select(min, x, mask.data()); return true;
+        case  GR:   compressed->select(x + 1, max, mask.data()); return true;
+        case GEQ:   compressed->select(x, max, mask.data()); return true;
+        default:    return false;
+        }
+    }
+
+    //
+    // Binding to a table
+    //
+
+    static bool is_comparison(Operation op)
+    {
+        return op == EQ || op == NEQ || op == LE || op == LEQ || op == GR || op == GEQ;
+    }
+
+    ExpressionNodePointer ValueExpression::bind(const Table& table) const
+    {
+        auto bound = std::make_shared<ValueExpression>(column_name_);
+        try {
+            bound->position_ = table.column_position(column_name_);
+        }
+        catch (std::out_of_range&) {
+            throw UnexistingColumnException(column_name_);
+        }
+        bound->type_ = table.columns()[bound->position_].type_;
+        return bound;
+    }
+
+    ExpressionNodePointer ConstExpression::bind(const Table& table) const
+    {
+        (void)table;
+        auto bound = std::make_shared<ConstExpression>(data_);
+        bound->type_ = data_.get_type();
+        return bound;
+    }
+
+    ExpressionNodePointer UnaryExpression::bind(const Table& table) const
+    {
+        auto bound = std::make_shared<UnaryExpression>(lhs_->bind(table), op_);
+        CellType type = bound->lhs_->type();
+
+        // the rules of the Cell operators, checked once for all rows
+        bool valid = false;
+        switch (op_)
+        {
+        case NEG:   valid = type == CellType::INT32; break;
+        case NOT:   valid = type == CellType::BOOL; break;
+        case BNEG:  valid = type != CellType::STRING; break;
+        default:    throw InvaludNumberOfOperandsException(op_to_str.at(op_));
+        }
+        if (!valid)
+            throw IncompatibleTypeOperatorException(op_to_str.at(op_), type_name(type));
+
+        bound->type_ = type;
+        if (type == CellType::INT32)
+            bound->kernel_ = IntKernel;
+        else if (type == CellType::BOOL)
+            bound->kernel_ = BoolKernel;
+        return bound;
+    }
+
+    ExpressionNodePointer BinaryExpression::bind(const Table& table) const
+    {
+        ExpressionNodePointer lhs = lhs_->bind(table);
+        ExpressionNodePointer rhs = rhs_->bind(table);
+        CellType lhs_type = lhs->type(), rhs_type = rhs->type();
+        const std::string& op = op_to_str.at(op_);
+
+        // the rules of the Cell operators, checked once for all rows
+        auto allow = [&] (std::initializer_list<CellType> types) {
+            for (CellType type : {lhs_type, rhs_type})
+                if (std::find(types.begin(), types.end(), type) == types.end())
+                    throw IncompatibleTypeOperatorException(op, type_name(type));
+            if (lhs_type != rhs_type)
+                throw DifferentTypesException(op);
+        };
+
+        switch (op_)
+        {
+        case SUB: case MUL: case DIV: case MOD:
+            allow({CellType::INT32}); break;
+        case ADD:
+            allow({CellType::INT32, CellType::STRING}); break;
+        case AND: case OR:
+            allow({CellType::BOOL}); break;
+        case XOR: case BAND: case BOR:
+            allow({CellType::INT32, CellType::BOOL, CellType::BYTES}); break;
+        default:
+            if (lhs_type != rhs_type)
+                throw DifferentTypesException(op);
+        }
+
+        if ((op_ == EQ || op_ == NEQ) && lhs_type == CellType::STRING)
+        {
+            // a string compared with a column becomes an entry of its dictionary,
+            // a value missing from the dictionary is compared as it is
+            for (auto [column, constant] : {std::pair(lhs, &rhs), std::pair(rhs, &lhs)})
+            {
+                auto value = dynamic_cast<const ValueExpression*>(column.get());
+                auto data = dynamic_cast<const ConstExpression*>(constant->get());
+                if (!value || !data)
+                    continue;
+
+                auto& dictionary = table.columns()[value->position()].dictionary_;
+                if (dictionary)
+                    *constant = ConstExpression(dictionary->find(data->value())).bind(table);
+                break;
+            }
+        }
+
+        auto bound = std::make_shared<BinaryExpression>(lhs, rhs, op_);
+        bound->type_ = is_comparison(op_) ? CellType::BOOL : lhs_type;
+        if (lhs_type == CellType::INT32)
+            bound->kernel_ = IntKernel;
+        else if (lhs_type == CellType::BOOL)
+            bound->kernel_ = BoolKernel;
+        return bound;
+    }
+
+    //
+    // Parameters of prepared statements
+    //
+
+    ParameterExpression::ParameterExpression(size_t index)
+    : index_(index)
+    { }
+
+    Cell ParameterExpression::evaluate(const Row* row)
+    {
+        (void)row;
+        throw UnboundParameterException(index_ + 1);
+    }
+
+    ExpressionNodePointer ParameterExpression::bind(const Table& table) const
+    {
+        (void)table;
+        throw UnboundParameterException(index_ + 1);
+    }
+
+    ExpressionNodePointer ExpressionNode::bind_parameters(const std::vector<Cell>& values) const
+    {
+        (void)values;
+        return nullptr;
+    }
+
+    ExpressionNodePointer ParameterExpression::bind_parameters(const std::vector<Cell>& values) const
+    {
+        if (index_ >= values.size())
+            throw UnboundParameterException(index_ + 1);
+        return std::make_shared<ConstExpression>(values[index_]);
+    }
+
+    ExpressionNodePointer UnaryExpression::bind_parameters(const std::vector<Cell>& values) const
+    {
+        ExpressionNodePointer lhs = lhs_->bind_parameters(values);
+        return lhs ? std::make_shared<UnaryExpression>(lhs, op_) : nullptr;
+    }
+
+    ExpressionNodePointer BinaryExpression::bind_parameters(const std::vector<Cell>& values) const
+    {
+        ExpressionNodePointer lhs = lhs_->bind_parameters(values);
+        ExpressionNodePointer rhs = rhs_->bind_parameters(values);
+        if (!lhs && !rhs)
+            return nullptr;
+        return std::make_shared<BinaryExpression>(lhs ? lhs : lhs_, rhs ? rhs : rhs_, op_);
+    }
+
+    //
+    // Query syntax, for EXPLAIN
+    //
+
+    std::string Expression::text() const
+    {
+        return root_ ? root_->text() : "";
+    }
+
+    // Operand of an operator, parenthesized unless it is a leaf
+    static std::string operand_text(const ExpressionNodePointer& node)
+    {
+        std::string text = node->text();
+        bool leaf = dynamic_cast<const UnaryExpression*>(node.get()) == nullptr
+            && dynamic_cast<const BinaryExpression*>(node.get()) == nullptr;
+        return leaf ? text : "(" + text + ")";
+    }
+
+    std::string ValueExpression::text() const
+    {
+        return column_name_;
+    }
+
+    std::string ConstExpression::text() const
+    {
+        if (data_.is_string())
+            return "\"" + data_.get_string() + "\"";
+        return data_.ToString();
+    }
+
+    std::string ParameterExpression::text() const
+    {
+        return "$" + std::to_string(index_ + 1);
+    }
+
+    std::string UnaryExpression::text() const
+    {
+        return op_to_str.at(op_) + operand_text(lhs_);
+    }
+
+    std::string BinaryExpression::text() const
+    {
+        return operand_text(lhs_) + " " + op_to_str.at(op_) + " " + operand_text(rhs_);
+    }
+
+    //
+    // Binary encoding
+    //
+
+    enum ExpressionTag
+    {
+        EmptyTag, ValueTag, ConstTag, UnaryTag, BinaryTag
+    };
+
+    void Expression::encode(Encoder& out) const
+    {
+        if (!root_) {
+            out.put<uint8_t>(EmptyTag);
+            return;
+        }
+        root_->encode(out);
+    }
+
+    void ValueExpression::encode(Encoder& out) const
+    {
+        out.put<uint8_t>(ValueTag);
+        out.put_string(column_name_);
+    }
+
+    void ConstExpression::encode(Encoder& out) const
+    {
+        out.put<uint8_t>(ConstTag);
+        out.put_cell(data_);
+    }
+
+    void ParameterExpression::encode(Encoder& out) const
+    {
+        (void)out;
+        throw UnboundParameterException(index_ + 1);
+    }
+
+    void UnaryExpression::encode(Encoder& out) const
+    {
+        out.put<uint8_t>(UnaryTag);
+        out.put<uint8_t>(op_);
+        lhs_->encode(out);
+    }
+
+    void BinaryExpression::encode(Encoder& out) const
+    {
+        out.put<uint8_t>(BinaryTag);
+        out.put<uint8_t>(op_);
+        lhs_->encode(out);
+        rhs_->encode(out);
+    }
+
+    static Operation decode_operation(Decoder& in)
+    {
+        uint8_t op = in.get<uint8_t>();
+        if (op > GEQ)
+            throw CorruptedRecordException();
+        return static_cast<Operation>(op);
+    }
+
+    static ExpressionNodePointer decode_node(Decoder& in)
+    {
+        switch (in.get<uint8_t>())
+        {
+        case EmptyTag:
+            return ExpressionNodePointer(nullptr);
+
+        case ValueTag:
+            return ExpressionNodePointer(new ValueExpression(in.get_string()));
+
+        case ConstTag:
+            return ExpressionNodePointer(new ConstExpression(in.get_cell()));
+
+        case UnaryTag:
+        {
+            Operation op = decode_operation(in);
+            ExpressionNodePointer lhs = decode_node(in);
+            if (!lhs)
+                throw CorruptedRecordException();
+            return ExpressionNodePointer(new UnaryExpression(lhs, op));
+        }
+
+        case BinaryTag:
+        {
+            Operation op = decode_operation(in);
+            ExpressionNodePointer lhs = decode_node(in);
+            ExpressionNodePointer rhs = decode_node(in);
+            if (!lhs || !rhs)
+                throw CorruptedRecordException();
+            return ExpressionNodePointer(new BinaryExpression(lhs, rhs, op));
+        }
+
+        default:
+            throw CorruptedRecordException();
+        }
+    }
+
+    Expression Expression::decode(Decoder& in)
+    {
+        return Expression(decode_node(in));
+    }
+} // namespace memdb
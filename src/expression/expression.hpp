@@ -19,13 +19,60 @@ namespace memdb
         EQ, NEQ, LE, LEQ, GR, GEQ      // compare   
     };
 
+    class Encoder;
+    class Decoder;
+
+    // Evaluation of a bound node whose operand types are known
+    enum Kernel
+    {
+        GenericKernel,  // Cell operators
+        IntKernel,      // Int32 operands
+        BoolKernel      // Bool operands
+    };
+
     // Abstract class for ExpressionNode tree node
     class ExpressionNode
     {
     public:
         ExpressionNode() = default;
         virtual ~ExpressionNode() = default;
-        virtual Cell evaluate(Row* row) = 0;
+        virtual Cell evaluate(const Row* row) = 0;
+
+        // Value of a subtree of type INT32 or BOOL. Bound nodes compute it
+        // on plain values, with no Cell built and no type checked per row
+        virtual Int32 evaluate_int(const Row* row);
+        virtual Bool evaluate_bool(const Row* row);
+
+        // Binary form of the subtree, read back by Expression::decode
+        virtual void encode(Encoder& out) const = 0;
+
+        // Subtree in query syntax, operands with operators of their own in parentheses
+        virtual std::string text() const = 0;
+
+        // False only if no row of table within the bounds of zone can make
+        // the subtree true
+        virtual bool may_be_true(const Table& table, const ZoneMap& zone) const;
+
+        // Set in mask every slot of segment, a segment of table, whose row can
+        // make the subtree true, judging by the compressed columns. False if
+        // the subtree cannot be judged that way, mask is then unspecified
+        virtual bool candidates(const Table& table, const SealedColumns& sealed, SlotMask& mask) const;
+
+        // Copy of the subtree bound to the columns of table, with the type of
+        // every node checked. Throws the exception evaluation would throw on
+        // the first row for operands of the wrong type
+        virtual ExpressionNodePointer bind(const Table& table) const = 0;
+
+        // Copy of the subtree with parameters $n replaced by values[n - 1],
+        // nullptr if the subtree has no parameters. UnboundParameterException
+        // for a parameter without a value
+        virtual ExpressionNodePointer bind_parameters(const std::vector<Cell>& values) const;
+
+        // Type of the values of a bound subtree
+        CellType type() const { return type_; }
+
+    protected:
+        CellType type_ = CellType::INT32;
     };
 
     class Expression
@@ -40,8 +87,41 @@ namespace memdb
         Expression& operator=(const Expression& other)  = default;
         Expression& operator=(Expression&& other)       = default;
 
-        Cell evaluate(Row* row) const;
+        Cell evaluate(const Row* row) const;
         ~Expression() = default;
+
+        // Value of a bound condition for row, true for an empty one
+        bool matches(const Row* row) const;
+
+        // Type of the values of a bound expression, BOOL for an empty one
+        CellType type() const;
+
+        // False if no row within the bounds of zone, a segment of table, can match
+        // a bound condition
+        bool may_match(const Table& table, const ZoneMap& zone) const;
+
+        // Slots of a sealed segment of table that can match a bound condition,
+        // false if all can
+        bool candidates(const Table& table, const SealedColumns& sealed, SlotMask& mask) const;
+
+        // Expression to evaluate on rows of table, type-checked before any row
+        // is read. Columns are resolved to positions, operators on Int32 and
+        // Bool run typed kernels, and strings compared for equality with a
+        // column become entries of the column dictionary
+        Expression bind(const Table& table) const;
+
+        // Bound WHERE condition, IncorrectWhereStatementException unless it is Bool
+        Expression bind_condition(const Table& table) const;
+
+        // Expression with parameters $n replaced by values[n - 1], see
+        // ExpressionNode::bind_parameters. Subtrees without one are shared
+        Expression bind_parameters(const std::vector<Cell>& values) const;
+
+        void encode(Encoder& out) const;
+        static Expression decode(Decoder& in);
+
+        // Expression in query syntax, empty for an empty one
+        std::string text() const;
     private:
         friend class Parser;
         Expression(ExpressionNodePointer root);
@@ -56,9 +136,20 @@ namespace memdb
         ValueExpression(const std::string& column_name);
         ~ValueExpression() override = default;
 
-        Cell evaluate(Row* row) override;
+        Cell evaluate(const Row* row) override;
+        Int32 evaluate_int(const Row* row) override;
+        Bool evaluate_bool(const Row* row) override;
+        void encode(Encoder& out) const override;
+        std::string text() const override;
+        ExpressionNodePointer bind(const Table& table) const override;
+
+        const std::string& column_name() const { return column_name_; }
+        size_t position() const { return position_; }   // of a bound node
     private:
+        static const size_t unbound = SIZE_MAX;
+
         std::string column_name_;
+        size_t position_ = unbound;
     };
 
     class ConstExpression : public ExpressionNode
@@ -67,11 +158,38 @@ namespace memdb
         ConstExpression(const Cell& data);
         ~ConstExpression() override = default;
 
-        Cell evaluate(Row* row) override;
+        Cell evaluate(const Row* row) override;
+        Int32 evaluate_int(const Row* row) override;
+        Bool evaluate_bool(const Row* row) override;
+        void encode(Encoder& out) const override;
+        std::string text() const override;
+        ExpressionNodePointer bind(const Table& table) const override;
+
+        const Cell& value() const { return data_; }
     private:
         Cell data_;
     };
 
+    // Parameter $n of a prepared statement, replaced by its value before
+    // the expression is bound to a table
+    class ParameterExpression : public ExpressionNode
+    {
+    public:
+        ParameterExpression(size_t index);
+        ~ParameterExpression() override = default;
+
+        // A parameter without a value cannot be evaluated, bound or encoded
+        Cell evaluate(const Row* row) override;
+        void encode(Encoder& out) const override;
+        std::string text() const override;
+        ExpressionNodePointer bind(const Table& table) const override;
+        ExpressionNodePointer bind_parameters(const std::vector<Cell>& values) const override;
+
+        size_t index() const { return index_; }     // 0 for $1
+    private:
+        size_t index_;
+    };
+
     // Node of ExpressionNode tree with one child
     class UnaryExpression : public ExpressionNode
     {
@@ -79,10 +197,17 @@ namespace memdb
         UnaryExpression(ExpressionNodePointer lhs, Operation op);
         ~UnaryExpression() override = default;
 
-        Cell evaluate(Row* row) override;
+        Cell evaluate(const Row* row) override;
+        Int32 evaluate_int(const Row* row) override;
+        Bool evaluate_bool(const Row* row) override;
+        void encode(Encoder& out) const override;
+        std::string text() const override;
+        ExpressionNodePointer bind(const Table& table) const override;
+        ExpressionNodePointer bind_parameters(const std::vector<Cell>& values) const override;
     private:
         ExpressionNodePointer lhs_;
         Operation op_;
+        Kernel kernel_ = GenericKernel;
     };
 
     // Node of ExpressionNode tree with two children
@@ -93,11 +218,20 @@ namespace memdb
             ExpressionNodePointer rhs, Operation op);
         ~BinaryExpression() override = default;
 
-        Cell evaluate(Row* row) override;
+        Cell evaluate(const Row* row) override;
+        Int32 evaluate_int(const Row* row) override;
+        Bool evaluate_bool(const Row* row) override;
+        void encode(Encoder& out) const override;
+        std::string text() const override;
+        bool may_be_true(const Table& table, const ZoneMap& zone) const override;
+        bool candidates(const Table& table, const SealedColumns& sealed, SlotMask& mask) const override;
+        ExpressionNodePointer bind(const Table& table) const override;
+        ExpressionNodePointer bind_parameters(const std::vector<Cell>& values) const override;
     private:
         ExpressionNodePointer lhs_;
         ExpressionNodePointer rhs_;
         Operation op_;
+        Kernel kernel_ = GenericKernel;
     };
 
 } // namespace memdb
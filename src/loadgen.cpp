@@ -0,0 +1,221 @@
+#include "client/client.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+using namespace std;
+using namespace memdb;
+
+struct LoadOptions
+{
+	std::string	host_ = "127.0.0.1";
+	uint16_t	port_ = 7480;
+	size_t		connections_ = 4;
+	size_t		pipeline_ = 16;
+	size_t		seconds_ = 10;
+	size_t		rows_ = 10000;
+	size_t		reports_ = 0;		// connections running full scans next to the point queries
+	bool		prepared_ = true;
+};
+
+// Latencies of the batches of one connection, in microseconds
+struct LoadStats
+{
+	size_t			queries_ = 0;
+	size_t			errors_ = 0;
+	size_t			rejected_ = 0;		// retryable errors of an overloaded server
+	std::vector<uint32_t>	latencies_;
+};
+
+static const std::string table_name = "loadgen";
+
+static void setup(const LoadOptions& options)
+{
+	Client client(options.host_, options.port_);
+	client.query("drop table " + table_name);
+
+	ResultSet res = client.query("create table " + table_name + " (id : int32, name : string, flag : bool)");
+	if (!res.ok())
+		throw ClientException(res.error());
+
+	// rows go in with the prepared insert, pipelined like the load itself
+	uint32_t insert = client.prepare("insert ($1, $2, $3) to " + table_name);
+	for (size_t id = 0; id < options.rows_; ++id) {
+		client.send_execute(insert, { Cell(Int32(id)), Cell("name" + std::to_string(id)), Cell(id % 2 == 0) });
+		if ((id + 1) % options.pipeline_ == 0 || id + 1 == options.rows_) {
+			client.flush();
+			for (size_t i = id / options.pipeline_ * options.pipeline_; i <= id; ++i)
+				if (!(res = client.receive()).ok())
+					throw ClientException(res.error());
+		}
+	}
+	client.close(insert);
+}
+
+static void run_connection(const LoadOptions& options, std::chrono::steady_clock::time_point end,
+	size_t seed, LoadStats& stats)
+{
+	Client client(options.host_, options.port_);
+	std::string query = "select id, name, flag from " + table_name + " where id == ";
+	uint32_t statement = options.prepared_ ? client.prepare(query + "$1") : 0;
+
+	size_t next = seed;
+	while (std::chrono::steady_clock::now() < end) {
+		auto start = std::chrono::steady_clock::now();
+
+		for (size_t i = 0; i < options.pipeline_; ++i) {
+			// a cheap linear congruential walk over the keys
+			next = next * 6364136223846793005ULL + 1442695040888963407ULL;
+			Int32 id = (next >> 33) % options.rows_;
+			if (options.prepared_)
+				client.send_execute(statement, { Cell(id) });
+			else
+				client.send_query(query + std::to_string(id));
+		}
+		client.flush();
+
+		for (size_t i = 0; i < options.pipeline_; ++i) {
+			ResultSet res = client.receive();
+			if (res.retryable())
+				stats.rejected_++;
+			else if (!res.ok() || res.size() != 1)
+				stats.errors_++;
+		}
+
+		auto elapsed = std::chrono::steady_clock::now() - start;
+		stats.latencies_.push_back(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+		stats.queries_ += options.pipeline_;
+	}
+}
+
+// Full scans, one at a time, until end
+static void run_reports(const LoadOptions& options, std::chrono::steady_clock::time_point end, LoadStats& stats)
+{
+	Client client(options.host_, options.port_);
+	while (std::chrono::steady_clock::now() < end) {
+		ResultSet res = client.query("select id, name from " + table_name + " where flag == true");
+		if (res.retryable())
+			stats.rejected_++;
+		else if (!res.ok())
+			stats.errors_++;
+		else
+			stats.queries_++;
+	}
+}
+
+static uint32_t percentile(const std::vector<uint32_t>& sorted, double fraction)
+{
+	if (sorted.empty())
+		return 0;
+	return sorted[std::min(sorted.size() - 1, size_t(fraction * sorted.size()))];
+}
+
+int main (int argc, char** argv) 
+{
+	// memdb-loadgen [--host <address>] [--port <port>] [--connections <n>] [--pipeline <n>]
+	//               [--seconds <n>] [--rows <n>] [--mode prepared | text] [--reports <n>]
+	LoadOptions options;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+
+		if (arg == "--host" && i + 1 < argc)
+			options.host_ = argv[++i];
+		else if (arg == "--port" && i + 1 < argc)
+			options.port_ = std::stoul(argv[++i]);
+		else if (arg == "--connections" && i + 1 < argc)
+			options.connections_ = std::max(1UL, std::stoul(argv[++i]));
+		else if (arg == "--pipeline" && i + 1 < argc)
+			options.pipeline_ = std::max(1UL, std::stoul(argv[++i]));
+		else if (arg == "--seconds" && i + 1 < argc)
+			options.seconds_ = std::stoul(argv[++i]);
+		else if (arg == "--rows" && i + 1 < argc)
+			options.rows_ = std::max(1UL, std::stoul(argv[++i]));
+		else if (arg == "--reports" && i + 1 < argc)
+			options.reports_ = std::stoul(argv[++i]);
+		else if (arg == "--mode" && i + 1 < argc) {
+			std::string mode = argv[++i];
+			if (mode != "prepared" && mode != "text") {
+				cerr << "unknown mode " << mode << "\n";
+				return 1;
+			}
+			options.prepared_ = mode == "prepared";
+		}
+		else {
+			cerr << "unknown argument " << arg << "\n";
+			return 1;
+		}
+	}
+
+	try {
+		setup(options);
+	}
+	catch (DatabaseException& ex) {
+		cerr << ex.what();
+		return 1;
+	}
+
+	std::vector<LoadStats> stats(options.connections_);
+	std::vector<std::thread> threads;
+	std::atomic<size_t> failed = 0;
+	auto start = std::chrono::steady_clock::now();
+	auto end = start + std::chrono::seconds(options.seconds_);
+
+	for (size_t c = 0; c < options.connections_; ++c)
+		threads.emplace_back([&, c] {
+			try {
+				run_connection(options, end, c + 1, stats[c]);
+			}
+			catch (DatabaseException& ex) {
+				cerr << ex.what();
+				failed++;
+			}
+		});
+	std::vector<LoadStats> report_stats(options.reports_);
+	for (size_t c = 0; c < options.reports_; ++c)
+		threads.emplace_back([&, c] {
+			try {
+				run_reports(options, end, report_stats[c]);
+			}
+			catch (DatabaseException& ex) {
+				cerr << ex.what();
+				failed++;
+			}
+		});
+
+	for (auto& thread : threads)
+		thread.join();
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	size_t queries = 0, errors = 0, rejected = 0;
+	std::vector<uint32_t> latencies;
+	for (auto& stat : stats) {
+		queries += stat.queries_;
+		errors += stat.errors_;
+		rejected += stat.rejected_;
+		latencies.insert(latencies.end(), stat.latencies_.begin(), stat.latencies_.end());
+	}
+	std::sort(latencies.begin(), latencies.end());
+
+	cout << (options.prepared_ ? "prepared" : "text") << ": " << queries << " queries in " << seconds << " s, "
+		<< size_t(queries / seconds) << " queries/s, " << errors << " errors, " << rejected << " rejected\n";
+	cout << "batch of " << options.pipeline_ << " latency: p50 " << percentile(latencies, 0.5)
+		<< " us, p99 " << percentile(latencies, 0.99) << " us\n";
+
+	if (options.reports_) {
+		size_t reports = 0;
+		for (auto& stat : report_stats) {
+			reports += stat.queries_;
+			errors += stat.errors_;
+		}
+		cout << "reports: " << reports << " full scans\n";
+	}
+
+	return failed || errors ? 1 : 0;
+}
@@ -2,17 +2,35 @@
 #include "parser/parser.hpp"
 #include "command/command.hpp"
 #include "expression/expression.hpp"
+#include "command/output.hpp"
 #include "prompt_utils.hpp"
 
 #include <ostream>
 #include <iostream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
 
 
 using namespace std;
 using namespace memdb;
 
+// Show text through the pager, or print it if the pager cannot be started
+static void page(const std::string& text)
+{
+	const char* pager = std::getenv("PAGER");
+	FILE* pipe = popen(pager && *pager ? pager : "less -S", "w");
+	if (!pipe) {
+		cout << text;
+		return;
+	}
+
+	fwrite(text.data(), 1, text.size(), pipe);
+	pclose(pipe);
+}
+
 
-int main (void) 
+int main (int argc, char** argv) 
 {
 
 	// Database db;
@@ -28,13 +46,69 @@ int main (void)
     // res.print(cout);
 
 	std::string input;
-	Database db;
+
+	// prompt [--data-dir <dir>] [--sync always | never | <ms>]
+	//        [--slow-ms <ms>] [--slow-log <path>] [<snapshot>]
+	DurabilityOptions options;
+	SlowLogOptions slow_options;
+	std::string snapshot;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+
+		if (arg == "--data-dir" && i + 1 < argc)
+			options.directory_ = argv[++i];
+		else if (arg == "--sync" && i + 1 < argc) {
+			std::string policy = argv[++i];
+			if (policy == "always")
+				options.sync_policy_ = SyncEveryCommit;
+			else if (policy == "never")
+				options.sync_policy_ = SyncNever;
+			else {
+				options.sync_policy_ = SyncInterval;
+				options.sync_interval_ms_ = std::stoul(policy);
+			}
+		}
+		else if (arg == "--slow-ms" && i + 1 < argc)
+			slow_options.threshold_us_ = std::stoul(argv[++i]) * 1000;
+		else if (arg == "--slow-log" && i + 1 < argc)
+			slow_options.path_ = argv[++i];
+		else
+			snapshot = arg;
+	}
+
+	std::unique_ptr<Database> database;
+	try {
+		database = options.directory_.empty() 
+			? std::make_unique<Database>() 
+			: std::make_unique<Database>(options);
+		database->slow_log().configure(slow_options);
+	}
+	catch (DatabaseException& ex) {
+		cerr << ex.what();
+		return 1;
+	}
+	Database& db = *database;
+
+	// starting from a snapshot written by SAVE
+	if (!snapshot.empty()) {
+		try {
+			db.load(snapshot);
+		}
+		catch (DatabaseException& ex) {
+			cout << ex.what();
+		}
+	}
 
 	vector<string> history;
+	string mode = "table";
+	size_t limit = PROMPT_ROW_LIMIT;
+	bool pager = false;
 
 	while (1) {
 		cout << "memdb> ";
-		std::getline(cin, input);
+		if (!std::getline(cin, input))
+			break;
 
 		if (input == ".exit" || input == ".quit")
 			break;
@@ -44,6 +118,61 @@ int main (void)
 			continue;
 		}
 
+		if (input.rfind(".mode", 0) == 0) {
+			string name = input.size() > 6 ? input.substr(6) : "";
+			if (name == "table" || name == "csv" || name == "json")
+				mode = name;
+			else
+				cout << "Modes: table, csv, json\n";
+			continue;
+		}
+
+		if (input.rfind(".limit ", 0) == 0) {
+			try {
+				size_t rows = std::stoul(input.substr(7));
+				limit = rows ? rows : SIZE_MAX;
+			}
+			catch (std::exception&) {
+				cout << "Usage: .limit <rows>\n";
+			}
+			continue;
+		}
+
+		if (input == ".pager on" || input == ".pager off") {
+			pager = input == ".pager on";
+			continue;
+		}
+
+		if (input == ".stats") {
+			MetricsSnapshot metrics = db.metrics_snapshot();
+			OutputBuffer out(cout);
+			write_aligned(*command_stats_table(metrics), out);
+			write_aligned(*table_stats_table(metrics), out);
+			continue;
+		}
+
+		if (input == ".stats prometheus") {
+			OutputBuffer out(cout);
+			db.write_metrics(out);
+			continue;
+		}
+
+		if (input == ".slowlog") {
+			OutputBuffer out(cout);
+			write_aligned(*slow_log_table(db.slow_log().entries()), out);
+			continue;
+		}
+
+		if (input.rfind(".slowlog ", 0) == 0) {
+			try {
+				db.slow_log().set_threshold(std::stoul(input.substr(9)) * 1000);
+			}
+			catch (std::exception&) {
+				cout << "Usage: .slowlog [<ms>]\n";
+			}
+			continue;
+		}
+
 		if (input == ".history") {
 			for (auto& q : history)
 				cout << q << '\n';
@@ -51,7 +180,21 @@ int main (void)
 		}
 
 		Result res = db.execute(input);
-		res.print(cout);
+		if (mode == "json") {
+			OutputBuffer out(cout);
+			res.write_json(out);
+		}
+		else if (mode == "csv" && res.ok()) {
+			OutputBuffer out(cout);
+			res.write_csv(out);
+		}
+		else if (pager && res.ok() && res.get_table()) {
+			std::ostringstream text;
+			res.print(text, limit);
+			page(text.str());
+		}
+		else
+			res.print(cout, limit);
 
 		if (res.ok())
 			if (history.empty() || history[history.size() - 1] != input)
@@ -33,6 +33,15 @@ namespace memdb
         }
     };
 
+    // cursor names
+    class InvalidCursorNameException : public ParseException
+    {
+    public:
+        const char* what() const throw() {
+            return "[PARSE ERROR] : Invalid cursor name provided\n"; 
+        }
+    };
+
     // commands
     class UnknowCommandException : public ParseException
     {
@@ -99,6 +108,14 @@ namespace memdb
         }
     };
 
+    class InvalidPathException : public ParseException
+    {
+    public:
+        const char* what() const throw() {
+            return "[PARSE ERROR] : Invalid file path. Path must be enclosed in quotes\n"; 
+        }
+    };
+
     class InvalidRowDataException : public ParseException
     {
     public:
@@ -158,6 +175,22 @@ namespace memdb
         }
     };
 
+    class InvalidParameterException : public ParseException
+    {
+    public:
+        const char* what() const throw() {
+            return "[PARSE ERROR] : parameters are numbered from $1 to $65535\n"; 
+        }
+    };
+
+    class InvalidFetchCountException : public ParseException
+    {
+    public:
+        const char* what() const throw() {
+            return "[PARSE ERROR] : FETCH takes a non-negative number of rows\n"; 
+        }
+    };
+
 
 } // namespace memdb
 
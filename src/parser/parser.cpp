@@ -9,18 +9,23 @@ namespace memdb
 {
     bool Parser::parse(Command& ret)
     {
-        if (parse_create_table(ret))
-            return true;
-        if (parse_insert(ret))
-            return true;
-        if (parse_update(ret))
-            return true;
-        if (parse_select(ret))
-            return true;
-        if (parse_delete(ret))
-            return true;
+        // the command is known by its first words, see Command::type
+        Position start_pos = pos_;
+        CommandType command_type;
+        if (!parse_command(command_type))
+            throw UnknowCommandException();
+        pos_ = start_pos;
 
-        throw UnknowCommandException();
+        bool parsed = parse_create_table(ret) || parse_insert(ret) || parse_update(ret)
+            || parse_select(ret) || parse_delete(ret) || parse_drop_table(ret)
+            || parse_save(ret) || parse_load(ret) || parse_background_save(ret)
+            || parse_transaction_control(ret) || parse_cursor(ret) || parse_explain(ret);
+
+        if (!parsed)
+            throw UnknowCommandException();
+
+        ret.type_ = command_type;
+        return true;
     }
 
     bool Parser::parse_get_table(Command& command)
@@ -77,6 +82,8 @@ namespace memdb
 
         std::vector<Cell>   ordered;
         std::unordered_map<std::string, Cell> unordered;
+        RowParameters       ordered_parameters;
+        NamedRowParameters  unordered_parameters;
 
         // Parse command name
         if (!parse_command(command_type) || command_type != Insert) {
@@ -87,10 +94,10 @@ namespace memdb
         parse_whitespaces();
 
         // parse row data
-        if (parse_row_ordered(ordered)) {
+        if (parse_row_ordered(ordered, ordered_parameters)) {
             use_ordered = true;
         }
-        else if (!parse_row_unordered(unordered))
+        else if (!parse_row_unordered(unordered, unordered_parameters))
             throw InvalidRowDataException();
 
         parse_whitespaces();
@@ -106,9 +113,11 @@ namespace memdb
 
         // Result
         if (use_ordered)
-            command = Command(CommandNodePointer(new SQLInsertOrdered(table_name, ordered)));
+            command = Command(CommandNodePointer(new SQLInsertOrdered(table_name, ordered,
+                ordered_parameters)));
         else
-            command = Command(CommandNodePointer(new SQLInsertUnordered(table_name, unordered)));
+            command = Command(CommandNodePointer(new SQLInsertUnordered(table_name, unordered,
+                unordered_parameters)));
 
         return true;
     }
@@ -286,6 +295,214 @@ namespace memdb
         return true;
     }
 
+    bool Parser::parse_drop_table(Command& command)
+    {
+        Position start_pos = pos_;
+
+        CommandType command_type;
+        std::string table_name;
+
+        // Parse DROP TABLE command name
+        if (!parse_command(command_type) || command_type != DropTable) {
+            pos_ = start_pos;
+            return false;
+        }
+
+        parse_whitespaces();
+
+        if (!parse_name(table_name))
+            throw InvalidTableNameException();
+
+        command = Command(CommandNodePointer(new SQLDropTable(table_name)));
+
+        return true;
+    }
+
+    bool Parser::parse_save(Command& command)
+    {
+        Position start_pos = pos_;
+
+        CommandType command_type;
+        std::string path;
+
+        // Parse SAVE command name
+        if (!parse_command(command_type) || command_type != Save) {
+            pos_ = start_pos;
+            return false;
+        }
+
+        parse_whitespaces();
+
+        if (!parse_path(path))
+            throw InvalidPathException();
+
+        command = Command(CommandNodePointer(new SQLSave(path)));
+
+        return true;
+    }
+
+    bool Parser::parse_load(Command& command)
+    {
+        Position start_pos = pos_;
+
+        CommandType command_type;
+        std::string path;
+
+        // Parse LOAD command name
+        if (!parse_command(command_type) || command_type != Load) {
+            pos_ = start_pos;
+            return false;
+        }
+
+        parse_whitespaces();
+
+        if (!parse_path(path))
+            throw InvalidPathException();
+
+        command = Command(CommandNodePointer(new SQLLoad(path)));
+
+        return true;
+    }
+
+    bool Parser::parse_background_save(Command& command)
+    {
+        Position start_pos = pos_;
+
+        CommandType command_type;
+        std::string path;
+
+        // Parse BGSAVE or BGSAVE STATUS command name
+        if (!parse_command(command_type) ||
+            (command_type != BgSave && command_type != BgSaveStatus)) {
+            pos_ = start_pos;
+            return false;
+        }
+
+        if (command_type == BgSaveStatus) {
+            command = Command(CommandNodePointer(new SQLBackgroundSaveStatus()));
+            return true;
+        }
+
+        parse_whitespaces();
+
+        if (!parse_path(path))
+            throw InvalidPathException();
+
+        command = Command(CommandNodePointer(new SQLBackgroundSave(path)));
+
+        return true;
+    }
+
+    bool Parser::parse_transaction_control(Command& command)
+    {
+        Position start_pos = pos_;
+
+        CommandType command_type;
+
+        // Parse BEGIN, COMMIT or ROLLBACK command name
+        if (!parse_command(command_type)) {
+            pos_ = start_pos;
+            return false;
+        }
+
+        switch (command_type)
+        {
+        case Begin:     command = Command(CommandNodePointer(new SQLBegin()));      return true;
+        case Commit:    command = Command(CommandNodePointer(new SQLCommit()));     return true;
+        case Rollback:  command = Command(CommandNodePointer(new SQLRollback()));   return true;
+        default:
+            pos_ = start_pos;
+            return false;
+        }
+    }
+
+    bool Parser::parse_cursor(Command& command)
+    {
+        Position start_pos = pos_;
+
+        CommandType command_type;
+        KeywordType keyword_type;
+        std::string name;
+
+        // Parse DECLARE, FETCH or CLOSE command name
+        if (!parse_command(command_type) ||
+            (command_type != Declare && command_type != Fetch && command_type != Close)) {
+            pos_ = start_pos;
+            return false;
+        }
+
+        parse_whitespaces();
+
+        if (command_type == Declare) {
+            if (!parse_name(name))
+                throw InvalidCursorNameException();
+
+            parse_whitespaces();
+
+            // parse CURSOR FOR keyword
+            if (!parse_keyword(keyword_type) || keyword_type != CursorFor)
+                throw IncorrectKeywordException();
+
+            parse_whitespaces();
+
+            Command select;
+            if (!parse_select(select))
+                throw UnknowCommandException();
+
+            command = Command(CommandNodePointer(new SQLDeclareCursor(name,
+                std::static_pointer_cast<SQLSelect>(select.root_))));
+            return true;
+        }
+
+        if (command_type == Fetch) {
+            int count;
+            if (!parse_int(count) || count < 0)
+                throw InvalidFetchCountException();
+
+            parse_whitespaces();
+
+            // parse FROM keyword
+            if (!parse_keyword(keyword_type) || keyword_type != From)
+                throw IncorrectKeywordException();
+
+            parse_whitespaces();
+
+            if (!parse_name(name))
+                throw InvalidCursorNameException();
+
+            command = Command(CommandNodePointer(new SQLFetch(name, size_t(count))));
+            return true;
+        }
+
+        if (!parse_name(name))
+            throw InvalidCursorNameException();
+
+        command = Command(CommandNodePointer(new SQLCloseCursor(name)));
+        return true;
+    }
+
+    bool Parser::parse_explain(Command& command)
+    {
+        Position start_pos = pos_;
+
+        CommandType command_type;
+
+        // Parse EXPLAIN or EXPLAIN ANALYZE command name
+        if (!parse_command(command_type) ||
+            (command_type != Explain && command_type != ExplainAnalyze)) {
+            pos_ = start_pos;
+            return false;
+        }
+
+        parse_whitespaces();
+
+        Command statement;
+        parse(statement);
+
+        command = Command(CommandNodePointer(new SQLExplain(statement.root_,
+            command_type == ExplainAnalyze)));
+        return true;
+    }
 
     static const std::unordered_map<std::string, CommandType>
         str_to_command_mp {
@@ -295,7 +512,20 @@ namespace memdb
             {"SELECT",          Select},
             {"DELETE",          Delete},
             {"JOIN",            Join},
-            {"CREATE INDEX",    CreateIndex}
+            {"CREATE INDEX",    CreateIndex},
+            {"SAVE",            Save},
+            {"LOAD",            Load},
+            {"DROP TABLE",      DropTable},
+            {"BGSAVE",          BgSave},
+            {"BGSAVE STATUS",   BgSaveStatus},
+            {"BEGIN",           Begin},
+            {"COMMIT",          Commit},
+            {"ROLLBACK",        Rollback},
+            {"DECLARE",         Declare},
+            {"FETCH",           Fetch},
+            {"CLOSE",           Close},
+            {"EXPLAIN",         Explain},
+            {"EXPLAIN ANALYZE", ExplainAnalyze}
         };
 
     static const std::unordered_map<std::string, KeywordType>
@@ -306,7 +536,8 @@ namespace memdb
             {"SET",      Set},
             {"ON",       On},
             {"INDEX ON", IndexOn},
-            {"BY",       By}
+            {"BY",       By},
+            {"CURSOR FOR", CursorFor}
         };
 
     static const std::unordered_map<std::string, ColumnAttribute>
@@ -428,9 +659,14 @@ namespace memdb
 
     CommandType str_to_command(std::string& str)
     {
-        for (auto i = 0LU; i < str.size(); ++i)
-            if (isalpha(str[i]))
-                str[i] = toupper(str[i]); // convert all letters to upppercase
+        std::string normalized;
+        for (auto i = 0LU; i < str.size(); ++i) {
+            if (!isspace(str[i]))
+                normalized += toupper(str[i]); // convert all letters to upppercase
+            else if (!isspace(str[i - 1]))
+                normalized += ' ';  // words of the command are separated by any whitespace
+        }
+        str = normalized;
 
         assert(str_to_command_mp.find(str) != str_to_command_mp.end());
         return str_to_command_mp.at(str); // return command type from map
@@ -438,9 +674,14 @@ namespace memdb
 
     KeywordType str_to_keyword(std::string& str)
     {
-        for (auto i = 0LU; i < str.size(); ++i)
-            if (isalpha(str[i]))
-                str[i] = toupper(str[i]); // convert all letters to upppercase
+        std::string normalized;
+        for (auto i = 0LU; i < str.size(); ++i) {
+            if (!isspace(str[i]))
+                normalized += toupper(str[i]); // convert all letters to upppercase
+            else if (!isspace(str[i - 1]))
+                normalized += ' ';  // words of the keyword are separated by any whitespace
+        }
+        str = normalized;
 
         assert(str_to_keyword_mp.find(str) != str_to_keyword_mp.end());
         return str_to_keyword_mp.at(str); // return command type from map
@@ -579,7 +820,7 @@ namespace memdb
         // // Note: (?i) is a flag that makes pattern  case insensitive
 
         static const std::regex 
-            pattern{"([Cc][Rr][Ee][Aa][Tt][Ee](\\s+)[Tt][Aa][Bb][Ll][Ee])|([Ii][Nn][Ss][Ee][Rr][Tt])|([Uu][Pp][Dd][Aa][Tt][Ee])|([Ss][Ee][Ll][Ee][Cc][Tt])|([Dd][Ee][Ll][Ee][Tt][Ee])"};
+            pattern{"([Cc][Rr][Ee][Aa][Tt][Ee](\\s+)[Tt][Aa][Bb][Ll][Ee])|([Ii][Nn][Ss][Ee][Rr][Tt])|([Uu][Pp][Dd][Aa][Tt][Ee])|([Ss][Ee][Ll][Ee][Cc][Tt])|([Dd][Ee][Ll][Ee][Tt][Ee])|([Ss][Aa][Vv][Ee])|([Ll][Oo][Aa][Dd])|([Dd][Rr][Oo][Pp](\\s+)[Tt][Aa][Bb][Ll][Ee])|([Bb][Gg][Ss][Aa][Vv][Ee](\\s+)[Ss][Tt][Aa][Tt][Uu][Ss])|([Bb][Gg][Ss][Aa][Vv][Ee])|([Bb][Ee][Gg][Ii][Nn])|([Cc][Oo][Mm][Mm][Ii][Tt])|([Rr][Oo][Ll][Ll][Bb][Aa][Cc][Kk])|([Dd][Ee][Cc][Ll][Aa][Rr][Ee])|([Ff][Ee][Tt][Cc][Hh])|([Cc][Ll][Oo][Ss][Ee])|([Ee][Xx][Pp][Ll][Aa][Ii][Nn](\\s+)[Aa][Nn][Aa][Ll][Yy][Zz][Ee])|([Ee][Xx][Pp][Ll][Aa][Ii][Nn])"};
 
         std::string str;
         bool res = parse_pattern(pattern, str);
@@ -596,7 +837,7 @@ namespace memdb
         // // Note: (?i) is a flag that makes pattern  case insensitive
 
         static const std::regex 
-            pattern{"([Tt][Oo])|([Ff][Rr][Oo][Mm])|([Ww][Hh][Ee][Rr][Ee])|([Ss][Ee][Tt])|([Oo][Nn])|([Ii][Nn][Dd][Ee][Xx]\\s+[Oo][Nn])|([Bb][Yy])"};
+            pattern{"([Tt][Oo])|([Ff][Rr][Oo][Mm])|([Ww][Hh][Ee][Rr][Ee])|([Ss][Ee][Tt])|([Oo][Nn])|([Ii][Nn][Dd][Ee][Xx]\\s+[Oo][Nn])|([Bb][Yy])|([Cc][Uu][Rr][Ss][Oo][Rr]\\s+[Ff][Oo][Rr])"};
 
         std::string str;
         bool res = parse_pattern(pattern, str);
@@ -615,20 +856,51 @@ namespace memdb
 
     bool Parser::parse_subquery(std::string& ret) 
     {
-        static const std::regex 
-            pattern{".+\\)"};
+        if (pos_ == end_ || *pos_ != '(')
+            return false;
 
-        static const std::regex 
-            open_par{"\\("};
+        // up to the matching close parenthesis, skipping those in strings
+        size_t depth = 0;
+        char quote = 0;
+        for (Position it = pos_; it != end_; ++it)
+        {
+            if (quote) {
+                if (*it == '\\' && std::next(it) != end_)
+                    ++it;
+                else if (*it == quote)
+                    quote = 0;
+            }
+            else if (*it == '"' || *it == '\'')
+                quote = *it;
+            else if (*it == '(')
+                ++depth;
+            else if (*it == ')' && --depth == 0) {
+                ret.assign(std::next(pos_), it);
+                pos_ = std::next(it);
+                return true;
+            }
+        }
 
-        if (!parse_pattern(open_par))
-            return false;
+        return false;
+    }
 
-        parse_string(ret);
-        ret.pop_back(); // remove close parenthesis
+    // file path in single or double quotes
+    bool Parser::parse_path(std::string& ret)
+    {
+        static const std::regex
+            pattern("(\\\"[^\\\"]+\\\")|('[^']+')");
 
-        return true;
+        std::string str;
+        bool res = parse_pattern(pattern, str);
 
+        if (res) {
+            // remove quotes
+            str.erase(str.begin());
+            str.pop_back();
+            ret = str;
+        }
+
+        return res;
     }
 
     bool Parser::parse_int(int& ret)
@@ -707,6 +979,12 @@ namespace memdb
         std::string str_val;
         std::vector<std::byte> bytes_val;
 
+        // bytes go first, otherwise "0x..." is taken for integer 0
+        if (parse_bytes(bytes_val)) {
+            ret = Cell(bytes_val);
+            return true;
+        }
+
         if (parse_int(int_val)){
             ret =  Cell(int_val);
             return true;
@@ -721,14 +999,23 @@ namespace memdb
             ret = Cell(str_val);
             return true;
         }
-
-        if (parse_bytes(bytes_val)) {
-            ret = Cell(bytes_val);
-            return true;
-        }
         return false;
     }
 
+    bool Parser::parse_parameter(size_t& ret)
+    {
+        static const std::regex
+            pattern("\\$[0-9]+");
+
+        std::string str;
+        if (!parse_pattern(pattern, str))
+            return false;
+
+        if (!parse_parameter_static(ret, str))
+            throw InvalidParameterException();
+        return true;
+    }
+
     bool Parser::parse_attribute(ColumnAttribute& ret) 
     {
         static const std::regex 
@@ -885,7 +1172,8 @@ namespace memdb
         return true;
     }
 
-    bool Parser::parse_row_ordered(std::vector<Cell>& ret)
+    bool Parser::parse_row_ordered(std::vector<Cell>& ret,
+        RowParameters& parameters)
     {
         Position start_pos = pos_;
 
@@ -906,7 +1194,11 @@ namespace memdb
 
         while (!end_of_list) {
             Cell cell = Cell();
-            parse_cell_data(cell);
+            size_t parameter;
+            if (parse_parameter(parameter))
+                parameters.emplace_back(ret.size(), parameter);
+            else
+                parse_cell_data(cell);
 
             ret.push_back(cell);
             end_of_list = !parse_comma();
@@ -925,7 +1217,8 @@ namespace memdb
         return true;
     }
 
-    bool Parser::parse_row_unordered(std::unordered_map<std::string, Cell>& ret)
+    bool Parser::parse_row_unordered(std::unordered_map<std::string, Cell>& ret,
+        NamedRowParameters& parameters)
     {
         Position start_pos = pos_;
 
@@ -958,7 +1251,10 @@ namespace memdb
                 return false;
             }
 
-            if (!parse_cell_data(cell)) {
+            size_t parameter;
+            if (parse_parameter(parameter))
+                parameters.emplace_back(name, parameter);
+            else if (!parse_cell_data(cell)) {
                 pos_ = start_pos;
                 return false;
             }
@@ -1021,25 +1317,61 @@ namespace memdb
             std::string col;
             Expression exp;
 
-            if (!parse_column_name(col) || !parse_equal_sign() || !parse_expression(exp)) {
+            if (!parse_column_name(col) || !parse_equal_sign() || !parse_set_expression(exp)) {
                 pos_ = start_pos;
                 return false;
             }
 
             set[col] = exp;
 
-            end_of_list = parse_comma();
+            end_of_list = !parse_comma();
         }
 
         return true;
     }
 
+    // Expression of one assignment ends with a comma or WHERE keyword outside of parenthesis and strings
+    bool Parser::parse_set_expression(Expression& ret)
+    {
+        static const std::regex 
+            where_keyword{"\\s+[Ww][Hh][Ee][Rr][Ee]\\s"};
+
+        Position end = pos_;
+        bool in_string = false;
+        int parenthesis = 0;
+
+        for (; end != end_; ++end)
+        {
+            if (*end == '"')
+                in_string = !in_string;
+            if (in_string)
+                continue;
+
+            if (*end == '(') parenthesis++;
+            if (*end == ')') parenthesis--;
+            if (parenthesis > 0)
+                continue;
+
+            if (*end == ',' || std::regex_search(end, end_, where_keyword, 
+                    std::regex_constants::match_continuous))
+                break;
+        }
+
+        std::string str(pos_, end);
+        if (str.empty())
+            return false;
+
+        pos_ = end;
+        ret = Expression(parse_expression(tokenize_expression(str)));
+        return true;
+    }
+
     // Split expression into tokens, assuming the expression is correct
     std::vector<std::string> Parser::tokenize_expression(const std::string& str)
     {
         static const std::regex 
             token_pattern(
-        "([A-Za-z0-9_\\.]+)|(\\+)|(\\-)|(\\/)|(\\*)|(%)|(==)|(!=)|(>=)|(>)|(<=)|(<)|(\\&\\&)|(\\|\\|)(\\^)|(~)|(\\&)|(\\|)|(!)|(\\()|(\\))"
+        "(\\\"[^\\\"]*\\\")|(\\$[0-9]+)|([A-Za-z0-9_\\.]+)|(\\+)|(\\-)|(\\/)|(\\*)|(%)|(==)|(!=)|(>=)|(>)|(<=)|(<)|(\\&\\&)|(\\|\\|)|(\\^)|(~)|(\\&)|(\\|)|(!)|(\\()|(\\))"
         );
 
         static const std::regex 
@@ -1141,10 +1473,17 @@ namespace memdb
 
 
             Cell const_value;
+            size_t parameter;
 
             if (parse_cell_data_static(const_value, *begin))
                 return ExpressionNodePointer(new ConstExpression(const_value));
 
+            if ((*begin)[0] == '$') {
+                if (!parse_parameter_static(parameter, *begin))
+                    throw InvalidParameterException();
+                return ExpressionNodePointer(new ParameterExpression(parameter));
+            }
+
             return ExpressionNodePointer(
                     new ValueExpression(*begin));
         }
@@ -1267,4 +1606,17 @@ namespace memdb
         return false;
     }
 
+    bool Parser::parse_parameter_static(size_t& ret, const std::string& token)
+    {
+        // $1 to $65535
+        static const std::regex
+            pattern("\\$[1-9][0-9]{0,4}");
+
+        if (!match_pattern_static(pattern, token))
+            return false;
+
+        ret = std::stoul(token.substr(1)) - 1;
+        return ret < UINT16_MAX;
+    }
+
 } // namespace memdb
@@ -3,6 +3,8 @@
 
 #include <regex>
 #include <string>
+#include <utility>
+#include <vector>
 #include <cstddef>
 
 #include "cell/cell.hpp"
@@ -19,7 +21,21 @@ namespace memdb
         Select,
         Delete,
         Join,
-        CreateIndex
+        CreateIndex,
+        Save,
+        Load,
+        DropTable,
+        BgSave,
+        BgSaveStatus,
+        Begin,
+        Commit,
+        Rollback,
+        Declare,
+        Fetch,
+        Close,
+        Explain,
+        ExplainAnalyze,
+        CommandTypeCount    // number of command types, not a command
     };
 
     enum KeywordType 
@@ -30,7 +46,8 @@ namespace memdb
         Set,
         On,
         IndexOn,
-        By
+        By,
+        CursorFor
     };
 
     class Expression;
@@ -44,6 +61,10 @@ namespace memdb
     typedef typename std::shared_ptr<SQLCommand> 
         CommandNodePointer;
 
+    // See command.hpp
+    typedef std::vector<std::pair<size_t, size_t>>      RowParameters;
+    typedef std::vector<std::pair<std::string, size_t>> NamedRowParameters;
+
     class Parser
     {
         typedef std::string::const_iterator 
@@ -78,6 +99,13 @@ namespace memdb
         bool parse_update(Command& command);
         bool parse_select(Command& command);
         bool parse_delete(Command& command);
+        bool parse_drop_table(Command& command);
+        bool parse_save(Command& command);
+        bool parse_load(Command& command);
+        bool parse_background_save(Command& command);
+        bool parse_transaction_control(Command& command);
+        bool parse_cursor(Command& command);
+        bool parse_explain(Command& command);
 
         // punctuation parsing
         bool parse_whitespaces();
@@ -91,6 +119,7 @@ namespace memdb
         bool parse_name(std::string& ret);
         bool parse_column_name(std::string& ret);
         bool parse_subquery(std::string& ret);
+        bool parse_path(std::string& ret);
 
         // parsing values
         bool parse_int(int& ret);
@@ -98,6 +127,7 @@ namespace memdb
         bool parse_bool(bool& ret);
         bool parse_bytes(std::vector<std::byte>& ret);
         bool parse_cell_data(Cell& ret);
+        bool parse_parameter(size_t& ret);     // $n, ret is n - 1
 
         // parsing column description
         bool parse_attribute(ColumnAttribute& ret);
@@ -108,14 +138,18 @@ namespace memdb
         bool parse_column_names_list(std::vector<std::string>& ret);
 
         // parsing rows
-        bool parse_row_ordered(std::vector<Cell>& ret);
-        bool parse_row_unordered(std::unordered_map<std::string, Cell>& ret);
+        // Values given as parameters $n are added to parameters instead
+        bool parse_row_ordered(std::vector<Cell>& ret,
+            RowParameters& parameters);
+        bool parse_row_unordered(std::unordered_map<std::string, Cell>& ret,
+            NamedRowParameters& parameters);
 
         // parsing expression
         bool parse_expression(Expression& ret);
 
         // parsing set assignment
         bool parse_set_assignment(std::unordered_map<std::string, Expression>& set);
+        bool parse_set_expression(Expression& ret);
 
         using VecPosition = typename std::vector<std::string>::const_iterator;
 
@@ -135,6 +169,7 @@ namespace memdb
         static bool parse_string_static(std::string& ret, const std::string& token);
         static bool parse_bytes_static(std::vector<std::byte>& ret, const std::string& token);
         static bool parse_cell_data_static(Cell& ret, const std::string& token);
+        static bool parse_parameter_static(size_t& ret, const std::string& token);
     };
 } // namespace memdb
 
@@ -1,13 +1,33 @@
 #ifndef HEADER_GUARD_PROMPT_UTILS_H
 #define HEADER_GUARD_PROMPT_UTILS_H
 
+// Rows of a result printed as a table unless .limit says otherwise
+#define PROMPT_ROW_LIMIT 1000U
+
 static const char help[] = 
     "\n=== memdb ===\n\n.quit or .exit - terminate the program\n\n\
 .history - show session history\n\n\
+.mode table | csv | json - format of results\n\n\
+.limit <rows> - print at most that many rows of a table, 0 for all (default 1000)\n\n\
+.pager on | off - show tables through $PAGER (less -S if unset)\n\n\
+.stats [prometheus] - statements run so far, their latency and rows, and the rows and memory of every table\n\n\
+.slowlog [<ms>] - statements slower than the threshold (100 ms unless started with --slow-ms), or set the threshold\n\n\
 CREATE TABLE <name> <column descriptions>\n\t column description: ([{key | unique | autoincrement} <column_name> : <type>])\n\n\
 SELECT <column list> FROM <table> [WHERE <condition>]\n\n\
 INSERT <row> TO <table>\n\n\
 UPDATE <table> SET <assignments>\n\t assignment: <column_name> = <expression>\n\n\
-DELETE <table> WHERE <contition>\n\n";
+DELETE <table> WHERE <contition>\n\n\
+SAVE \"<path>\" - write snapshot of all tables to a file\n\n\
+LOAD \"<path>\" - replace all tables with a snapshot\n\n\
+BGSAVE \"<path>\" - write snapshot from a background process, queries keep running\n\n\
+BGSAVE STATUS - progress and duration of the running or the last background save\n\n\
+DROP TABLE <name>\n\n\
+BEGIN, COMMIT, ROLLBACK - group statements into a transaction, they see a snapshot taken at BEGIN\n\n\
+DECLARE <cursor> CURSOR FOR SELECT ... - open a cursor over the rows of a table as they are now\n\n\
+FETCH <n> FROM <cursor> - next n rows of the cursor, CLOSE <cursor> - release it\n\n\
+EXPLAIN <statement> - operators the statement runs\n\n\
+EXPLAIN ANALYZE <statement> - run the statement, then rows, time and memory of every operator\n\n\
+Start as 'prompt --data-dir <dir> [--sync always | never | <ms>]' to log every change and recover it on restart\n\n\
+Start with '--slow-log <path>' to append slow statements to a file as well\n\n";
 
 #endif // HEADER_GUARD_PROMPT_UTILS_H
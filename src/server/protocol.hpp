@@ -0,0 +1,58 @@
+#ifndef HEADER_GUARD_SERVER_PROTOCOL_H
+#define HEADER_GUARD_SERVER_PROTOCOL_H
+
+#include <cstdint>
+
+namespace memdb
+{
+    /*
+        Messages of the server protocol. Every message travels in a frame:
+        u32 little-endian length, then the message. A request starts with
+        its type:
+
+            QUERY       u8 1, text of a query
+            PREPARE     u8 2, text of a query with parameters $1, $2, ...
+            EXECUTE     u8 3, u32 statement, u32 count, parameter values
+            CLOSE       u8 4, u32 statement
+
+        Parameter values use the cell encoding of log records (see Encoder):
+        u8 CellType, then INT32 4 bytes, BOOL 1 byte, STRING and BYTES u32
+        length and data. Integers are in host byte order, that is
+        little-endian on every platform memdb builds for.
+
+        A response starts with its status:
+
+            error       u8 1, u32 length, message
+            retry       u8 2, u32 length, message
+            QUERY       u8 0, result in the format of write_columnar
+            EXECUTE     u8 0, result in the format of write_columnar
+            PREPARE     u8 0, u32 statement
+            CLOSE       u8 0
+
+        A retry response is an error of a request the server did not run
+        because it was overloaded; sending the same request later may work.
+
+        Statements without a result set, e.g. INSERT or CREATE TABLE, answer
+        with a result of no columns and no rows.
+
+        Responses come in the order of the requests, so a client knows which
+        kind of response comes next. Statements belong to the connection.
+    */
+
+    enum MessageType : uint8_t
+    {
+        QueryMessage    = 1,
+        PrepareMessage  = 2,
+        ExecuteMessage  = 3,
+        CloseMessage    = 4
+    };
+
+    enum ResponseStatus : uint8_t
+    {
+        ResponseOk      = 0,
+        ResponseError   = 1,
+        ResponseRetry   = 2
+    };
+} // namespace memdb
+
+#endif // HEADER_GUARD_SERVER_PROTOCOL_H
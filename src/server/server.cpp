@@ -0,0 +1,578 @@
+#include "server/server.hpp"
+#include "server/protocol.hpp"
+#include "command/output.hpp"
+#include "parser/parser.hpp"
+#include "storage/codec.hpp"
+
+#include <algorithm>
+#include <thread>
+#include <cerrno>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace memdb
+{
+    // epoll data of the two descriptors that are not connections
+    static const uint64_t listen_id = 0;
+    static const uint64_t wake_id   = 1;
+
+    // Bytes read from a socket at a time
+    static const size_t read_size = 64 * 1024;
+
+    static std::string errno_string()
+    {
+        return std::string(strerror(errno));
+    }
+
+    static uint32_t load_u32(const char* data)
+    {
+        auto bytes = reinterpret_cast<const unsigned char*>(data);
+        return uint32_t(bytes[0]) | uint32_t(bytes[1]) << 8
+            | uint32_t(bytes[2]) << 16 | uint32_t(bytes[3]) << 24;
+    }
+
+    static void append_error(std::string_view error, OutputBuffer& out)
+    {
+        out.append_u8(ResponseError);
+        out.append_u32(error.size());
+        out.append(error);
+    }
+
+    static void append_result(const Result& res, OutputBuffer& out)
+    {
+        if (!res.ok()) {
+            append_error(res.error(), out);
+            return;
+        }
+        // a borrowed table is the one a statement changed, not a result set.
+        // Sending it whole would answer every INSERT with the entire table
+        out.append_u8(ResponseOk);
+        if (res.shared_table())
+            write_columnar(nullptr, out);
+        else
+            write_columnar(res.get_table(), out);
+    }
+
+    static const std::string_view overloaded = "Server overloaded, retry later\n";
+
+    static void append_rejected(OutputBuffer& out)
+    {
+        out.append_u8(ResponseRetry);
+        out.append_u32(overloaded.size());
+        out.append(overloaded);
+    }
+
+    void Server::judge(Connection& connection, Request& request)
+    {
+        std::string_view message = request.message_;
+        if (message.empty())
+            return;
+
+        std::string_view body = message.substr(1);
+        try
+        {
+            switch (message[0])
+            {
+            case QueryMessage:
+            {
+                request.command_ = connection.session_.parse(std::string(body));
+                break;
+            }
+            case ExecuteMessage:
+            {
+                Decoder in(body.data(), body.size());
+                uint32_t statement = in.get<uint32_t>();
+                std::vector<Cell> parameters = in.get_cells();
+                request.command_ = connection.session_.bind(statement, parameters);
+                break;
+            }
+            default:
+                return;     // PREPARE and CLOSE read no table
+            }
+        }
+        catch (std::exception& ex)
+        {
+            // parse errors, unknown statements and malformed parameters
+            request.error_ = ex.what();
+            return;
+        }
+
+        request.heavy_ = request.command_.estimate(&connection.session_) >= options_.heavy_rows_;
+    }
+
+    void Server::respond(Connection& connection, Request& request, OutputBuffer& out)
+    {
+        Session& session = connection.session_;
+        std::string_view message = request.message_;
+
+        if (!request.admitted_) {
+            append_rejected(out);
+            return;
+        }
+        if (message.empty()) {
+            append_error("Empty request\n", out);
+            return;
+        }
+        if (!request.error_.empty()) {
+            append_error(request.error_, out);
+            return;
+        }
+
+        std::string_view body = message.substr(1);
+        try
+        {
+            switch (message[0])
+            {
+            case QueryMessage:
+            case ExecuteMessage:
+                append_result(request.command_.execute(&session), out);
+                return;
+
+            case PrepareMessage:
+            {
+                uint32_t statement = session.prepare(std::string(body));
+                out.append_u8(ResponseOk);
+                out.append_u32(statement);
+                return;
+            }
+
+            case CloseMessage:
+            {
+                Decoder in(body.data(), body.size());
+                uint32_t statement = in.get<uint32_t>();
+                if (!session.deallocate(statement)) {
+                    append_error(UnknownStatementException(statement).what(), out);
+                    return;
+                }
+                out.append_u8(ResponseOk);
+                return;
+            }
+
+            default:
+                append_error("Unknown request type " + std::to_string(uint8_t(message[0])) + "\n", out);
+                return;
+            }
+        }
+        catch (std::exception& ex)
+        {
+            // parse errors of PREPARE and a malformed CLOSE
+            append_error(ex.what(), out);
+        }
+    }
+
+    Server::Connection::Connection(uint64_t id, int fd, Database& database)
+    : id_(id), fd_(fd), session_(database)
+    { }
+
+    Server::Server(Database& database, const ServerOptions& options)
+    : database_(database), options_(options), next_id_(wake_id + 1)
+    {
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(options.port_);
+        if (inet_pton(AF_INET, options.host_.c_str(), &address.sin_addr) != 1)
+            throw ServerException("invalid address " + options.host_);
+
+        listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listen_fd_ < 0)
+            throw ServerException("cannot create socket: " + errno_string());
+
+        int reuse = 1;
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0
+            || listen(listen_fd_, SOMAXCONN) < 0) {
+            std::string reason = errno_string();
+            ::close(listen_fd_);
+            throw ServerException("cannot listen on " + options.host_ + ":"
+                + std::to_string(options.port_) + ": " + reason);
+        }
+
+        socklen_t length = sizeof(address);
+        getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&address), &length);
+        port_ = ntohs(address.sin_port);
+
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epoll_fd_ < 0 || wake_fd_ < 0) {
+            std::string reason = errno_string();
+            ::close(listen_fd_);
+            if (epoll_fd_ >= 0)
+                ::close(epoll_fd_);
+            throw ServerException("cannot create event loop: " + reason);
+        }
+
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = listen_id;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &event);
+        event.data.u64 = wake_id;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+
+        unsigned workers = options.workers_ ? options.workers_ : std::thread::hardware_concurrency();
+        unsigned heavy_workers = options.heavy_workers_ ? options.heavy_workers_ : std::max(workers / 4, 1U);
+        workers_ = std::make_unique<WorkerPool>(workers);
+        heavy_workers_ = std::make_unique<WorkerPool>(heavy_workers);
+    }
+
+    Server::~Server()
+    {
+        // requests already queued still run, their responses are dropped
+        workers_.reset();
+        heavy_workers_.reset();
+
+        for (auto& [id, connection] : connections_)
+            ::close(connection->fd_);
+        ::close(wake_fd_);
+        ::close(epoll_fd_);
+        ::close(listen_fd_);
+    }
+
+    void Server::stop()
+    {
+        stopping_ = true;
+
+        uint64_t one = 1;
+        [[maybe_unused]] ssize_t res = write(wake_fd_, &one, sizeof(one));
+    }
+
+    void Server::wake(uint64_t id)
+    {
+        {
+            std::lock_guard<std::mutex> lock(ready_mutex_);
+            ready_.push_back(id);
+        }
+
+        uint64_t one = 1;
+        [[maybe_unused]] ssize_t res = write(wake_fd_, &one, sizeof(one));
+    }
+
+    void Server::run()
+    {
+        epoll_event events[64];
+
+        while (!stopping_)
+        {
+            int count = epoll_wait(epoll_fd_, events, 64, -1);
+            if (count < 0) {
+                if (errno == EINTR)
+                    continue;
+                throw ServerException("event loop failed: " + errno_string());
+            }
+
+            for (int i = 0; i < count; ++i)
+            {
+                uint64_t id = events[i].data.u64;
+
+                if (id == listen_id) {
+                    accept_connections();
+                    continue;
+                }
+
+                if (id == wake_id) {
+                    uint64_t value;
+                    [[maybe_unused]] ssize_t res = read(wake_fd_, &value, sizeof(value));
+
+                    std::vector<uint64_t> ready;
+                    {
+                        std::lock_guard<std::mutex> lock(ready_mutex_);
+                        ready.swap(ready_);
+                    }
+
+                    // output of workers, the connection may be gone already
+                    for (uint64_t ready_id : ready) {
+                        auto it = connections_.find(ready_id);
+                        if (it == connections_.end())
+                            continue;
+                        std::shared_ptr<Connection> connection = it->second;
+                        send(*connection);
+                        dispatch(connection);
+                        update(*connection);
+                    }
+                    continue;
+                }
+
+                auto it = connections_.find(id);
+                if (it == connections_.end())
+                    continue;
+                std::shared_ptr<Connection> connection = it->second;
+
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                    receive(*connection);
+                if (events[i].events & EPOLLOUT)
+                    send(*connection);
+
+                dispatch(connection);
+                update(*connection);
+            }
+        }
+    }
+
+    void Server::accept_connections()
+    {
+        for (;;)
+        {
+            int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0)
+                return;     // EAGAIN once every pending connection is taken
+
+            // responses are written whole, no need to wait for more
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+            auto connection = std::make_shared<Connection>(next_id_++, fd, database_);
+            connections_.emplace(connection->id_, connection);
+            update(*connection);
+        }
+    }
+
+    void Server::receive(Connection& connection)
+    {
+        // one read per wake-up: epoll is level-triggered and reports the rest
+        // again, so a client that keeps sending does not hold the loop. Bytes
+        // are read after the received ones, input_ is only resized when that
+        // is past its end and never grows past one whole frame, the longest
+        // incomplete one is parsed before more is read
+        size_t size = connection.received_;
+        received_bytes_ -= size;
+        size_t room = std::min(read_size, SERVER_MAX_REQUEST + sizeof(uint32_t) - size);
+        if (connection.input_.size() < size + room)
+            connection.input_.resize(size + room);
+
+        ssize_t res = recv(connection.fd_, connection.input_.data() + size, room, 0);
+        connection.received_ = size + std::max<ssize_t>(res, 0);
+
+        // the client is done sending, or the connection failed
+        if (res == 0 || (res < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+            connection.eof_ = true;
+
+        if (!parse_requests(connection)) {
+            // nothing more is read, the frames before it are still answered
+            connection.eof_ = true;
+            connection.received_ = 0;
+        }
+        received_bytes_ += connection.received_;
+    }
+
+    bool Server::parse_requests(Connection& connection)
+    {
+        std::vector<char>& input = connection.input_;
+        size_t& size = connection.received_;
+        size_t offset = 0;
+        bool valid = true;
+
+        std::lock_guard<std::mutex> lock(connection.mutex_);
+        while (size - offset >= sizeof(uint32_t))
+        {
+            uint32_t length = load_u32(input.data() + offset);
+            if (length > SERVER_MAX_REQUEST) {
+                valid = false;
+                break;
+            }
+            if (size - offset - sizeof(uint32_t) < length)
+                break;
+
+            offset += sizeof(uint32_t);
+            admit(connection, std::string_view(input.data() + offset, length));
+            offset += length;
+        }
+
+        // the incomplete frame moves to the front, input keeps its size
+        if (offset > 0) {
+            std::copy(input.begin() + offset, input.begin() + size, input.begin());
+            size -= offset;
+        }
+        return valid;
+    }
+
+    void Server::admit(Connection& connection, std::string_view message)
+    {
+        bool admitted = connection.admitted_ < options_.connection_requests_
+            && connection.admitted_bytes_ < options_.connection_bytes_
+            && admitted_ < options_.total_requests_
+            && admitted_bytes_ < options_.total_bytes_;
+
+        if (!admitted) {
+            // with nothing before it the answer needs no worker
+            if (!connection.busy_ && connection.requests_.empty()) {
+                OutputBuffer out;
+                out.append_u32(sizeof(uint8_t) + sizeof(uint32_t) + overloaded.size());
+                append_rejected(out);
+                connection.output_.insert(connection.output_.end(), out.view().begin(), out.view().end());
+            }
+            else
+                connection.requests_.emplace_back().admitted_ = false;
+            return;
+        }
+
+        connection.requests_.emplace_back().message_ = message;
+        connection.admitted_++;
+        connection.admitted_bytes_ += message.size();
+        admitted_++;
+        admitted_bytes_ += message.size();
+    }
+
+    void Server::send(Connection& connection)
+    {
+        std::lock_guard<std::mutex> lock(connection.mutex_);
+        std::vector<char>& output = connection.output_;
+
+        while (connection.sent_ < output.size())
+        {
+            ssize_t res = ::send(connection.fd_, output.data() + connection.sent_,
+                output.size() - connection.sent_, MSG_NOSIGNAL);
+            if (res < 0 && errno == EINTR)
+                continue;
+            if (res < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                return;
+            if (res < 0) {
+                // the client is gone, its responses are dropped
+                connection.eof_ = true;
+                output.clear();
+                connection.sent_ = 0;
+                return;
+            }
+            connection.sent_ += res;
+        }
+
+        output.clear();
+        connection.sent_ = 0;
+    }
+
+    void Server::dispatch(const std::shared_ptr<Connection>& connection)
+    {
+        bool heavy;
+        {
+            std::lock_guard<std::mutex> lock(connection->mutex_);
+            if (connection->busy_ || connection->requests_.empty()
+                || connection->output_.size() - connection->sent_ >= SERVER_MAX_OUTPUT)
+                return;
+            connection->busy_ = true;
+            heavy = connection->requests_.front().heavy_;
+        }
+
+        WorkerPool& pool = heavy ? *heavy_workers_ : *workers_;
+        pool.submit([this, connection, heavy] { serve(connection, heavy); });
+    }
+
+    void Server::serve(const std::shared_ptr<Connection>& connection, bool heavy)
+    {
+        OutputBuffer out;
+
+        for (;;)
+        {
+            // the event loop only appends to requests_, the front stays in place
+            Request* request;
+            {
+                std::lock_guard<std::mutex> lock(connection->mutex_);
+                if (connection->requests_.empty()
+                    || connection->output_.size() - connection->sent_ >= SERVER_MAX_OUTPUT) {
+                    // the event loop dispatches the rest once output is sent
+                    connection->busy_ = false;
+                    break;
+                }
+                request = &connection->requests_.front();
+            }
+
+            // only the worker serving the connection touches its front request
+            if (request->admitted_ && !request->judged_) {
+                judge(*connection, *request);
+                request->judged_ = true;
+            }
+
+            if (request->admitted_ && request->heavy_ != heavy) {
+                // the event loop hands the connection to the other pool
+                std::lock_guard<std::mutex> lock(connection->mutex_);
+                connection->busy_ = false;
+                break;
+            }
+
+            // the length of the frame is filled in once the result is written
+            out.clear();
+            out.append_u32(0);
+            respond(*connection, *request, out);
+            out.store_u32(0, out.size() - sizeof(uint32_t));
+
+            {
+                std::lock_guard<std::mutex> lock(connection->mutex_);
+                std::string_view frame = out.view();
+                connection->output_.insert(connection->output_.end(), frame.begin(), frame.end());
+
+                if (request->admitted_) {
+                    size_t size = request->message_.size();
+                    connection->admitted_--;
+                    connection->admitted_bytes_ -= size;
+                    admitted_--;
+                    admitted_bytes_ -= size;
+                }
+                connection->requests_.pop_front();
+            }
+            wake(connection->id_);
+        }
+
+        wake(connection->id_);
+    }
+
+    void Server::update(Connection& connection)
+    {
+        bool busy, output, throttled;
+        {
+            std::lock_guard<std::mutex> lock(connection.mutex_);
+            busy = connection.busy_ || !connection.requests_.empty();
+            output = connection.sent_ < connection.output_.size();
+            throttled = connection.requests_.size() >= SERVER_MAX_PIPELINE
+                || connection.output_.size() - connection.sent_ >= SERVER_MAX_OUTPUT;
+
+            // received bytes count against the byte bounds as admitted ones do. Only
+            // a connection with requests admitted waits, it is updated again once
+            // they are done, so the frame of an idle one is always read whole
+            throttled = throttled || (connection.admitted_ > 0
+                && (connection.admitted_bytes_ + connection.received_ >= options_.connection_bytes_
+                    || admitted_bytes_ + received_bytes_ >= options_.total_bytes_));
+        }
+
+        // every request is answered before the connection is closed
+        if (connection.eof_ && !busy && !output) {
+            close(connection);
+            return;
+        }
+
+        uint32_t events = 0;
+        if (!connection.eof_ && !throttled)
+            events |= EPOLLIN;
+        if (output)
+            events |= EPOLLOUT;
+
+        if (events == connection.events_)
+            return;
+
+        // a connection waiting for nothing is left out, so a hang-up does not wake the loop
+        epoll_event event{};
+        event.events = events;
+        event.data.u64 = connection.id_;
+        if (!events)
+            epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, connection.fd_, nullptr);
+        else
+            epoll_ctl(epoll_fd_, connection.events_ ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, connection.fd_, &event);
+        connection.events_ = events;
+    }
+
+    void Server::close(Connection& connection)
+    {
+        if (connection.events_)
+            epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, connection.fd_, nullptr);
+        ::close(connection.fd_);
+        received_bytes_ -= connection.received_;
+        connection.received_ = 0;
+
+        // a worker may still hold the connection, its session goes with the last owner
+        connections_.erase(connection.id_);
+    }
+} // namespace memdb
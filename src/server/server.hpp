@@ -0,0 +1,214 @@
+#ifndef HEADER_GUARD_SERVER_SERVER_H
+#define HEADER_GUARD_SERVER_SERVER_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "command/command.hpp"
+#include "database/database.hpp"
+#include "database/session.hpp"
+#include "server/worker_pool.hpp"
+
+// Port memdb-server listens on unless told otherwise
+#define SERVER_DEFAULT_PORT 7480U
+
+// Largest request frame accepted, a bigger one closes the connection
+#define SERVER_MAX_REQUEST (16U * 1024U * 1024U)
+
+// A connection is not read from while this many requests wait for a worker
+// or this many response bytes wait to be sent, until the client catches up
+#define SERVER_MAX_PIPELINE 1024U
+#define SERVER_MAX_OUTPUT   (64U * 1024U * 1024U)
+
+// Default bounds of the requests admitted to run, queued or running, per
+// connection and for the whole server. Past them a request is answered
+// with a retryable error instead of being run
+#define SERVER_CONNECTION_REQUESTS  256U
+#define SERVER_CONNECTION_BYTES     (16U * 1024U * 1024U)
+#define SERVER_TOTAL_REQUESTS       4096U
+#define SERVER_TOTAL_BYTES          (256U * 1024U * 1024U)
+
+// Default number of rows a query is estimated to read to run on the heavy pool
+#define SERVER_HEAVY_ROWS           100000U
+
+namespace memdb
+{
+    class OutputBuffer;
+
+    struct ServerOptions
+    {
+        std::string host_ = "127.0.0.1";           // address to listen on
+        uint16_t    port_ = SERVER_DEFAULT_PORT;    // 0 picks a free port
+        unsigned    workers_ = 0;                   // 0 for one per hardware thread
+
+        // Admission control, see Server
+        size_t      connection_requests_ = SERVER_CONNECTION_REQUESTS;
+        size_t      connection_bytes_ = SERVER_CONNECTION_BYTES;
+        size_t      total_requests_ = SERVER_TOTAL_REQUESTS;
+        size_t      total_bytes_ = SERVER_TOTAL_BYTES;
+
+        size_t      heavy_rows_ = SERVER_HEAVY_ROWS;   // estimated rows of a heavy query
+        unsigned    heavy_workers_ = 0;             // 0 for a quarter of the workers, at least one
+    };
+
+    /*
+        TCP server sharing one Database between many client processes.
+
+        Every message is a frame: u32 little-endian length, then that many
+        bytes. Requests run a query or a prepared statement, responses carry
+        results in columnar batches; the messages are described in
+        protocol.hpp. Clients may pipeline: send any number of requests
+        without waiting, the responses come back in the same order.
+
+        One thread runs a non-blocking epoll loop that accepts connections,
+        reads requests and writes responses. Queries run on a WorkerPool.
+        Every connection has a Session of its own, so transactions and
+        cursors live as long as the connection; its requests run one after
+        another on one worker at a time, while other connections run in
+        parallel on the other workers.
+
+        Requests are admitted as they are read: a connection has at most
+        connection_requests_ requests of connection_bytes_ bytes queued or
+        running, the server total_requests_ of total_bytes_. A request past
+        a bound is not run but answered with a retryable error, right away
+        if nothing of its connection is queued before it. So an overloaded
+        server keeps its queues short instead of slowing every query down.
+        Bytes received but not framed yet count against the byte bounds
+        too: a connection with admitted requests is not read from while
+        they and its input reach a bound.
+
+        Queries estimated to read at least heavy_rows_ rows (full scans of
+        large tables, see SQLCommand::estimate) run on a smaller pool of
+        heavy_workers_ threads. Reports then wait for each other while
+        point queries keep the main pool to themselves.
+    */
+    class Server
+    {
+    public:
+        // Listen on options.host_ and options.port_, throw ServerException on failure
+        Server(Database& database, const ServerOptions& options = ServerOptions());
+
+        // run() must have returned
+        ~Server();
+
+        Server(const Server& other)             = delete;
+        Server& operator= (const Server& other) = delete;
+
+        // Port listened on, the one picked if options.port_ was 0
+        uint16_t port() const { return port_; }
+
+        // Serve clients until stop() is called
+        void run();
+
+        // Make run() return. Safe from any thread and from signal handlers
+        void stop();
+
+    private:
+        // Request frame of a connection, judged by the worker that reaches it first
+        struct Request
+        {
+            std::string message_;
+            bool        admitted_ = true;   // false: answered with a retryable error
+            bool        judged_ = false;    // parsed and estimated
+            bool        heavy_ = false;     // runs on the heavy pool
+            Command     command_;           // of QUERY and EXECUTE once judged
+            std::string error_;             // why judging failed
+        };
+
+        struct Connection
+        {
+            Connection(uint64_t id, int fd, Database& database);
+
+            const uint64_t      id_;
+            const int           fd_;
+            Session             session_;
+
+            // event loop only
+            std::vector<char>   input_;         // received bytes of incomplete frames, only grows
+            size_t              received_ = 0;  // bytes of input_ holding them
+            uint32_t            events_ = 0;    // registered with epoll
+            bool                eof_ = false;   // client sent everything it will send
+
+            // shared with the worker serving the connection
+            std::mutex          mutex_;
+            std::deque<Request> requests_;      // waiting for the worker, then running
+            size_t              admitted_ = 0;  // requests_ admitted to run
+            size_t              admitted_bytes_ = 0;
+            std::vector<char>   output_;        // response frames not sent yet
+            size_t              sent_ = 0;      // bytes of output_ already sent
+            bool                busy_ = false;  // a worker is running requests
+        };
+
+        void accept_connections();
+
+        // Read what the client sent, queue complete requests
+        void receive(Connection& connection);
+
+        // Send as much output as the socket takes
+        void send(Connection& connection);
+
+        // Queue requests of complete frames received in input_, false for a frame too long
+        bool parse_requests(Connection& connection);
+
+        // Queue message if the bounds admit it, a retryable error otherwise.
+        // Caller holds the connection mutex
+        void admit(Connection& connection, std::string_view message);
+
+        // Hand the connection to a worker if requests wait and none serves it
+        void dispatch(const std::shared_ptr<Connection>& connection);
+
+        // Worker of the pool heavy or not: run the queued requests of connection
+        // in order, until one belongs to the other pool
+        void serve(const std::shared_ptr<Connection>& connection, bool heavy);
+
+        // Worker: parse request and decide on its pool
+        void judge(Connection& connection, Request& request);
+
+        // Worker: run request, append the response message to out
+        void respond(Connection& connection, Request& request, OutputBuffer& out);
+
+        // Register the events connection waits for, close it once it is done
+        void update(Connection& connection);
+
+        void close(Connection& connection);
+
+        // Tell the event loop from a worker that connection has output
+        void wake(uint64_t id);
+
+        Database&           database_;
+        const ServerOptions options_;
+        int                 listen_fd_ = -1;
+        int                 epoll_fd_ = -1;
+        int                 wake_fd_ = -1;      // eventfd, see wake
+        uint16_t            port_ = 0;
+        std::atomic<bool>   stopping_ = false;
+        uint64_t            next_id_;
+
+        std::unordered_map<uint64_t, std::shared_ptr<Connection>>
+                            connections_;       // event loop only
+
+        std::mutex          ready_mutex_;
+        std::vector<uint64_t>
+                            ready_;             // connections with new output
+
+        // admitted requests of all connections
+        std::atomic<size_t> admitted_ = 0;
+        std::atomic<size_t> admitted_bytes_ = 0;
+        size_t              received_bytes_ = 0;    // received_ of all connections, event loop only
+
+        // only the event loop submits tasks, so the pools are stopped one by one
+        std::unique_ptr<WorkerPool>
+                            heavy_workers_;
+        std::unique_ptr<WorkerPool>
+                            workers_;           // last, stopped first
+    };
+} // namespace memdb
+
+#endif // HEADER_GUARD_SERVER_SERVER_H
@@ -0,0 +1,48 @@
+#include "server/worker_pool.hpp"
+
+#include <algorithm>
+
+namespace memdb
+{
+    WorkerPool::WorkerPool(unsigned threads)
+    {
+        for (auto i = 0U; i < std::max(threads, 1U); ++i)
+            threads_.emplace_back(&WorkerPool::loop, this);
+    }
+
+    WorkerPool::~WorkerPool()
+    {
+        // a thread stops on a release with no task left, after the queued tasks
+        ready_.release(threads_.size());
+        for (auto& thread : threads_)
+            thread.join();
+    }
+
+    void WorkerPool::submit(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.push_back(std::move(task));
+        }
+        ready_.release();
+    }
+
+    void WorkerPool::loop()
+    {
+        for (;;)
+        {
+            ready_.acquire();
+
+            std::function<void()> task;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (tasks_.empty())
+                    return;     // stopped with nothing left to run
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+
+            task();
+        }
+    }
+} // namespace memdb
@@ -0,0 +1,44 @@
+#ifndef HEADER_GUARD_SERVER_WORKER_POOL_H
+#define HEADER_GUARD_SERVER_WORKER_POOL_H
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <semaphore>
+#include <thread>
+#include <vector>
+
+namespace memdb
+{
+    /*
+        Fixed set of threads running submitted tasks in submission order.
+
+        Tasks still queued when the pool is destroyed are run before the
+        threads are joined, so a task may rely on what it captured staying
+        alive until the pool is gone.
+    */
+    class WorkerPool
+    {
+    public:
+        // Start threads, at least one
+        WorkerPool(unsigned threads);
+        ~WorkerPool();
+
+        WorkerPool(const WorkerPool& other)             = delete;
+        WorkerPool& operator= (const WorkerPool& other) = delete;
+
+        void submit(std::function<void()> task);
+
+        size_t threads() const { return threads_.size(); }
+
+    private:
+        void loop();
+
+        std::mutex                          mutex_;
+        std::deque<std::function<void()>>   tasks_;
+        std::counting_semaphore<>           ready_{0};      // one release per task, one per thread to stop
+        std::vector<std::thread>            threads_;
+    };
+} // namespace memdb
+
+#endif // HEADER_GUARD_SERVER_WORKER_POOL_H
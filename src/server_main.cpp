@@ -0,0 +1,106 @@
+#include "database/database.hpp"
+#include "server/server.hpp"
+
+#include <csignal>
+#include <iostream>
+#include <string>
+
+
+using namespace std;
+using namespace memdb;
+
+static Server* running_server = nullptr;
+
+static void stop_server(int)
+{
+	if (running_server)
+		running_server->stop();
+}
+
+int main (int argc, char** argv) 
+{
+	// memdb-server [--host <address>] [--port <port>] [--workers <n>]
+	//              [--data-dir <dir>] [--sync always | never | <ms>]
+	//              [--connection-requests <n>] [--connection-bytes <n>]
+	//              [--total-requests <n>] [--total-bytes <n>]
+	//              [--heavy-rows <n>] [--heavy-workers <n>]
+	//              [--slow-ms <ms>] [--slow-log <path>]
+	DurabilityOptions options;
+	ServerOptions server_options;
+	SlowLogOptions slow_options;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+
+		if (arg == "--host" && i + 1 < argc)
+			server_options.host_ = argv[++i];
+		else if (arg == "--port" && i + 1 < argc)
+			server_options.port_ = std::stoul(argv[++i]);
+		else if (arg == "--workers" && i + 1 < argc)
+			server_options.workers_ = std::stoul(argv[++i]);
+		else if (arg == "--connection-requests" && i + 1 < argc)
+			server_options.connection_requests_ = std::stoul(argv[++i]);
+		else if (arg == "--connection-bytes" && i + 1 < argc)
+			server_options.connection_bytes_ = std::stoul(argv[++i]);
+		else if (arg == "--total-requests" && i + 1 < argc)
+			server_options.total_requests_ = std::stoul(argv[++i]);
+		else if (arg == "--total-bytes" && i + 1 < argc)
+			server_options.total_bytes_ = std::stoul(argv[++i]);
+		else if (arg == "--heavy-rows" && i + 1 < argc)
+			server_options.heavy_rows_ = std::stoul(argv[++i]);
+		else if (arg == "--heavy-workers" && i + 1 < argc)
+			server_options.heavy_workers_ = std::stoul(argv[++i]);
+		else if (arg == "--slow-ms" && i + 1 < argc)
+			slow_options.threshold_us_ = std::stoul(argv[++i]) * 1000;
+		else if (arg == "--slow-log" && i + 1 < argc)
+			slow_options.path_ = argv[++i];
+		else if (arg == "--data-dir" && i + 1 < argc)
+			options.directory_ = argv[++i];
+		else if (arg == "--sync" && i + 1 < argc) {
+			std::string policy = argv[++i];
+			if (policy == "always")
+				options.sync_policy_ = SyncEveryCommit;
+			else if (policy == "never")
+				options.sync_policy_ = SyncNever;
+			else {
+				options.sync_policy_ = SyncInterval;
+				options.sync_interval_ms_ = std::stoul(policy);
+			}
+		}
+		else {
+			cerr << "unknown argument " << arg << "\n";
+			return 1;
+		}
+	}
+
+	std::unique_ptr<Database> database;
+	std::unique_ptr<Server> server;
+	try {
+		database = options.directory_.empty() 
+			? std::make_unique<Database>() 
+			: std::make_unique<Database>(options);
+		database->slow_log().configure(slow_options);
+		server = std::make_unique<Server>(*database, server_options);
+	}
+	catch (DatabaseException& ex) {
+		cerr << ex.what();
+		return 1;
+	}
+
+	running_server = server.get();
+	std::signal(SIGINT, stop_server);
+	std::signal(SIGTERM, stop_server);
+
+	cout << "memdb-server listening on " << server_options.host_ << ":" << server->port() << endl;
+
+	try {
+		server->run();
+	}
+	catch (DatabaseException& ex) {
+		cerr << ex.what();
+		return 1;
+	}
+
+	running_server = nullptr;
+	return 0;
+}
@@ -0,0 +1,138 @@
+#include "storage/background_save.hpp"
+#include "storage/snapshot.hpp"
+
+#include <new>
+#include <cstring>
+#include <cerrno>
+
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+namespace memdb
+{
+    struct BackgroundSave::Shared
+    {
+        SnapshotProgress        progress_;
+        std::atomic<uint64_t>   duration_ms_{0};    // set by the child when it is done
+        char                    error_[256] = {0};
+    };
+
+    static uint64_t elapsed_ms(std::chrono::steady_clock::time_point since)
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - since).count();
+    }
+
+    BackgroundSave::BackgroundSave()
+    : shared_(nullptr), pid_(-1)
+    { }
+
+    BackgroundSave::~BackgroundSave()
+    {
+        reap(true);
+
+        if (shared_) {
+            shared_->~Shared();
+            ::munmap(shared_, sizeof(Shared));
+        }
+    }
+
+    void BackgroundSave::start(const std::string& path, const std::vector<Table*>& tables,
+        uint64_t wal_lsn)
+    {
+        reap(false);
+        if (pid_ > 0)
+            throw SnapshotException(path, "background save to \"" + status_.path_ + "\" is in progress");
+
+        if (!shared_)
+        {
+            void* memory = ::mmap(nullptr, sizeof(Shared), PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+            if (memory == MAP_FAILED)
+                throw SnapshotException(path, "cannot map progress: " + std::string(strerror(errno)));
+            shared_ = new (memory) Shared();
+        }
+
+        shared_->progress_.cells_total_ = 0;
+        shared_->progress_.cells_written_ = 0;
+        shared_->duration_ms_ = 0;
+        shared_->error_[0] = '\0';
+
+        started_ = std::chrono::steady_clock::now();
+        pid_t pid = ::fork();
+        uint64_t fork_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - started_).count();
+
+        if (pid < 0)
+            throw SnapshotException(path, "fork failed: " + std::string(strerror(errno)));
+
+        if (pid == 0)
+        {
+            // child: only this thread exists here, write the snapshot and leave
+            int code = 0;
+            try {
+                Snapshot::save(path, tables, wal_lsn, &shared_->progress_);
+            }
+            catch (std::exception& ex) {
+                std::strncpy(shared_->error_, ex.what(), sizeof(shared_->error_) - 1);
+                code = 1;
+            }
+            shared_->duration_ms_ = std::max<uint64_t>(elapsed_ms(started_), 1);
+            ::_exit(code);
+        }
+
+        pid_ = pid;
+        status_ = BackgroundSaveStatus();
+        status_.state_      = BackgroundSaveStatus::Running;
+        status_.path_       = path;
+        status_.wal_lsn_    = wal_lsn;
+        status_.fork_us_    = fork_us;
+    }
+
+    BackgroundSaveStatus BackgroundSave::status()
+    {
+        reap(false);
+
+        if (status_.state_ == BackgroundSaveStatus::Running)
+        {
+            uint64_t total = shared_->progress_.cells_total_;
+            uint64_t written = shared_->progress_.cells_written_;
+
+            status_.progress_ = total ? written * 100 / total : 0;
+            status_.duration_ms_ = elapsed_ms(started_);
+        }
+        return status_;
+    }
+
+    void BackgroundSave::reap(bool wait)
+    {
+        if (pid_ <= 0)
+            return;
+
+        int code;
+        pid_t res;
+        while ((res = ::waitpid(pid_, &code, wait ? 0 : WNOHANG)) < 0 && errno == EINTR)
+            ;
+
+        if (res == 0)
+            return; // still running
+
+        pid_ = -1;
+        status_.duration_ms_ = shared_->duration_ms_ ? shared_->duration_ms_.load() : elapsed_ms(started_);
+
+        if (res > 0 && WIFEXITED(code) && WEXITSTATUS(code) == 0) {
+            status_.state_ = BackgroundSaveStatus::Done;
+            status_.progress_ = 100;
+            return;
+        }
+
+        status_.state_ = BackgroundSaveStatus::Failed;
+        if (shared_->error_[0])
+            status_.error_ = shared_->error_;
+        else if (res > 0 && WIFSIGNALED(code))
+            status_.error_ = "child killed by signal " + std::to_string(WTERMSIG(code));
+        else
+            status_.error_ = "child exited abnormally";
+    }
+} // namespace memdb
@@ -0,0 +1,71 @@
+#ifndef HEADER_GUARD_STORAGE_BACKGROUND_SAVE_H
+#define HEADER_GUARD_STORAGE_BACKGROUND_SAVE_H
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+
+#include <sys/types.h>
+
+#include "database/table.hpp"
+
+namespace memdb
+{
+    struct BackgroundSaveStatus
+    {
+        enum State { Idle, Running, Done, Failed };
+
+        State       state_ = Idle;
+        std::string path_;
+        std::string error_;             // reason of the last failure
+        uint64_t    wal_lsn_ = 0;       // lsn the snapshot is consistent with
+        unsigned    progress_ = 0;      // percent of cells written
+        uint64_t    duration_ms_ = 0;   // time spent so far, or total time when finished
+        uint64_t    fork_us_ = 0;       // time the caller was blocked in fork()
+    };
+
+    /*
+        Snapshot written by a forked child process.
+
+        fork() gives the child a copy-on-write image of the whole database as it was
+        at the moment of the call, so the snapshot is consistent without holding
+        any lock while it is written. The parent only pays for copying page tables
+        in fork() and for the pages it modifies while the child is running.
+
+        The child reports progress through a small MAP_SHARED region and leaves
+        with _exit(), so it never runs destructors or touches the parent's log.
+    */
+    class BackgroundSave
+    {
+    public:
+        BackgroundSave();
+
+        // Waits for the running child, a started snapshot is always completed
+        ~BackgroundSave();
+
+        BackgroundSave(const BackgroundSave& other)             = delete;
+        BackgroundSave& operator= (const BackgroundSave& other) = delete;
+
+        // Fork and write tables to path from the child, return as soon as the child runs.
+        // Only one save may run at a time
+        void start(const std::string& path, const std::vector<Table*>& tables, uint64_t wal_lsn);
+
+        // State of the running or the last finished save
+        BackgroundSaveStatus status();
+
+    private:
+        struct Shared;
+
+        // Collect the exit status of a finished child, block if wait is set
+        void reap(bool wait);
+
+        Shared*                 shared_;    // mapping shared with the child
+        pid_t                   pid_;       // running child or -1
+        BackgroundSaveStatus    status_;
+        std::chrono::steady_clock::time_point
+                                started_;
+    };
+} // namespace memdb
+
+#endif // HEADER_GUARD_STORAGE_BACKGROUND_SAVE_H
@@ -0,0 +1,90 @@
+#include "storage/codec.hpp"
+
+namespace memdb
+{
+    void Encoder::put_cell(const Cell& cell)
+    {
+        CellType type = cell.get_type();
+        put<uint8_t>(type);
+
+        switch (type)
+        {
+        case CellType::INT32:   put<int32_t>(cell.get_int()); return;
+        case CellType::BOOL:    put<uint8_t>(cell.get_bool()); return;
+        case CellType::STRING:  put_string(cell.get_string()); return;
+        default:
+        {
+            auto bytes = cell.get_bytes();
+            put<uint32_t>(bytes.size());
+            put_data(bytes.data(), bytes.size());
+            return;
+        }
+        }
+    }
+
+    void Encoder::put_cells(const std::vector<Cell>& cells)
+    {
+        put<uint32_t>(cells.size());
+        for (auto& cell : cells)
+            put_cell(cell);
+    }
+
+    void Encoder::put_columns(const std::vector<Column>& columns)
+    {
+        put<uint32_t>(columns.size());
+        for (auto& column : columns) {
+            put<uint8_t>(column.type_);
+            put<uint8_t>(column.attributes_);
+            put_string(column.name_);
+        }
+    }
+
+    Cell Decoder::get_cell()
+    {
+        switch (get<uint8_t>())
+        {
+        case CellType::INT32:   return Cell(Int32(get<int32_t>()));
+        case CellType::BOOL:    return Cell(Bool(get<uint8_t>() != 0));
+        case CellType::STRING:  return Cell(get_string());
+        case CellType::BYTES:
+        {
+            uint32_t size = get<uint32_t>();
+            const std::byte* data = reinterpret_cast<const std::byte*>(get_data(size));
+            return Cell(std::vector<std::byte>(data, data + size));
+        }
+        default: throw CorruptedRecordException();
+        }
+    }
+
+    std::vector<Cell> Decoder::get_cells()
+    {
+        uint32_t count = get<uint32_t>();
+        if (count > remaining())
+            throw CorruptedRecordException();
+
+        std::vector<Cell> cells(count);
+        for (auto& cell : cells)
+            cell = get_cell();
+        return cells;
+    }
+
+    std::vector<Column> Decoder::get_columns()
+    {
+        uint32_t count = get<uint32_t>();
+        if (count > remaining())
+            throw CorruptedRecordException();
+
+        std::vector<Column> columns(count);
+        for (auto& column : columns)
+        {
+            uint8_t type = get<uint8_t>();
+            if (type > CellType::BYTES)
+                throw CorruptedRecordException();
+
+            column.type_        = static_cast<CellType>(type);
+            column.attributes_  = get<uint8_t>();
+            column.name_        = get_string();
+        }
+        return columns;
+    }
+} // namespace memdb
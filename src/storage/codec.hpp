@@ -0,0 +1,93 @@
+#ifndef HEADER_GUARD_STORAGE_CODEC_H
+#define HEADER_GUARD_STORAGE_CODEC_H
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+
+#include "cell/cell.hpp"
+#include "database/column.hpp"
+
+namespace memdb
+{
+    /*
+        Compact binary encoding of values used by log records.
+        Integers are stored in host byte order, strings are prefixed with uint32 length.
+    */
+
+    // Appends encoded values to a string
+    class Encoder
+    {
+    public:
+        Encoder(std::string& out) : out_(out) {}
+
+        template <typename T>
+        void put(T value)
+        {
+            out_.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        void put_data(const void* data, size_t size)
+        {
+            out_.append(static_cast<const char*>(data), size);
+        }
+
+        void put_string(const std::string& str)
+        {
+            put<uint32_t>(str.size());
+            put_data(str.data(), str.size());
+        }
+
+        void put_cell(const Cell& cell);
+        void put_cells(const std::vector<Cell>& cells);
+        void put_columns(const std::vector<Column>& columns);
+
+    private:
+        std::string& out_;
+    };
+
+    // Reads encoded values from a buffer, throws CorruptedRecordException on overrun
+    class Decoder
+    {
+    public:
+        Decoder(const char* data, size_t size) : pos_(data), end_(data + size) {}
+        Decoder(const std::string& data) : Decoder(data.data(), data.size()) {}
+
+        template <typename T>
+        T get()
+        {
+            T value;
+            std::memcpy(&value, get_data(sizeof(T)), sizeof(T));
+            return value;
+        }
+
+        const char* get_data(size_t size)
+        {
+            if (size > (size_t)(end_ - pos_))
+                throw CorruptedRecordException();
+            const char* data = pos_;
+            pos_ += size;
+            return data;
+        }
+
+        std::string get_string()
+        {
+            uint32_t size = get<uint32_t>();
+            return std::string(get_data(size), size);
+        }
+
+        Cell get_cell();
+        std::vector<Cell> get_cells();
+        std::vector<Column> get_columns();
+
+        size_t remaining() const { return end_ - pos_; }
+        bool empty() const { return pos_ == end_; }
+
+    private:
+        const char* pos_;
+        const char* end_;
+    };
+} // namespace memdb
+
+#endif // HEADER_GUARD_STORAGE_CODEC_H
@@ -0,0 +1,699 @@
+#include "storage/snapshot.hpp"
+
+#include <cstring>
+#include <cerrno>
+#include <unordered_map>
+#include <unordered_set>
+#include <string_view>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace memdb
+{
+    static const char       snapshot_magic[8]   = {'M', 'E', 'M', 'D', 'B', 'S', 'N', 'P'};
+    static const uint32_t   snapshot_version    = 4;
+    static const uint32_t   byte_order_mark     = 0x01020304;
+
+    struct SnapshotHeader
+    {
+        char        magic[8];
+        uint32_t    version;
+        uint32_t    byte_order;
+        uint32_t    page_size;
+        uint32_t    reserved;
+        uint64_t    table_count;
+        uint64_t    catalog_offset;
+        uint64_t    catalog_size;
+        uint64_t    wal_lsn;
+    };
+
+    static uint64_t align_to_page(uint64_t offset)
+    {
+        return (offset + SNAPSHOT_PAGE_SIZE - 1) / SNAPSHOT_PAGE_SIZE * SNAPSHOT_PAGE_SIZE;
+    }
+
+    static std::string errno_string()
+    {
+        return std::string(strerror(errno));
+    }
+
+    //
+    // Writing
+    //
+
+    // Buffered writer to a file descriptor, keeps track of the file offset
+    class SnapshotWriter
+    {
+    public:
+        SnapshotWriter(int fd, const std::string& path)
+        : fd_(fd), path_(path), offset_(0)
+        {
+            buffer_.reserve(buffer_capacity);
+        }
+
+        uint64_t offset() const { return offset_; }
+
+        void write(const void* data, size_t size)
+        {
+            const char* bytes = static_cast<const char*>(data);
+            offset_ += size;
+
+            if (buffer_.size() + size > buffer_capacity)
+                flush();
+
+            // large chunks bypass the buffer
+            if (size >= buffer_capacity)
+                write_fd(bytes, size);
+            else
+                buffer_.insert(buffer_.end(), bytes, bytes + size);
+        }
+
+        template <typename T>
+        void write_value(T value)
+        {
+            write(&value, sizeof(T));
+        }
+
+        void write_string(const std::string& str)
+        {
+            write_value<uint32_t>(str.size());
+            write(str.data(), str.size());
+        }
+
+        // End offset of a value in a STRING or BYTES section, the format
+        // keeps them in 32 bits
+        void write_offset(uint64_t offset)
+        {
+            if (offset > UINT32_MAX)
+                throw SnapshotException(path_, "column holds more than 4 GiB of data");
+            write_value<uint32_t>(offset);
+        }
+
+        void pad_to_page()
+        {
+            static const char zeros[SNAPSHOT_PAGE_SIZE] = {0};
+            write(zeros, align_to_page(offset_) - offset_);
+        }
+
+        void flush()
+        {
+            write_fd(buffer_.data(), buffer_.size());
+            buffer_.clear();
+        }
+
+    private:
+        static const size_t buffer_capacity = 1U << 20;
+
+        void write_fd(const char* data, size_t size)
+        {
+            while (size > 0) {
+                ssize_t written = ::write(fd_, data, size);
+                if (written < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    throw SnapshotException(path_, "write failed: " + errno_string());
+                }
+                data += written;
+                size -= written;
+            }
+        }
+
+        int fd_;
+        const std::string& path_;
+        uint64_t offset_;
+        std::vector<char> buffer_;
+    };
+
+    // Layout of a column data section
+    enum ColumnEncoding : uint8_t
+    {
+        PlainColumn,
+        DictionaryColumn
+    };
+
+    struct ColumnSection
+    {
+        uint64_t        offset;
+        uint64_t        size;
+        ColumnEncoding  encoding = PlainColumn;
+    };
+
+    // Bytes taken by a dictionary code of a column with count distinct values
+    static uint32_t code_width(uint64_t count)
+    {
+        return count <= (1U << 8) ? 1 : count <= (1U << 16) ? 2 : 4;
+    }
+
+    template <typename T>
+    static void write_codes(SnapshotWriter& out, const std::vector<uint32_t>& codes)
+    {
+        for (uint32_t code : codes)
+            out.write_value<T>(code);
+    }
+
+    // Write strings as a dictionary if that is smaller than the plain layout
+    static ColumnEncoding write_strings(SnapshotWriter& out, const std::vector<std::string>& data)
+    {
+        std::unordered_map<std::string_view, uint32_t> codes;
+        std::vector<std::string_view> values;
+        std::vector<uint32_t> row_codes;
+        uint64_t plain_size = (data.size() + 1) * sizeof(uint32_t);
+        uint64_t values_size = 0;
+
+        row_codes.reserve(data.size());
+        for (auto& str : data) {
+            plain_size += str.size();
+            auto [it, inserted] = codes.emplace(str, values.size());
+            if (inserted) {
+                values.push_back(str);
+                values_size += str.size();
+            }
+            row_codes.push_back(it->second);
+        }
+
+        uint64_t padding = (4 - values_size % 4) % 4;
+        uint64_t dictionary_size = (values.size() + 2) * sizeof(uint32_t) + values_size + padding
+            + data.size() * code_width(values.size());
+
+        if (dictionary_size < plain_size)
+        {
+            out.write_value<uint32_t>(values.size());
+
+            uint64_t data_offset = 0;
+            out.write_offset(data_offset);
+            for (auto& str : values) {
+                data_offset += str.size();
+                out.write_offset(data_offset);
+            }
+            for (auto& str : values)
+                out.write(str.data(), str.size());
+            static const char zeros[4] = {0};
+            out.write(zeros, padding);
+
+            switch (code_width(values.size()))
+            {
+            case 1:     write_codes<uint8_t>(out, row_codes); break;
+            case 2:     write_codes<uint16_t>(out, row_codes); break;
+            default:    write_codes<uint32_t>(out, row_codes); break;
+            }
+            return DictionaryColumn;
+        }
+
+        uint64_t data_offset = 0;
+        out.write_offset(data_offset);
+        for (auto& str : data) {
+            data_offset += str.size();
+            out.write_offset(data_offset);
+        }
+        for (auto& str : data)
+            out.write(str.data(), str.size());
+        return PlainColumn;
+    }
+
+    static ColumnEncoding write_column(SnapshotWriter& out,
+        const std::vector<const Row*>& rows, size_t position, CellType type)
+    {
+        switch (type)
+        {
+        case CellType::INT32:
+            for (const Row* row : rows)
+                out.write_value<int32_t>((*row)[position].get_int());
+            return PlainColumn;
+
+        case CellType::BOOL:
+            for (const Row* row : rows)
+                out.write_value<uint8_t>((*row)[position].get_bool());
+            return PlainColumn;
+
+        case CellType::STRING:
+        {
+            std::vector<std::string> data;
+            data.reserve(rows.size());
+            for (const Row* row : rows)
+                data.push_back((*row)[position].get_string());
+
+            return write_strings(out, data);
+        }
+
+        default:
+        {
+            std::vector<std::vector<std::byte>> data;
+            data.reserve(rows.size());
+            for (const Row* row : rows)
+                data.push_back((*row)[position].get_bytes());
+
+            uint64_t data_offset = 0;
+            out.write_offset(data_offset);
+            for (auto& bytes : data) {
+                data_offset += bytes.size();
+                out.write_offset(data_offset);
+            }
+            for (auto& bytes : data)
+                out.write(bytes.data(), bytes.size());
+            return PlainColumn;
+        }
+        }
+    }
+
+    void Snapshot::save(const std::string& path, const std::vector<Table*>& tables,
+        uint64_t wal_lsn, SnapshotProgress* progress)
+    {
+        if (progress) {
+            uint64_t cells = 0;
+            for (Table* table : tables)
+                cells += table->size() * table->columns_.size();
+            progress->cells_total_ = cells;
+            progress->cells_written_ = 0;
+        }
+
+        std::string tmp_path = path + ".tmp";
+
+        int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+            throw SnapshotException(path, "cannot open for writing: " + errno_string());
+
+        try
+        {
+            SnapshotWriter out(fd, path);
+
+            // header page is written last, when the catalog position is known
+            static const char header_page[SNAPSHOT_PAGE_SIZE] = {0};
+            out.write(header_page, sizeof(header_page));
+            std::vector<std::vector<ColumnSection>> sections(tables.size());
+            std::vector<ColumnSection> id_sections(tables.size());
+            std::vector<uint64_t> row_counts(tables.size());
+
+            for (auto t = 0LU; t < tables.size(); ++t)
+            {
+                Table* table = tables[t];
+
+                // writers are locked out, live versions are exactly the current rows
+                std::vector<const Row*> rows;
+                for (RowVersion* version : table->live_versions())
+                    rows.push_back(&*version->row_);
+                row_counts[t] = rows.size();
+
+                out.pad_to_page();
+                id_sections[t].offset = out.offset();
+                for (const Row* row : rows)
+                    out.write_value<uint64_t>(row->id());
+                id_sections[t].size = out.offset() - id_sections[t].offset;
+
+                for (auto c = 0LU; c < table->columns_.size(); ++c)
+                {
+                    out.pad_to_page();
+                    uint64_t begin = out.offset();
+                    ColumnEncoding encoding = write_column(out, rows, c, table->columns_[c].type_);
+                    sections[t].push_back({begin, out.offset() - begin, encoding});
+
+                    if (progress)
+                        progress->cells_written_ += rows.size();
+                }
+            }
+
+            // catalog
+            out.pad_to_page();
+            uint64_t catalog_offset = out.offset();
+
+            for (auto t = 0LU; t < tables.size(); ++t)
+            {
+                Table* table = tables[t];
+
+                out.write_string(table->name_);
+                out.write_value<uint32_t>(table->columns_.size());
+                for (auto& column : table->columns_) {
+                    out.write_value<uint8_t>(column.type_);
+                    out.write_value<uint8_t>(column.attributes_);
+                    out.write_string(column.name_);
+                }
+
+                out.write_value<uint64_t>(row_counts[t]);
+                out.write_value<uint64_t>(table->next_row_id_);
+                out.write_value<uint64_t>(id_sections[t].offset);
+                out.write_value<uint64_t>(id_sections[t].size);
+                for (auto& section : sections[t]) {
+                    out.write_value<uint64_t>(section.offset);
+                    out.write_value<uint64_t>(section.size);
+                    out.write_value<uint8_t>(section.encoding);
+                }
+            }
+
+            uint64_t catalog_size = out.offset() - catalog_offset;
+            out.flush();
+
+            SnapshotHeader header{};
+            std::memcpy(header.magic, snapshot_magic, sizeof(snapshot_magic));
+            header.version          = snapshot_version;
+            header.byte_order       = byte_order_mark;
+            header.page_size        = SNAPSHOT_PAGE_SIZE;
+            header.table_count      = tables.size();
+            header.catalog_offset   = catalog_offset;
+            header.catalog_size     = catalog_size;
+            header.wal_lsn          = wal_lsn;
+
+            if (::pwrite(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header))
+                throw SnapshotException(path, "cannot write header: " + errno_string());
+
+            if (::fsync(fd) < 0)
+                throw SnapshotException(path, "fsync failed: " + errno_string());
+        }
+        catch (...)
+        {
+            ::close(fd);
+            ::unlink(tmp_path.c_str());
+            throw;
+        }
+
+        ::close(fd);
+
+        if (::rename(tmp_path.c_str(), path.c_str()) < 0) {
+            ::unlink(tmp_path.c_str());
+            throw SnapshotException(path, "cannot replace snapshot: " + errno_string());
+        }
+    }
+
+    //
+    // Reading
+    //
+
+    // Read-only private mapping of a whole file
+    class MappedFile
+    {
+    public:
+        MappedFile(const std::string& path)
+        : path_(path), data_(nullptr), size_(0)
+        {
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                throw SnapshotException(path, "cannot open for reading: " + errno_string());
+
+            struct stat st;
+            if (::fstat(fd, &st) < 0) {
+                ::close(fd);
+                throw SnapshotException(path, "cannot stat: " + errno_string());
+            }
+
+            size_ = st.st_size;
+            if (size_ < sizeof(SnapshotHeader)) {
+                ::close(fd);
+                throw SnapshotException(path, "file is too short");
+            }
+
+            void* data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+
+            if (data == MAP_FAILED)
+                throw SnapshotException(path, "mmap failed: " + errno_string());
+
+            data_ = static_cast<const char*>(data);
+
+            // the file is read front to back
+            ::madvise(data, size_, MADV_SEQUENTIAL);
+        }
+
+        MappedFile(const MappedFile& other)             = delete;
+        MappedFile& operator= (const MappedFile& other) = delete;
+
+        ~MappedFile()
+        {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+
+        uint64_t size() const { return size_; }
+
+        // Pointer to [offset, offset + size) or exception if it is out of file bounds
+        const char* at(uint64_t offset, uint64_t size) const
+        {
+            if (offset > size_ || size > size_ - offset)
+                corrupted();
+            return data_ + offset;
+        }
+
+        [[noreturn]] void corrupted() const
+        {
+            throw SnapshotException(path_, "corrupted file");
+        }
+
+    private:
+        const std::string& path_;
+        const char* data_;
+        uint64_t    size_;
+    };
+
+    // Sequential reader of the catalog section
+    class CatalogReader
+    {
+    public:
+        CatalogReader(const MappedFile& file, uint64_t offset, uint64_t size)
+        : file_(file), pos_(offset), end_(offset + size)
+        {
+            file_.at(offset, size); // check bounds once
+        }
+
+        template <typename T>
+        T read_value()
+        {
+            T value;
+            std::memcpy(&value, read(sizeof(T)), sizeof(T));
+            return value;
+        }
+
+        std::string read_string()
+        {
+            uint32_t size = read_value<uint32_t>();
+            return std::string(read(size), size);
+        }
+
+    private:
+        const char* read(uint64_t size)
+        {
+            if (size > end_ - pos_)
+                file_.corrupted();
+            const char* data = file_.at(pos_, size);
+            pos_ += size;
+            return data;
+        }
+
+        const MappedFile& file_;
+        uint64_t pos_;
+        uint64_t end_;
+    };
+
+    // Fill column 'position' of rows with data of one column section
+    static void read_column(const MappedFile& file, std::vector<std::vector<Cell>>& rows,
+        size_t position, CellType type, ColumnSection section)
+    {
+        const char* data = file.at(section.offset, section.size);
+        uint64_t count = rows.size();
+
+        switch (type)
+        {
+        case CellType::INT32:
+        {
+            if (section.size != count * sizeof(int32_t))
+                file.corrupted();
+            // sections are page-aligned (checked with the catalog), the mapping is used as an array directly
+            const int32_t* values = reinterpret_cast<const int32_t*>(data);
+            for (auto i = 0LU; i < count; ++i)
+                rows[i][position] = Cell(Int32(values[i]));
+            return;
+        }
+
+        case CellType::BOOL:
+        {
+            if (section.size != count * sizeof(uint8_t))
+                file.corrupted();
+            const uint8_t* values = reinterpret_cast<const uint8_t*>(data);
+            for (auto i = 0LU; i < count; ++i)
+                rows[i][position] = Cell(Bool(values[i] != 0));
+            return;
+        }
+
+        default:
+        {
+            uint64_t offsets_size = (count + 1) * sizeof(uint32_t);
+            if (section.size < offsets_size)
+                file.corrupted();
+
+            const uint32_t* offsets = reinterpret_cast<const uint32_t*>(data);
+            const char* payload = data + offsets_size;
+            uint64_t payload_size = section.size - offsets_size;
+
+            for (auto i = 0LU; i < count; ++i)
+            {
+                uint32_t begin = offsets[i], end = offsets[i + 1];
+                if (begin > end || end > payload_size)
+                    file.corrupted();
+
+                if (type == CellType::STRING)
+                    rows[i][position] = Cell(std::string(payload + begin, payload + end));
+                else {
+                    const std::byte* bytes = reinterpret_cast<const std::byte*>(payload);
+                    rows[i][position] = Cell(std::vector<std::byte>(bytes + begin, bytes + end));
+                }
+            }
+            return;
+        }
+        }
+    }
+
+    template <typename T>
+    static void read_codes(const char* data, const std::vector<Cell>& values,
+        std::vector<std::vector<Cell>>& rows, size_t position, const MappedFile& file)
+    {
+        const T* codes = reinterpret_cast<const T*>(data);
+        for (auto i = 0LU; i < rows.size(); ++i) {
+            if (codes[i] >= values.size())
+                file.corrupted();
+            rows[i][position] = values[codes[i]];
+        }
+    }
+
+    // Fill string column 'position' of rows from a dictionary section
+    static void read_dictionary_column(const MappedFile& file, std::vector<std::vector<Cell>>& rows,
+        size_t position, ColumnSection section, Dictionary& dictionary)
+    {
+        const char* data = file.at(section.offset, section.size);
+        if (section.size < sizeof(uint32_t))
+            file.corrupted();
+
+        uint32_t count = *reinterpret_cast<const uint32_t*>(data);
+        uint64_t offsets_size = (uint64_t(count) + 1) * sizeof(uint32_t);
+        if (section.size - sizeof(uint32_t) < offsets_size)
+            file.corrupted();
+
+        const uint32_t* offsets = reinterpret_cast<const uint32_t*>(data + sizeof(uint32_t));
+        const char* payload = data + sizeof(uint32_t) + offsets_size;
+        uint64_t payload_size = offsets[count] + (4 - offsets[count] % 4) % 4;
+        uint64_t width = code_width(count);
+
+        if (section.size != sizeof(uint32_t) + offsets_size + payload_size + rows.size() * width)
+            file.corrupted();
+
+        // each distinct string is copied once, into the dictionary of the column
+        std::vector<Cell> values(count);
+        for (auto i = 0LU; i < count; ++i) {
+            uint32_t begin = offsets[i], end = offsets[i + 1];
+            if (begin > end || end > offsets[count])
+                file.corrupted();
+            values[i] = dictionary.encode(Cell(std::string(payload + begin, payload + end)));
+        }
+
+        const char* codes = payload + payload_size;
+        switch (width)
+        {
+        case 1:     read_codes<uint8_t>(codes, values, rows, position, file); return;
+        case 2:     read_codes<uint16_t>(codes, values, rows, position, file); return;
+        default:    read_codes<uint32_t>(codes, values, rows, position, file); return;
+        }
+    }
+
+    std::vector<std::shared_ptr<Table>> Snapshot::load(const std::string& path)
+    {
+        uint64_t wal_lsn;
+        return load(path, wal_lsn);
+    }
+
+    std::vector<std::shared_ptr<Table>> Snapshot::load(const std::string& path, uint64_t& wal_lsn)
+    {
+        MappedFile file(path);
+
+        SnapshotHeader header;
+        std::memcpy(&header, file.at(0, sizeof(header)), sizeof(header));
+
+        if (std::memcmp(header.magic, snapshot_magic, sizeof(snapshot_magic)) != 0)
+            throw SnapshotException(path, "not a memdb snapshot");
+        if (header.version != snapshot_version)
+            throw SnapshotException(path, "unsupported format version " + std::to_string(header.version));
+        if (header.byte_order != byte_order_mark)
+            throw SnapshotException(path, "snapshot was written on a machine with different byte order");
+        if (header.page_size != SNAPSHOT_PAGE_SIZE)
+            throw SnapshotException(path, "unsupported page size");
+
+        wal_lsn = header.wal_lsn;
+
+        CatalogReader catalog(file, header.catalog_offset, header.catalog_size);
+        std::vector<std::shared_ptr<Table>> tables;
+
+        std::unordered_set<std::string> names;
+        for (auto t = 0LU; t < header.table_count; ++t)
+        {
+            // the catalog of a database holds a table once
+            std::string name = catalog.read_string();
+            if (!names.insert(name).second)
+                file.corrupted();
+
+            std::vector<Column> columns(catalog.read_value<uint32_t>());
+            for (auto& column : columns)
+            {
+                uint8_t type = catalog.read_value<uint8_t>();
+                if (type > CellType::BYTES)
+                    file.corrupted();
+
+                column.type_        = static_cast<CellType>(type);
+                column.attributes_  = catalog.read_value<uint8_t>();
+                column.name_        = catalog.read_string();
+            }
+
+            uint64_t row_count = catalog.read_value<uint64_t>();
+            RowId next_row_id = catalog.read_value<uint64_t>();
+
+            ColumnSection id_section;
+            id_section.offset   = catalog.read_value<uint64_t>();
+            id_section.size     = catalog.read_value<uint64_t>();
+
+            std::vector<ColumnSection> sections(columns.size());
+            for (auto& section : sections) {
+                section.offset  = catalog.read_value<uint64_t>();
+                section.size    = catalog.read_value<uint64_t>();
+                uint8_t encoding = catalog.read_value<uint8_t>();
+                if (encoding > DictionaryColumn)
+                    file.corrupted();
+                section.encoding = static_cast<ColumnEncoding>(encoding);
+            }
+
+            // every row takes at least one byte in every column section
+            if (columns.empty() || row_count > file.size())
+                file.corrupted();
+
+            // sections are read in place as arrays of their values
+            if (id_section.offset % SNAPSHOT_PAGE_SIZE != 0)
+                file.corrupted();
+            for (auto& section : sections)
+                if (section.offset % SNAPSHOT_PAGE_SIZE != 0)
+                    file.corrupted();
+
+            auto table = std::make_shared<Table>(name, columns);
+
+            std::vector<std::vector<Cell>> rows(row_count, std::vector<Cell>(columns.size()));
+            for (auto c = 0LU; c < columns.size(); ++c) {
+                if (sections[c].encoding == DictionaryColumn && columns[c].type_ != CellType::STRING)
+                    file.corrupted();
+                if (sections[c].encoding == DictionaryColumn)
+                    read_dictionary_column(file, rows, c, sections[c], *table->columns_[c].dictionary_);
+                else
+                    read_column(file, rows, c, columns[c].type_, sections[c]);
+            }
+
+            if (id_section.size != row_count * sizeof(RowId))
+                file.corrupted();
+            const RowId* ids = reinterpret_cast<const RowId*>(file.at(id_section.offset, id_section.size));
+
+            for (auto i = 0LU; i < row_count; ++i)
+            {
+                table->check_row(rows[i]);
+                Row row(table.get(), std::move(rows[i]));
+                row.set_id(ids[i]);
+                table->insert_row(std::move(row));
+            }
+            table->next_row_id_ = std::max(table->next_row_id_, next_row_id);
+
+            tables.push_back(table);
+        }
+
+        return tables;
+    }
+} // namespace memdb
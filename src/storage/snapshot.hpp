@@ -0,0 +1,63 @@
+#ifndef HEADER_GUARD_STORAGE_SNAPSHOT_H
+#define HEADER_GUARD_STORAGE_SNAPSHOT_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+
+#include "database/table.hpp"
+
+#define SNAPSHOT_PAGE_SIZE 4096U
+
+namespace memdb
+{
+    /*
+        Binary snapshot of a database catalog.
+
+        The file is column-oriented and every section starts on a page boundary:
+
+            page 0          header: magic, format version, page size,
+                            number of tables, offset and size of the catalog,
+                            lsn of the last log record included
+            data sections   for every table a section of row ids, uint64_t[rows],
+                            then one per column:
+                                INT32           int32_t[rows]
+                                BOOL            uint8_t[rows]
+                                STRING, BYTES   uint32_t offsets[rows + 1], then raw data
+                            or, for STRING when it is smaller, a dictionary:
+                                                uint32_t count, uint32_t offsets[count + 1],
+                                                raw data padded to 4 bytes, then a code
+                                                per row, uint8_t, uint16_t or uint32_t
+                                                as few as count needs
+            catalog         for every table: name, column descriptions, number of rows,
+                            next row id and (offset, size) of the row id section
+                            and (offset, size, encoding) of each column data section
+
+        All integers are stored in host byte order, the header records it.
+        Snapshot is loaded through mmap: fixed-width columns are read straight
+        from the mapping and strings are only copied into the cells they end up in.
+    */
+    // Counters a running save updates, may live in memory shared with another process
+    struct SnapshotProgress
+    {
+        std::atomic<uint64_t> cells_total_{0};
+        std::atomic<uint64_t> cells_written_{0};
+    };
+
+    class Snapshot
+    {
+    public:
+        // Write tables to path. The file is written next to path and renamed over it,
+        // so a crash never leaves a truncated snapshot behind
+        static void save(const std::string& path, const std::vector<Table*>& tables,
+            uint64_t wal_lsn = 0, SnapshotProgress* progress = nullptr);
+
+        // Map snapshot into memory and construct tables stored in it
+        static std::vector<std::shared_ptr<Table>> load(const std::string& path);
+        static std::vector<std::shared_ptr<Table>> load(const std::string& path, uint64_t& wal_lsn);
+    };
+} // namespace memdb
+
+#endif // HEADER_GUARD_STORAGE_SNAPSHOT_H
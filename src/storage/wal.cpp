@@ -0,0 +1,433 @@
+#include "storage/wal.hpp"
+#include "storage/codec.hpp"
+#include "expression/expression.hpp"
+
+#include <array>
+#include <cstring>
+#include <cerrno>
+#include <chrono>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+namespace memdb
+{
+    static const char       wal_magic[8]    = {'M', 'E', 'M', 'D', 'B', 'W', 'A', 'L'};
+    static const uint32_t   wal_version     = 2;
+
+    // size, checksum, lsn, type
+    static const size_t     record_header_size = 4 + 4 + 8 + 1;
+
+    static std::string errno_string()
+    {
+        return std::string(strerror(errno));
+    }
+
+    // CRC-32 (IEEE 802.3), crc is the checksum of preceding data or 0
+    static uint32_t crc32(uint32_t crc, const char* data, size_t size)
+    {
+        static const auto table = [] {
+            std::array<uint32_t, 256> table{};
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; ++k)
+                    c = (c & 1) ? 0xEDB88320U ^ (c >> 1) : c >> 1;
+                table[i] = c;
+            }
+            return table;
+        }();
+
+        crc ^= 0xFFFFFFFFU;
+        for (size_t i = 0; i < size; ++i)
+            crc = table[(crc ^ (unsigned char)data[i]) & 0xFF] ^ (crc >> 8);
+        return crc ^ 0xFFFFFFFFU;
+    }
+
+    //
+    // Records
+    //
+
+    WalRecord WalRecord::create_table(const std::string& name, const std::vector<Column>& columns)
+    {
+        WalRecord record{WalCreateTable, {}};
+        Encoder out(record.payload_);
+        out.put_string(name);
+        out.put_columns(columns);
+        return record;
+    }
+
+    WalRecord WalRecord::drop_table(const std::string& name)
+    {
+        WalRecord record{WalDropTable, {}};
+        Encoder out(record.payload_);
+        out.put_string(name);
+        return record;
+    }
+
+    WalRecord WalRecord::insert(const std::string& name, const std::vector<Cell>& data)
+    {
+        WalRecord record{WalInsert, {}};
+        Encoder out(record.payload_);
+        out.put_string(name);
+        out.put_cells(data);
+        return record;
+    }
+
+    WalRecord WalRecord::insert(const std::string& name, const std::unordered_map<std::string, Cell>& data)
+    {
+        WalRecord record{WalInsertNamed, {}};
+        Encoder out(record.payload_);
+        out.put_string(name);
+        out.put<uint32_t>(data.size());
+        for (auto &[column, cell] : data) {
+            out.put_string(column);
+            out.put_cell(cell);
+        }
+        return record;
+    }
+
+    WalRecord WalRecord::update(const std::string& name,
+        const std::unordered_map<std::string, Expression>& set, const Expression& where)
+    {
+        WalRecord record{WalUpdate, {}};
+        Encoder out(record.payload_);
+        out.put_string(name);
+        out.put<uint32_t>(set.size());
+        for (auto &[column, expression] : set) {
+            out.put_string(column);
+            expression.encode(out);
+        }
+        where.encode(out);
+        return record;
+    }
+
+    WalRecord WalRecord::remove(const std::string& name, const Expression& where)
+    {
+        WalRecord record{WalDelete, {}};
+        Encoder out(record.payload_);
+        out.put_string(name);
+        where.encode(out);
+        return record;
+    }
+
+    WalRecord WalRecord::transaction(const std::vector<WalTableChanges>& changes)
+    {
+        WalRecord record{WalTransaction, {}};
+        Encoder out(record.payload_);
+        out.put<uint32_t>(changes.size());
+        for (auto& table : changes) {
+            out.put_string(table.name_);
+            out.put<uint32_t>(table.removed_.size());
+            for (RowId id : table.removed_)
+                out.put<uint64_t>(id);
+            out.put<uint32_t>(table.inserted_.size());
+            for (const Row* row : table.inserted_) {
+                out.put<uint64_t>(row->id());
+                out.put_cells(row->cells());
+            }
+        }
+        return record;
+    }
+
+    //
+    // Log
+    //
+
+    WriteAheadLog::WriteAheadLog(const std::string& path, SyncPolicy policy, unsigned sync_interval_ms)
+    : path_(path), policy_(policy), sync_interval_ms_(sync_interval_ms), fd_(-1),
+      flushing_(false), batches_(0), appended_lsn_(0), written_lsn_(0), synced_lsn_(0), file_size_(0),
+      stop_(false)
+    { }
+
+    WriteAheadLog::~WriteAheadLog()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        stop_cv_.notify_all();
+        if (syncer_.joinable())
+            syncer_.join();
+
+        if (fd_ < 0)
+            return;
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (flushing_)
+            wait_batch(lock);
+        try {
+            if (failure_.empty() && (!buffer_.empty() || synced_lsn_ < written_lsn_))
+                write_batch(lock, policy_ != SyncNever);
+        }
+        catch (WalException&) { } // nothing to report to at this point
+
+        ::close(fd_);
+    }
+
+    void WriteAheadLog::recover(uint64_t after_lsn, const std::function<void(const WalRecord&)>& apply)
+    {
+        std::string data;
+
+        int fd = ::open(path_.c_str(), O_RDONLY);
+        if (fd >= 0)
+        {
+            char chunk[1 << 16];
+            ssize_t size;
+            while ((size = ::read(fd, chunk, sizeof(chunk))) != 0) {
+                if (size < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    ::close(fd);
+                    throw WalException(path_, "read failed: " + errno_string());
+                }
+                data.append(chunk, size);
+            }
+            ::close(fd);
+        }
+        else if (errno != ENOENT)
+            throw WalException(path_, "cannot open for reading: " + errno_string());
+
+        uint64_t last_lsn = after_lsn;
+        size_t valid_size = 0;
+
+        bool has_header = data.size() >= sizeof(wal_magic) + sizeof(uint32_t);
+        if (has_header && std::memcmp(data.data(), wal_magic, sizeof(wal_magic)) != 0)
+            throw WalException(path_, "not a memdb log");
+
+        if (has_header)
+        {
+            Decoder header(data.data() + sizeof(wal_magic), sizeof(uint32_t));
+            if (header.get<uint32_t>() != wal_version)
+                throw WalException(path_, "unsupported format version");
+
+            size_t pos = sizeof(wal_magic) + sizeof(uint32_t);
+            valid_size = pos;
+
+            // read records until the end or the first torn one
+            while (data.size() - pos >= record_header_size)
+            {
+                Decoder in(data.data() + pos, record_header_size);
+                uint32_t size       = in.get<uint32_t>();
+                uint32_t checksum   = in.get<uint32_t>();
+
+                if (size > data.size() - pos - record_header_size)
+                    break;
+
+                const char* body = data.data() + pos + 8;
+                if (crc32(0, body, 8 + 1 + size) != checksum)
+                    break;
+
+                uint64_t lsn = in.get<uint64_t>();
+                WalRecord record{static_cast<WalRecordType>(in.get<uint8_t>()),
+                    std::string(data.data() + pos + record_header_size, size)};
+
+                if (lsn > after_lsn)
+                    apply(record);
+
+                last_lsn = std::max(last_lsn, lsn);
+                pos += record_header_size + size;
+                valid_size = pos;
+            }
+        }
+
+        appended_lsn_ = written_lsn_ = synced_lsn_ = last_lsn;
+
+        if (!has_header) {
+            // missing log, or it was torn while being created
+            reset();
+        }
+        else {
+            if (valid_size < data.size() && ::truncate(path_.c_str(), valid_size) < 0)
+                throw WalException(path_, "cannot cut off torn tail: " + errno_string());
+            open_for_append();
+        }
+
+        if (policy_ == SyncInterval)
+            syncer_ = std::thread(&WriteAheadLog::sync_loop, this);
+    }
+
+    uint64_t WriteAheadLog::append(const WalRecord& record)
+    {
+        std::string header;
+        Encoder out(header);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        check_failed();
+        uint64_t lsn = ++appended_lsn_;
+
+        out.put<uint32_t>(record.payload_.size());
+        out.put<uint32_t>(0); // checksum placeholder
+        out.put<uint64_t>(lsn);
+        out.put<uint8_t>(record.type_);
+
+        uint32_t checksum = crc32(0, header.data() + 8, header.size() - 8);
+        checksum = crc32(checksum, record.payload_.data(), record.payload_.size());
+        std::memcpy(&header[4], &checksum, sizeof(checksum));
+
+        buffer_ += header;
+        buffer_ += record.payload_;
+        return lsn;
+    }
+
+    void WriteAheadLog::commit(uint64_t lsn)
+    {
+        bool sync = policy_ == SyncEveryCommit;
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        while ((sync ? synced_lsn_ : written_lsn_) < lsn)
+        {
+            check_failed();
+            if (flushing_)
+                wait_batch(lock);
+            else
+                write_batch(lock, sync); // become the leader
+        }
+    }
+
+    uint64_t WriteAheadLog::last_lsn()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return appended_lsn_;
+    }
+
+    void WriteAheadLog::reset()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (flushing_)
+            wait_batch(lock);
+
+        // records still in the buffer are covered by the snapshot
+        buffer_.clear();
+
+        std::string tmp_path = path_ + ".tmp";
+        int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+            throw WalException(path_, "cannot create: " + errno_string());
+
+        std::string header(wal_magic, sizeof(wal_magic));
+        Encoder(header).put<uint32_t>(wal_version);
+
+        bool ok = ::write(fd, header.data(), header.size()) == (ssize_t)header.size()
+            && ::fsync(fd) == 0;
+        ::close(fd);
+
+        if (!ok || ::rename(tmp_path.c_str(), path_.c_str()) < 0) {
+            ::unlink(tmp_path.c_str());
+            throw WalException(path_, "cannot create: " + errno_string());
+        }
+
+        if (fd_ >= 0)
+            ::close(fd_);
+        open_for_append();
+
+        // a failed batch is covered by the snapshot as well
+        failure_.clear();
+        written_lsn_ = synced_lsn_ = appended_lsn_;
+        batches_++;
+        batches_.notify_all();
+    }
+
+    void WriteAheadLog::write_batch(std::unique_lock<std::mutex>& lock, bool sync)
+    {
+        flushing_ = true;
+
+        std::string batch;
+        batch.swap(buffer_);
+        uint64_t batch_lsn = appended_lsn_;
+
+        lock.unlock();
+        try
+        {
+            write_fd(batch);
+            if (sync && ::fdatasync(fd_) < 0)
+                throw WalException(path_, "fdatasync failed: " + errno_string());
+        }
+        catch (WalException& ex)
+        {
+            std::string reason = ex.what();
+            if (!reason.empty() && reason.back() == '\n')
+                reason.pop_back();
+
+            // a torn batch would hide the batches after it from recovery
+            if (::ftruncate(fd_, file_size_) < 0)
+                reason += ", the torn batch is left in the file: " + errno_string();
+
+            lock.lock();
+            failure_ = reason;
+            flushing_ = false;
+            batches_++;
+            batches_.notify_all();
+            throw;
+        }
+        lock.lock();
+
+        file_size_ += batch.size();
+        written_lsn_ = batch_lsn;
+        if (sync)
+            synced_lsn_ = batch_lsn;
+
+        flushing_ = false;
+        batches_++;
+        batches_.notify_all();
+    }
+
+    void WriteAheadLog::check_failed() const
+    {
+        if (!failure_.empty())
+            throw WalException(path_, "nothing is logged until a checkpoint after an earlier failure. " + failure_);
+    }
+
+    void WriteAheadLog::wait_batch(std::unique_lock<std::mutex>& lock)
+    {
+        uint64_t batch = batches_;
+        lock.unlock();
+        batches_.wait(batch);
+        lock.lock();
+    }
+
+    void WriteAheadLog::write_fd(const std::string& data)
+    {
+        const char* pos = data.data();
+        size_t size = data.size();
+
+        while (size > 0) {
+            ssize_t written = ::write(fd_, pos, size);
+            if (written < 0) {
+                if (errno == EINTR)
+                    continue;
+                throw WalException(path_, "write failed: " + errno_string());
+            }
+            pos += written;
+            size -= written;
+        }
+    }
+
+    void WriteAheadLog::open_for_append()
+    {
+        fd_ = ::open(path_.c_str(), O_WRONLY | O_APPEND);
+        if (fd_ < 0)
+            throw WalException(path_, "cannot open for writing: " + errno_string());
+
+        struct stat st;
+        if (::fstat(fd_, &st) < 0)
+            throw WalException(path_, "cannot stat: " + errno_string());
+        file_size_ = st.st_size;
+    }
+
+    void WriteAheadLog::sync_loop()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stop_)
+        {
+            stop_cv_.wait_for(lock, std::chrono::milliseconds(sync_interval_ms_));
+            if (stop_ || flushing_ || !failure_.empty() || synced_lsn_ == appended_lsn_)
+                continue;
+
+            try {
+                write_batch(lock, true);
+            }
+            catch (WalException&) { } // committers see the error on their next write
+        }
+    }
+} // namespace memdb
@@ -0,0 +1,147 @@
+#ifndef HEADER_GUARD_STORAGE_WAL_H
+#define HEADER_GUARD_STORAGE_WAL_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+#include "cell/cell.hpp"
+#include "database/column.hpp"
+#include "database/row.hpp"
+
+namespace memdb
+{
+    class Expression;
+
+    // When committed records are forced to disk
+    enum SyncPolicy
+    {
+        SyncEveryCommit,    // commit returns after fdatasync, concurrent commits share one
+        SyncInterval,       // commit returns after write, background thread syncs every N ms
+        SyncNever           // commit returns after write, syncing is left to the OS
+    };
+
+    enum WalRecordType
+    {
+        WalCreateTable = 1,
+        WalDropTable,
+        WalInsert,          // row as ordered list of cells
+        WalInsertNamed,     // row as column name to cell map
+        WalUpdate,
+        WalDelete,
+        WalTransaction      // rows removed and inserted by a committed transaction
+    };
+
+    // Effect of a transaction on one table: ids of the rows it removed or
+    // replaced and new versions with their ids
+    struct WalTableChanges
+    {
+        std::string             name_;
+        std::vector<RowId>      removed_;
+        std::vector<const Row*> inserted_;
+    };
+
+    // Logical description of one mutating command
+    struct WalRecord
+    {
+        WalRecordType   type_;
+        std::string     payload_;   // encoded with Encoder
+
+        static WalRecord create_table(const std::string& name, const std::vector<Column>& columns);
+        static WalRecord drop_table(const std::string& name);
+        static WalRecord insert(const std::string& name, const std::vector<Cell>& data);
+        static WalRecord insert(const std::string& name, const std::unordered_map<std::string, Cell>& data);
+        static WalRecord update(const std::string& name,
+            const std::unordered_map<std::string, Expression>& set, const Expression& where);
+        static WalRecord remove(const std::string& name, const Expression& where);
+        static WalRecord transaction(const std::vector<WalTableChanges>& changes);
+    };
+
+    /*
+        Append-only log of WalRecords.
+
+        File starts with a short header followed by records:
+            uint32 payload size | uint32 crc32 | uint64 lsn | uint8 type | payload
+        Checksum covers lsn, type and payload, so a torn tail is detected on recovery.
+
+        Group commit: appending only copies the record into an in-memory buffer.
+        The first committer that finds its record not yet on disk becomes the leader,
+        writes the whole buffer and syncs it once; committers arriving meanwhile wait
+        and are covered by the next batch.
+
+        A batch that fails to write or sync fails the log: the file is cut
+        back to the last whole batch, and every commit waiting for the batch
+        and every later append or commit throws WalException until reset()
+        starts a new log.
+    */
+    class WriteAheadLog
+    {
+    public:
+        WriteAheadLog(const std::string& path, SyncPolicy policy, unsigned sync_interval_ms);
+        ~WriteAheadLog();
+
+        WriteAheadLog(const WriteAheadLog& other)               = delete;
+        WriteAheadLog& operator= (const WriteAheadLog& other)   = delete;
+
+        // Pass every record with lsn greater than after_lsn to apply,
+        // cut off a torn tail and prepare the log for appending.
+        // Must be called once before the first append
+        void recover(uint64_t after_lsn, const std::function<void(const WalRecord&)>& apply);
+
+        // Copy record to the log buffer, return its lsn. Throws WalException
+        // once the log failed
+        uint64_t append(const WalRecord& record);
+
+        // Wait until record with lsn is written (and synced, depending on the
+        // policy). Throws WalException if the log failed before that
+        void commit(uint64_t lsn);
+
+        // Lsn of the last appended record
+        uint64_t last_lsn();
+
+        // Start an empty log, all records up to last_lsn() must be in a snapshot by now
+        void reset();
+
+    private:
+        // Write the buffer out. Called and returns with lock held
+        void write_batch(std::unique_lock<std::mutex>& lock, bool sync);
+
+        // Release lock until the batch in flight is finished
+        void wait_batch(std::unique_lock<std::mutex>& lock);
+
+        // Throw if a batch failed. Called with lock held
+        void check_failed() const;
+
+        void write_fd(const std::string& data);
+        void open_for_append();
+        void sync_loop();
+
+        const std::string   path_;
+        const SyncPolicy    policy_;
+        const unsigned      sync_interval_ms_;
+        int                 fd_;
+
+        std::mutex              mutex_;
+        std::string             buffer_;    // appended records not written yet
+        bool                    flushing_;  // some thread is writing a batch
+        std::atomic<uint64_t>   batches_;   // number of finished batches, notified on change
+
+        uint64_t appended_lsn_;
+        uint64_t written_lsn_;
+        uint64_t synced_lsn_;
+        uint64_t file_size_;    // bytes of the file up to the last whole batch
+        std::string failure_;   // why a batch failed, empty while the log works
+
+        bool                    stop_;
+        std::condition_variable stop_cv_;
+        std::thread             syncer_;    // only with SyncInterval
+    };
+} // namespace memdb
+
+#endif // HEADER_GUARD_STORAGE_WAL_H
@@ -0,0 +1,306 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <set>
+
+#include "database/database.hpp"
+
+using namespace memdb;
+
+TEST(ConcurrencyTest, ReadersAndWriters)
+{
+    Database db;
+    const int writers = 4, inserts = 200, readers = 4;
+
+    for (int t = 0; t < writers; ++t)
+        db.execute("create table tab" + std::to_string(t) + " (value : int32)");
+
+    std::atomic<bool> failed = false;
+    std::vector<std::thread> threads;
+
+    // every writer has its own table, readers scan all of them meanwhile
+    for (int t = 0; t < writers; ++t)
+        threads.emplace_back([&db, &failed, t] {
+            for (int i = 0; i < inserts; ++i)
+                if (!db.execute("insert (" + std::to_string(i) + ") to tab" + std::to_string(t)).ok())
+                    failed = true;
+        });
+
+    for (int t = 0; t < readers; ++t)
+        threads.emplace_back([&db, &failed] {
+            for (int i = 0; i < inserts; ++i) {
+                Result res = db.execute("select value from tab" + std::to_string(i % writers) + " where value >= 0");
+                if (!res.ok())
+                    failed = true;
+            }
+        });
+
+    for (auto& thread : threads)
+        thread.join();
+
+    ASSERT_FALSE(failed);
+    for (int t = 0; t < writers; ++t)
+        ASSERT_EQ(db.get_table("tab" + std::to_string(t))->size(), inserts);
+}
+
+TEST(ConcurrencyTest, ResultOutlivesDroppedTable)
+{
+    Database db;
+    db.execute("create table tab1 (value : int32)");
+    Result res = db.execute("insert (1) to tab1");
+    ASSERT_TRUE(res.ok());
+
+    ASSERT_TRUE(db.execute("drop table tab1").ok());
+    ASSERT_THROW(db.get_table("tab1"), TableDoNotExistException);
+
+    // the result still refers to the dropped table
+    ASSERT_EQ(res.get_table()->size(), 1);
+    ASSERT_EQ(res.get_table()->name(), "tab1");
+}
+
+static size_t count_visible(Table* table, uint64_t snapshot_ts)
+{
+    return table->select({"value"}, Expression(), snapshot_ts)->size();
+}
+
+TEST(ConcurrencyTest, SnapshotIsolation)
+{
+    Database db;
+    db.execute("create table tab1 (value : int32)");
+    db.execute("insert (1) to tab1");
+    db.execute("insert (2) to tab1");
+
+    auto table = db.get_table("tab1");
+    {
+        // writers are not blocked by the open snapshot and it does not see them
+        TransactionManager::ReadView view(*db.transactions());
+
+        ASSERT_TRUE(db.execute("insert (3) to tab1").ok());
+        ASSERT_TRUE(db.execute("update tab1 set value = value + 10 where value == 1").ok());
+        ASSERT_TRUE(db.execute("delete tab1 where value == 2").ok());
+
+        ASSERT_EQ(count_visible(table.get(), view.ts()), 2);
+
+        Result res = db.execute("select value from tab1 where value == 1 || value == 2");
+        ASSERT_EQ(res.get_table()->size(), 0);
+
+        // versions the snapshot sees survive collection
+        auto lock = table->write_lock();
+        table->collect_garbage();
+        ASSERT_EQ(table->versions(), 4);
+    }
+
+    ASSERT_EQ(table->size(), 2);
+
+    auto lock = table->write_lock();
+    table->collect_garbage();
+    ASSERT_EQ(table->versions(), 2);
+}
+
+TEST(ConcurrencyTest, GarbageCollection)
+{
+    Database db;
+    db.execute("create table tab1 (value : int32)");
+
+    const int rows = 100, updates = 100;
+    for (int i = 0; i < rows; ++i)
+        db.execute("insert (" + std::to_string(i) + ") to tab1");
+    for (int i = 0; i < updates; ++i)
+        db.execute("update tab1 set value = value + 1 where value >= 0");
+
+    auto table = db.get_table("tab1");
+    ASSERT_EQ(table->size(), rows);
+
+    // ended versions are reclaimed as writes go, not kept forever
+    ASSERT_LT(table->versions(), rows + 2 * SEGMENT_CAPACITY);
+
+    Result res = db.execute("select value from tab1 where value >= " + std::to_string(updates));
+    ASSERT_EQ(res.get_table()->size(), rows);
+}
+
+TEST(ConcurrencyTest, ReadersSeeWholeWrites)
+{
+    Database db;
+    db.execute("create table tab1 (value : int32)");
+
+    const int rows = 100, updates = 200;
+    for (int i = 0; i < rows; ++i)
+        db.execute("insert (0) to tab1");
+
+    std::atomic<bool> done = false;
+    std::atomic<int> torn = 0;
+
+    // every update replaces all versions at once, a reader never sees a mix
+    std::thread reader([&db, &done, &torn] {
+        while (!done) {
+            Result res = db.execute("select value from tab1 where value >= 0");
+            if (res.get_table()->size() != rows)
+                torn++;
+        }
+    });
+
+    for (int i = 0; i < updates; ++i)
+        db.execute("update tab1 set value = value + 1 where value >= 0");
+
+    done = true;
+    reader.join();
+
+    ASSERT_EQ(torn, 0);
+}
+
+TEST(ConcurrencyTest, SlotReuse)
+{
+    Database db;
+    db.execute("create table tab1 (value : int32)");
+
+    const int rows = 10;
+    for (int i = 0; i < rows; ++i)
+        db.execute("insert (" + std::to_string(i) + ") to tab1");
+
+    auto table = db.get_table("tab1");
+    {
+        auto lock = table->write_lock();
+        table->collect_garbage();
+    }
+
+    std::vector<RowId> ids;
+    for (int i = 1; i <= rows; ++i)
+        ids.push_back(i);
+
+    // with nothing to keep old versions alive, updates fill the reclaimed slots
+    std::set<RowVersion*> slots;
+    for (int i = 0; i < 100; ++i) {
+        db.execute("update tab1 set value = value + 1 where value >= 0");
+
+        auto lock = table->write_lock();
+        table->collect_garbage();
+        for (RowVersion* version : table->live_versions(ids))
+            slots.insert(version);
+    }
+    ASSERT_EQ(slots.size(), 2 * rows);
+    ASSERT_EQ(table->versions(), rows);
+
+    // rows are still found by the ids they got on insert, deleted ones are not
+    db.execute("delete tab1 where value >= 100 + " + std::to_string(rows / 2));
+    auto lock = table->write_lock();
+    auto versions = table->live_versions(std::vector<RowId>{1, rows});
+    ASSERT_EQ(versions[0]->row_->id(), 1);
+    ASSERT_EQ(versions[1], nullptr);
+}
+
+TEST(ConcurrencyTest, Compaction)
+{
+    Database db;
+    db.execute("create table tab1 (value : int32)");
+
+    auto table = db.get_table("tab1");
+    const int rows = 5 * SEGMENT_CAPACITY;
+    {
+        auto lock = table->write_lock();
+        for (int i = 0; i < rows; ++i)
+            table->insert(std::vector<Cell>{Cell(Int32(i))});
+    }
+
+    // the delete only ends versions, the segments are rewritten afterwards
+    ASSERT_TRUE(db.execute("delete tab1 where value % 4 != 0").ok());
+    {
+        auto lock = table->write_lock();
+        table->collect_garbage();
+    }
+
+    // transactions keep pointers to versions across the compaction
+    Session first(db), second(db);
+    first.execute("begin");
+    first.execute("update tab1 set value = -4 where value == 4");
+    second.execute("begin");
+    second.execute("update tab1 set value = -8 where value == 8");
+
+    db.compact();
+    ASSERT_EQ(table->compactions(), 1);
+    ASSERT_EQ(table->versions(), rows / 4);
+
+    ASSERT_TRUE(db.execute("update tab1 set value = 81 where value == 8").ok());
+    ASSERT_TRUE(first.execute("commit").ok());
+    ASSERT_FALSE(second.execute("commit").ok());
+
+    Session check(db);
+    Result res = check.execute("select value from tab1 where value == -4 || value == 81");
+    ASSERT_EQ(res.get_table()->size(), 2);
+
+    res = check.execute("select value from tab1 where value >= 0");
+    ASSERT_EQ(res.get_table()->size(), rows / 4 - 1);
+}
+
+TEST(ConcurrencyTest, TransactionalWritesDuringCompaction)
+{
+    Database db;
+    db.execute("create table tab1 (value : int32)");
+
+    auto table = db.get_table("tab1");
+    const int rows = 4 * SEGMENT_CAPACITY;
+    {
+        auto lock = table->write_lock();
+        for (int i = 0; i < rows; ++i)
+            table->insert(std::vector<Cell>{Cell(Int32(i))});
+    }
+    ASSERT_TRUE(db.execute("delete tab1 where value % 4 != 0").ok());
+
+    // every round leaves sparse segments behind for the next compaction
+    std::atomic<bool> done{false};
+    std::thread compactor([&] {
+        while (!done) {
+            {
+                auto lock = table->write_lock();
+                for (auto i = 0U; i < 2 * SEGMENT_CAPACITY; ++i)
+                    table->insert(std::vector<Cell>{Cell(Int32(-1))});
+            }
+            db.execute("delete tab1 where value < 0");
+            db.compact();
+        }
+    });
+
+    // UPDATE and DELETE scan without the table lock, their versions must
+    // outlive the segments compaction replaces meanwhile
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 2; ++t)
+        writers.emplace_back([&db] {
+            Session session(db);
+            for (int i = 0; i < 100; ++i) {
+                session.execute("begin");
+                session.execute("update tab1 set value = value where value % 8 == 0");
+                session.execute("delete tab1 where value % 8 == 4");
+                session.execute("rollback");
+            }
+        });
+    for (auto& writer : writers)
+        writer.join();
+    done = true;
+    compactor.join();
+
+    ASSERT_GT(table->compactions(), 0);
+    Result res = db.execute("select value from tab1 where value >= 0");
+    ASSERT_EQ(res.get_table()->size(), rows / 4);
+}
+
+TEST(ConcurrencyTest, MetricsFromManyThreads)
+{
+    Database db;
+    const int threads_count = 12, inserts = 200;
+    db.execute("create table tab1 (value : int32)");
+
+    // more threads than shards, some of them share one
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threads_count; ++t)
+        threads.emplace_back([&db] {
+            Session session(db);
+            for (int i = 0; i < inserts; ++i)
+                session.execute("insert (" + std::to_string(i) + ") to tab1");
+        });
+    for (auto& thread : threads)
+        thread.join();
+
+    MetricsSnapshot metrics = db.metrics_snapshot();
+    ASSERT_EQ(metrics.commands_[Insert].executed_, threads_count * inserts);
+    ASSERT_EQ(metrics.commands_[Insert].execute_.count_, threads_count * inserts);
+    ASSERT_EQ(metrics.commands_[Insert].parse_.count_, threads_count * inserts);
+}
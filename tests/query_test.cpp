@@ -1,10 +1,25 @@
 #include <gtest/gtest.h>
 #include <iostream>
+#include <algorithm>
+#include <unordered_set>
+#include <sstream>
+#include <cstring>
 
 #include "database/database.hpp"
+#include "database/scan_stats.hpp"
+#include "command/output.hpp"
+#include "parser/parser.hpp"
 
 using namespace memdb;
 
+// Rows of the result of query, 0 after a failure
+static size_t count_rows(Database& db, const std::string& query)
+{
+    Result res = db.execute(query);
+    EXPECT_TRUE(res.ok());
+    return res.ok() ? res.get_table()->size() : 0;
+}
+
 TEST(QueryTest, CreateTable)
 {
     Database db;
@@ -88,8 +103,6 @@ TEST(QueryTest, Select)
     Table* table = res.get_table();
 
     ASSERT_EQ(table->size(), 1);
-
-    delete table;
 }
 
 
@@ -113,4 +126,807 @@ TEST(QueryTest, Delete)
     Table* table = res.get_table();
 
     ASSERT_EQ(table->size(), 1);
-}
\ No newline at end of file
+}
+TEST(QueryTest, ZoneMapPruning)
+{
+    Database db;
+    db.execute("create table events (time : int32, name : string)");
+
+    // time-ordered rows, every segment covers its own range of time
+    auto table = db.get_table("events");
+    const int rows = 4 * SEGMENT_CAPACITY;
+    {
+        auto lock = table->write_lock();
+        for (int i = 0; i < rows; ++i)
+            table->insert(std::vector<Cell>{Cell(Int32(i)), Cell(std::string("e"))});
+    }
+
+    ASSERT_EQ(count_rows(db, "select time from events where time >= 4000"), rows - 4000);
+    ASSERT_EQ(count_rows(db, "select time from events where 4000 < time"), rows - 4001);
+    ASSERT_EQ(count_rows(db, "select time from events where time == 1023 || time == 1024"), 2);
+    ASSERT_EQ(count_rows(db, "select time from events where time < 0"), 0);
+    ASSERT_EQ(count_rows(db, "select time from events where time != 5 && name == \"e\""), rows - 1);
+
+    // segments ruled out by the zone maps are never evaluated: the division
+    // by zero at time == 5 is not reached
+    ASSERT_EQ(count_rows(db, "select time from events where time >= 3000 && 100 / (time - 5) >= 0"), rows - 3000);
+    ASSERT_FALSE(db.execute("select time from events where time >= 0 && 100 / (time - 5) >= 0").ok());
+
+    // updates widen the bounds of the segment they land in
+    ASSERT_TRUE(db.execute("update events set time = -1 where time == 4000").ok());
+    ASSERT_EQ(count_rows(db, "select time from events where time < 0"), 1);
+    ASSERT_TRUE(db.execute("delete events where time >= 3000 && 100 / (time - 5) >= 0").ok());
+    ASSERT_EQ(table->size(), 3001);
+}
+
+TEST(QueryTest, DictionaryEncoding)
+{
+    Database db;
+    db.execute("create table visits (city : string, id : int32)");
+
+    const char* cities[] = {"Paris", "Oslo", "Lima"};
+    auto table = db.get_table("visits");
+    {
+        auto lock = table->write_lock();
+        for (int i = 0; i < 3000; ++i)
+            table->insert(std::vector<Cell>{Cell(std::string(cities[i % 3])), Cell(Int32(i))});
+    }
+
+    auto& dictionary = table->columns()[0].dictionary_;
+    ASSERT_TRUE(dictionary);
+    ASSERT_EQ(dictionary->size(), 3);
+
+    ASSERT_EQ(count_rows(db, "select city from visits where city == \"Oslo\""), 1000);
+    ASSERT_EQ(count_rows(db, "select city from visits where \"Lima\" != city"), 2000);
+    ASSERT_EQ(count_rows(db, "select city from visits where city == \"Rome\""), 0);
+    ASSERT_EQ(count_rows(db, "select city from visits where city < \"Oslo\" && id < 3"), 1);
+    ASSERT_EQ(count_rows(db, "select city from visits where city + \"!\" == \"Paris!\""), 1000);
+
+    // equal strings share one entry, also in tables selected from the column
+    Result res = db.execute("select city from visits where id < 6");
+    ASSERT_TRUE(res.ok());
+    Table* selected = res.get_table();
+    ASSERT_EQ(selected->columns()[0].dictionary_, dictionary);
+    ASSERT_EQ(Cell(std::string("Paris")).hash(), dictionary->find(Cell(std::string("Paris"))).hash());
+
+    ASSERT_TRUE(db.execute("update visits set city = \"Rome\" where city == \"Lima\"").ok());
+    ASSERT_EQ(count_rows(db, "select city from visits where city == \"Rome\""), 1000);
+    ASSERT_EQ(dictionary->size(), 4);
+
+    // values past the capacity of the dictionary are stored as they are
+    {
+        auto lock = table->write_lock();
+        for (auto i = 0U; i < DICTIONARY_CAPACITY; ++i)
+            table->insert(std::vector<Cell>{Cell("c" + std::to_string(i)), Cell(Int32(-1))});
+    }
+    ASSERT_EQ(dictionary->size(), DICTIONARY_CAPACITY);
+    ASSERT_EQ(count_rows(db, "select city from visits where city == \"c4095\""), 1);
+    ASSERT_EQ(count_rows(db, "select city from visits where city == \"c0\" || city == \"Oslo\""), 1001);
+}
+
+TEST(QueryTest, CompressedColumns)
+{
+    std::vector<int32_t> runs(SEGMENT_CAPACITY, 7);
+    std::fill(runs.begin() + 100, runs.begin() + 200, -9);
+    std::vector<int32_t> counters, small;
+    for (auto i = 0U; i < SEGMENT_CAPACITY; ++i) {
+        counters.push_back(1000000 + 3 * i);
+        small.push_back(int32_t(i * 7919 % 100) - 50);
+    }
+
+    CompressedColumn rle(runs), delta(counters), frame(small);
+    ASSERT_EQ(rle.encoding(), CompressedColumn::RunLength);
+    ASSERT_EQ(delta.encoding(), CompressedColumn::Delta);
+    ASSERT_EQ(frame.encoding(), CompressedColumn::FrameOfReference);
+    ASSERT_EQ(rle.decode(), runs);
+    ASSERT_EQ(delta.decode(), counters);
+    ASSERT_EQ(frame.decode(), small);
+    ASSERT_LT(frame.bytes(), SEGMENT_CAPACITY);
+
+    auto selected = [] (const CompressedColumn& column, int64_t lo, int64_t hi) {
+        SlotMask mask{};
+        column.select(lo, hi, mask.data());
+        size_t count = 0;
+        for (uint64_t word : mask)
+            count += std::popcount(word);
+        return count;
+    };
+    ASSERT_EQ(selected(rle, -9, -9), 100);
+    ASSERT_EQ(selected(delta, 1000000, 1000299), 100);
+    ASSERT_EQ(selected(frame, -50, -41),
+        std::count_if(small.begin(), small.end(), [] (int32_t x) { return x < -40; }));
+    ASSERT_EQ(selected(frame, 50, 100), 0);
+
+    Database db;
+    db.execute("create table samples (time : int32, value : int32)");
+
+    auto table = db.get_table("samples");
+    const int rows = 3 * SEGMENT_CAPACITY;
+    {
+        auto lock = table->write_lock();
+        for (int i = 0; i < rows; ++i)
+            table->insert(std::vector<Cell>{Cell(Int32(i)), Cell(Int32(i % 4))});
+        table->compact();
+    }
+
+    ASSERT_EQ(count_rows(db, "select time from samples where value == 3"), rows / 4);
+    ASSERT_EQ(count_rows(db, "select time from samples where value != 0 && time < 8"), 6);
+    ASSERT_EQ(count_rows(db, "select time from samples where value > 2 || time <= 1"), rows / 4 + 2);
+
+    // rows of a sealed segment ruled out by the compressed columns are never
+    // evaluated: the division by zero at time == 5 is not reached
+    ASSERT_EQ(count_rows(db, "select time from samples where time == 7 && 100 / (time - 5) >= 0"), 1);
+
+    // a reused slot unseals its segment, the new value is found
+    ASSERT_TRUE(db.execute("delete samples where time == 5").ok());
+    {
+        auto lock = table->write_lock();
+        table->collect_garbage();
+        table->insert(std::vector<Cell>{Cell(Int32(5)), Cell(Int32(100))});
+    }
+    ASSERT_EQ(count_rows(db, "select time from samples where value == 100"), 1);
+    ASSERT_EQ(count_rows(db, "select time from samples where value == 1"), rows / 4 - 1);
+}
+
+TEST(QueryTest, CellHash)
+{
+    // equal values hash alike, whatever buffer holds them
+    std::string long_text(200, 'x');
+    ASSERT_EQ(Cell(std::string("abc")).hash(), Cell(std::string("ab") + "c").hash());
+    ASSERT_EQ(Cell(long_text).hash(), Cell(std::string(long_text)).hash());
+    ASSERT_NE(Cell(std::string("abc")).hash(), Cell(std::string("abd")).hash());
+    ASSERT_NE(Cell(std::string("")).hash(), Cell(std::string("a")).hash());
+    ASSERT_NE(Cell(Int32(1)).hash(), Cell(true).hash());
+    ASSERT_EQ(Cell(std::vector<std::byte>{std::byte(1), std::byte(2)}).hash(),
+        Cell(std::vector<std::byte>{std::byte(1), std::byte(2)}).hash());
+
+    // every length class of the byte hash spreads keys apart
+    for (size_t size : {1, 3, 4, 8, 16, 17, 48, 49, 100}) {
+        std::unordered_set<std::string> keys;
+        std::unordered_set<size_t> hashes;
+        for (int i = 0; i < 1000; ++i) {
+            std::string key(size, 'k');
+            key[i % size] = char(i);
+            key[size / 2] ^= char(i >> 8);
+            keys.insert(key);
+            hashes.insert(Cell(key).hash());
+        }
+        ASSERT_EQ(hashes.size(), keys.size()) << size;
+    }
+
+    Database db;
+    db.execute("create table words (word : string, n : int32)");
+    db.execute("insert (\"one\", 1) to words");
+    db.execute("insert (\"two\", 2) to words");
+
+    std::vector<const Row*> rows;
+    auto table = db.get_table("words");
+    auto lock = table->write_lock();
+    for (RowVersion* version : table->live_versions(std::vector<RowId>{1, 2}))
+        rows.push_back(&*version->row_);
+
+    std::vector<size_t> hashes;
+    hash_column(rows, 0, hashes);
+    ASSERT_EQ(hashes, (std::vector<size_t>{Cell(std::string("one")).hash(), Cell(std::string("two")).hash()}));
+    hash_column(rows, 1, hashes);
+    ASSERT_EQ(hashes, (std::vector<size_t>{Cell(Int32(1)).hash(), Cell(Int32(2)).hash()}));
+}
+
+TEST(QueryTest, CellCompare)
+{
+    auto str = [] (const std::string& value) { return Cell(value); };
+    auto bytes = [] (std::initializer_list<int> values) {
+        std::vector<std::byte> data;
+        for (int value : values)
+            data.push_back(std::byte(value));
+        return Cell(data);
+    };
+
+    // common prefix: the shorter value goes first
+    ASSERT_LT(str("ab").compare(str("abc")), 0);
+    ASSERT_GT(str("b").compare(str("abc")), 0);
+    ASSERT_EQ(str("").compare(str("")), 0);
+    ASSERT_TRUE(str("\xff").less(str("\xff\x01")));
+    ASSERT_LT(bytes({1, 2}).compare(bytes({1, 2, 0})), 0);
+    ASSERT_GT(bytes({0x80}).compare(bytes({0x7f, 0xff})), 0);
+    ASSERT_TRUE(bytes({}).equals(bytes({})));
+
+    // dictionary strings compare with plain ones by value
+    Dictionary dictionary;
+    Cell oslo = dictionary.encode(str("Oslo"));
+    ASSERT_TRUE(oslo.entry());
+    ASSERT_TRUE(oslo.equals(str("Oslo")));
+    ASSERT_TRUE(CellEqual{}(str("Oslo"), oslo));
+    ASSERT_TRUE(oslo.less(str("Paris")));
+    ASSERT_TRUE(dictionary.encode(str("Lima")).less(oslo));
+
+    // different types are ordered by type, but are not less-comparable
+    ASSERT_LT(Cell(Int32(100)).compare(Cell(false)), 0);
+    ASSERT_FALSE(Cell(Int32(1)).equals(Cell(true)));
+    ASSERT_THROW(Cell(Int32(1)).less(str("a")), TypeException);
+    ASSERT_LT(Cell(Int32(-5)).compare(Cell(Int32(3))), 0);
+
+    // sorting agrees with std::string
+    std::vector<std::string> values;
+    for (int i = 0; i < 500; ++i)
+        values.push_back(std::string(i % 7, 'a' + i % 3) + std::to_string(i * 37 % 101));
+    std::vector<Cell> cells(values.begin(), values.end());
+    std::sort(values.begin(), values.end());
+    std::sort(cells.begin(), cells.end(), CellCompare{});
+    for (auto i = 0LU; i < values.size(); ++i)
+        ASSERT_EQ(cells[i].get_string(), values[i]);
+}
+
+TEST(QueryTest, TypeChecking)
+{
+    Database db;
+    db.execute("create table tab1 (name : string, value : int32, flag : bool)");
+
+    // type errors are found before any row is read, even in an empty table
+    ASSERT_FALSE(db.execute("select name from tab1 where value").ok());
+    ASSERT_FALSE(db.execute("select name from tab1 where value == \"a\"").ok());
+    ASSERT_FALSE(db.execute("select name from tab1 where missing > 1").ok());
+    ASSERT_FALSE(db.execute("delete tab1 where !value").ok());
+    ASSERT_FALSE(db.execute("update tab1 set value = \"a\" where value > 1").ok());
+    ASSERT_FALSE(db.execute("update tab1 set missing = 1 where value > 1").ok());
+
+    for (int i = 0; i < 10; ++i)
+        db.execute("insert (\"n\", " + std::to_string(i) + ", " + (i % 2 ? "true" : "false") + ") to tab1");
+
+    // int and bool kernels
+    ASSERT_EQ(count_rows(db, "select value from tab1 where value * 0 == 0"), 10);
+    ASSERT_EQ(count_rows(db, "select value from tab1 where value % 3 == 1 && -value < -2"), 2);
+    ASSERT_EQ(count_rows(db, "select value from tab1 where flag"), 5);
+    ASSERT_EQ(count_rows(db, "select value from tab1 where !flag == (value % 2 == 0)"), 10);
+    ASSERT_EQ(count_rows(db, "select value from tab1 where flag ^ (value < 4)"), 5);
+    ASSERT_EQ(count_rows(db, "select value from tab1 where name + \"x\" == \"nx\""), 10);
+    ASSERT_FALSE(db.execute("select value from tab1 where 10 / (value - 3) > 0").ok());
+
+    // a failed update changes nothing
+    ASSERT_FALSE(db.execute("update tab1 set flag = value where value > 1").ok());
+    ASSERT_TRUE(db.execute("update tab1 set value = value * 2, flag = !flag where value > 4").ok());
+    ASSERT_EQ(count_rows(db, "select value from tab1 where value > 9 && !flag"), 3);
+}
+
+TEST(QueryTest, ProjectedResults)
+{
+    Database db;
+    db.execute("create table tab1 (name : string, value : int32, flag : bool)");
+
+    auto table = db.get_table("tab1");
+    const int rows = 3 * SEGMENT_CAPACITY;
+    {
+        auto lock = table->write_lock();
+        for (int i = 0; i < rows; ++i)
+            table->insert(std::vector<Cell>{Cell("n" + std::to_string(i)), Cell(Int32(i)), Cell(i % 2 == 0)});
+    }
+    ASSERT_TRUE(db.execute("delete tab1 where value % 4 != 0").ok());
+
+    // the result refers to the selected rows, nothing is copied
+    Result res = db.execute("select value, name from tab1 where flag");
+    ASSERT_TRUE(res.ok());
+    Table* selected = res.get_table();
+    ASSERT_EQ(selected->size(), rows / 4);
+    ASSERT_EQ(selected->versions(), 0);
+
+    std::ostringstream before;
+    selected->print(before);
+    ASSERT_NE(before.str().find("| 8 "), std::string::npos);
+
+    // rows stay readable after the source drops, collects and compacts them
+    ASSERT_TRUE(db.execute("delete tab1 where value >= 2048").ok());
+    {
+        auto lock = table->write_lock();
+        table->compact();
+    }
+    ASSERT_EQ(table->compactions(), 1);
+    ASSERT_GT(table->versions(), table->size());
+
+    std::ostringstream after;
+    selected->print(after);
+    ASSERT_EQ(before.str(), after.str());
+
+    // selecting from the result copies its rows in first
+    auto names = selected->select({"name"}, Expression());
+    ASSERT_EQ(selected->versions(), rows / 4);
+    ASSERT_EQ(selected->size(), rows / 4);
+    ASSERT_EQ(names->size(), rows / 4);
+    names.reset();
+    res = Result(nullptr);
+
+    // with the result gone, the versions it kept can be reclaimed
+    {
+        auto lock = table->write_lock();
+        table->collect_garbage();
+    }
+    ASSERT_EQ(table->versions(), table->size());
+}
+
+TEST(QueryTest, ResultOwnership)
+{
+    Database db;
+    Session session(db);
+    session.execute("create table tab1 (name : string, value : int32)");
+    session.execute("insert (\"a\", 1) to tab1");
+    session.execute("insert (\"b\", 10) to tab1");
+
+    // tables of the catalog are borrowed and never pooled
+    Table* selected = nullptr;
+    {
+        Result res = session.execute("insert (\"c\", 100) to tab1");
+        ASSERT_EQ(res.get_table(), db.get_table("tab1").get());
+        ASSERT_FALSE(res.release());
+    }
+    ASSERT_EQ(session.results()->size(), 0);
+
+    // selected tables are owned and go back to the pool of the session
+    {
+        Result res = session.execute("select name, value from tab1 where value > 5");
+        ASSERT_TRUE(res.ok());
+        ASSERT_FALSE(res.shared_table());
+        selected = res.get_table();
+        ASSERT_EQ(selected->size(), 2);
+    }
+    ASSERT_EQ(session.results()->size(), 1);
+
+    // the next result reuses the table with its new columns
+    {
+        Result res = session.execute("select value from tab1 where value < 5");
+        ASSERT_EQ(res.get_table(), selected);
+        ASSERT_EQ(selected->width(), 1);
+        ASSERT_EQ(selected->columns()[0].name_, "value");
+        ASSERT_EQ(selected->size(), 1);
+        ASSERT_EQ(session.results()->size(), 0);
+
+        // a result set taken out of its result still goes back when released
+        ResultTable owned = res.release();
+        ASSERT_FALSE(res.get_table());
+        owned.reset();
+        ASSERT_EQ(session.results()->size(), 1);
+    }
+
+    // the pool keeps a bounded number of tables
+    {
+        std::vector<Result> results;
+        for (auto i = 0U; i < 2 * RESULT_POOL_CAPACITY; ++i)
+            results.push_back(session.execute("select name from tab1 where value > 0"));
+        for (auto& res : results)
+            ASSERT_EQ(res.get_table()->size(), 3);
+    }
+    ASSERT_EQ(session.results()->size(), RESULT_POOL_CAPACITY);
+}
+
+TEST(QueryTest, ResultFormats)
+{
+    Database db;
+    db.execute("create table tab1 (name : string, value : int32, flag : bool, data : bytes)");
+    db.execute("insert (\"plain\", -5, true, 0x0AFF) to tab1");
+    db.execute("insert (\"a,b\", 7, false, 0x00) to tab1");
+
+    Result res = db.execute("select name, value, flag, data from tab1 where value < 10");
+    ASSERT_TRUE(res.ok());
+
+    OutputBuffer out;
+    res.write_csv(out);
+    ASSERT_EQ(out.view(), "name,value,flag,data\nplain,-5,true,0x0AFF\n\"a,b\",7,false,0x00\n");
+
+    out.clear();
+    res.write_json(out);
+    ASSERT_EQ(out.view(), "{\"columns\":[{\"name\":\"name\",\"type\":\"String\"},"
+        "{\"name\":\"value\",\"type\":\"Int32\"},{\"name\":\"flag\",\"type\":\"Bool\"},"
+        "{\"name\":\"data\",\"type\":\"Bytes\"}],"
+        "\"rows\":[[\"plain\",-5,true,\"0x0AFF\"],[\"a,b\",7,false,\"0x00\"]]}\n");
+
+    out.clear();
+    db.execute("select missing from tab1").write_json(out);
+    ASSERT_EQ(out.view(), "{\"error\":\"Requested column missing does not exist\"}\n");
+
+    // binary rows are read at fixed offsets, integers little-endian
+    out.clear();
+    db.execute("select value, name from tab1 where flag").write_binary(out);
+    std::string expected("MDBR\x01\x00" "\x02\x00"
+        "\x00\x05\x00value" "\x02\x04\x00name"
+        "\x01\x00\x00\x00" "\xfb\xff\xff\xff" "\x05\x00\x00\x00plain"
+        "\x00\x00\x00\x00", 6 + 2 + 8 + 7 + 4 + 4 + 9 + 4);
+    ASSERT_EQ(out.view(), expected);
+
+    // large results reach the stream in blocks of whole rows
+    auto table = db.get_table("tab1");
+    {
+        auto lock = table->write_lock();
+        for (int i = 0; i < 20000; ++i)
+            table->insert(std::vector<Cell>{Cell("row " + std::to_string(i)), Cell(Int32(i)),
+                Cell(true), Cell(std::vector<std::byte>(3))});
+    }
+
+    std::ostringstream stream;
+    {
+        OutputBuffer chunked(stream);
+        db.execute("select value from tab1 where value >= 0").write_binary(chunked);
+    }
+    std::string binary = stream.str();
+
+    size_t offset = 6 + 2 + 1 + 2 + 5, rows = 0, blocks = 0;
+    for (;;) {
+        uint32_t count;
+        std::memcpy(&count, binary.data() + offset, 4);
+        offset += 4 + 4 * count;
+        if (!count)
+            break;
+        rows += count;
+        blocks++;
+    }
+    ASSERT_EQ(offset, binary.size());
+    ASSERT_EQ(rows, 20001);
+    ASSERT_GT(blocks, 1);
+
+    std::ostringstream csv;
+    {
+        OutputBuffer chunked(csv);
+        db.execute("select name from tab1 where value >= 19990").write_csv(chunked);
+    }
+    std::string lines = csv.str();
+    ASSERT_EQ(std::count(lines.begin(), lines.end(), '\n'), 11);
+}
+
+TEST(QueryTest, AlignedPrinting)
+{
+    Database db;
+    db.execute("create table t (a : int32, s : string)");
+    db.execute("insert (7, \"abc\") to t");
+    db.execute("insert (-12, \"" + std::string(45, 'x') + "\") to t");
+
+    // columns fit their values, longer ones wrap at PRINT_MAX_WIDTH
+    std::ostringstream os;
+    db.execute("select a, s from t where a < 10").print(os);
+    std::string bar = std::string(1 + (3 + 3) + (PRINT_MAX_WIDTH + 3), '-') + '\n';
+    std::string pad = std::string(PRINT_MAX_WIDTH - 5, ' ');
+    ASSERT_EQ(os.str(), "\n" + bar
+        + "| a   | s" + std::string(PRINT_MAX_WIDTH, ' ') + "|\n" + bar
+        + "| 7   | abc" + std::string(PRINT_MAX_WIDTH - 2, ' ') + "|\n" + bar
+        + "| -12 | " + std::string(PRINT_MAX_WIDTH, 'x') + " |\n"
+        + "|     | xxxxx" + pad + " |\n" + bar);
+
+    // at most max_rows rows, with a note on the rest
+    std::ostringstream limited;
+    db.execute("select a from t where a < 10").print(limited, 1);
+    ASSERT_EQ(limited.str(), "\n-----\n| a |\n-----\n| 7 |\n-----\n(1 of 2 rows shown)\n");
+
+    // widths come from the first rows, later ones wrap
+    auto table = db.get_table("t");
+    {
+        auto lock = table->write_lock();
+        for (auto i = 0U; i < PRINT_SAMPLE_ROWS; ++i)
+            table->insert(std::vector<Cell>{Cell(Int32(1)), Cell(std::string("y"))});
+        table->insert(std::vector<Cell>{Cell(Int32(123456)), Cell(std::string("z"))});
+    }
+    std::ostringstream sampled;
+    db.execute("select a from t where a > 0").print(sampled);
+    ASSERT_NE(sampled.str().find("| 1 |\n| 2 |\n| 3 |\n| 4 |\n| 5 |\n| 6 |\n"), std::string::npos);
+    ASSERT_EQ(sampled.str().find("123456"), std::string::npos);
+
+    // the scan stops at the row limit
+    ScanStats stats;
+    {
+        ScanStats::Scope scope(stats);
+        std::ostringstream first;
+        table->print(first, 1);
+    }
+    ASSERT_EQ(stats.rows_read_, 1);
+}
+
+TEST(QueryTest, Cursors)
+{
+    Database db;
+    Session session(db);
+    session.execute("create table tab1 (name : string, value : int32)");
+    for (auto i = 0U; i < 3 * SEGMENT_CAPACITY; ++i)
+        session.execute("insert (\"row\", " + std::to_string(i) + ") to tab1");
+    session.execute("delete tab1 where value < 100");
+
+    ASSERT_TRUE(session.execute("declare c1 cursor for select value from tab1 where value % 2 == 0").ok());
+
+    // changes after DECLARE are not seen by the cursor
+    session.execute("insert (\"new\", 10000) to tab1");
+    session.execute("update tab1 set value = -1 where value == 200");
+
+    // every fetch holds at most the rows asked for, in scan order
+    std::vector<int> values;
+    for (;;)
+    {
+        Result res = session.execute("FETCH 1000 FROM c1");
+        ASSERT_TRUE(res.ok());
+        size_t size = res.get_table()->size();
+        ASSERT_LE(size, 1000);
+        res.get_table()->for_each_row([&] (const Row& row, const std::vector<size_t>& positions) {
+            values.push_back(row[positions[0]].get_int());
+        });
+        if (size == 0)
+            break;
+    }
+
+    std::vector<int> expected;
+    for (auto i = 100; i < int(3 * SEGMENT_CAPACITY); i += 2)
+        expected.push_back(i);
+    ASSERT_EQ(values, expected);
+
+    // an exhausted cursor keeps returning empty results until closed
+    ASSERT_EQ(session.execute("fetch 10 from c1").get_table()->size(), 0);
+    ASSERT_TRUE(session.execute("close c1").ok());
+    ASSERT_FALSE(session.execute("fetch 10 from c1").ok());
+    ASSERT_FALSE(session.execute("close c1").ok());
+
+    // names are unique per session, columns and types are checked at DECLARE
+    ASSERT_TRUE(session.execute("declare c2 CURSOR  FOR select name from tab1 where value > 2000").ok());
+    ASSERT_FALSE(session.execute("declare c2 cursor for select name from tab1").ok());
+    ASSERT_FALSE(session.execute("declare c3 cursor for select missing from tab1").ok());
+    ASSERT_FALSE(session.execute("declare c3 cursor for select name from tab1 where name + 1").ok());
+    ASSERT_EQ(session.execute("fetch 5 from c2").get_table()->size(), 5);
+
+    // a transaction's cursor reads its snapshot and stays open after commit
+    session.execute("begin");
+    ASSERT_TRUE(session.execute("declare c3 cursor for select value from tab1 where value >= 10000").ok());
+    session.execute("insert (\"tx\", 20000) to tab1");
+    ASSERT_FALSE(session.execute("declare c4 cursor for select value from tab1").ok());
+    ASSERT_TRUE(session.execute("commit").ok());
+
+    Result res = session.execute("fetch 100 from c3");
+    ASSERT_EQ(res.get_table()->size(), 1);
+    ASSERT_EQ(res.get_table()->columns()[0].name_, "value");
+}
+
+TEST(QueryTest, PreparedStatements)
+{
+    Database db;
+    Session session(db);
+    session.execute("create table tab1 (name : string, value : int32, flag : bool, data : bytes)");
+
+    uint32_t insert = session.prepare("insert ($1, $2, $3, $4) to tab1");
+    uint32_t named = session.prepare("insert (value = $1, name = $2, flag = true, data = 0x00) to tab1");
+    uint32_t select = session.prepare("select name, value from tab1 where value > $1 && flag == $2");
+    ASSERT_NE(insert, named);
+
+    std::vector<std::byte> bytes = { std::byte(1), std::byte(2) };
+    for (int i = 0; i < 10; ++i)
+        ASSERT_TRUE(session.execute(insert, { Cell("row" + std::to_string(i)), Cell(i), Cell(i % 2 == 0), Cell(bytes) }).ok());
+    ASSERT_TRUE(session.execute(named, { Cell(100), Cell(std::string("named")) }).ok());
+
+    // the statement is reused with other values
+    Result res = session.execute(select, { Cell(5), Cell(true) });
+    ASSERT_TRUE(res.ok());
+    ASSERT_EQ(res.get_table()->size(), 3);
+    res = session.execute(select, { Cell(-1), Cell(false) });
+    ASSERT_EQ(res.get_table()->size(), 5);
+
+    // parameters take part in expressions like any value
+    uint32_t update = session.prepare("update tab1 set value = value + $1 where name == $2");
+    ASSERT_TRUE(session.execute(update, { Cell(1), Cell(std::string("named")) }).ok());
+    res = session.execute("select value from tab1 where name == \"named\"");
+    res.get_table()->for_each_row([&] (const Row& row, const std::vector<size_t>& positions) {
+        ASSERT_EQ(row[positions[0]].get_int(), 101);
+    });
+
+    // missing values and values of the wrong type are errors, not crashes
+    ASSERT_FALSE(session.execute(select, { Cell(5) }).ok());
+    ASSERT_FALSE(session.execute(insert, { Cell(1), Cell(1), Cell(true), Cell(bytes) }).ok());
+    ASSERT_FALSE(session.execute(999, {}).ok());
+
+    // a plain query with a parameter has nothing to bind it
+    ASSERT_FALSE(session.execute("select name from tab1 where value > $1").ok());
+    ASSERT_THROW(session.prepare("select name from tab1 where value > $0"), ParseException);
+
+    ASSERT_TRUE(session.deallocate(select));
+    ASSERT_FALSE(session.deallocate(select));
+    ASSERT_FALSE(session.execute(select, { Cell(5), Cell(true) }).ok());
+    ASSERT_EQ(db.execute("select name from tab1").get_table()->size(), 11);
+}
+
+TEST(QueryTest, ScanEstimate)
+{
+    Database db;
+    Session session(db);
+    session.execute("create table tab1 (name : string, value : int32)");
+    for (auto i = 0U; i < 3 * SEGMENT_CAPACITY; ++i)
+        session.execute("insert (\"row\", " + std::to_string(i) + ") to tab1");
+
+    auto estimate = [&] (const std::string& query) {
+        Parser p(query);
+        Command command;
+        p.parse(command);
+        return command.estimate(&session);
+    };
+
+    // zone maps rule out the segments a condition cannot hold in
+    ASSERT_EQ(estimate("select value from tab1 where name == \"row\""), 3 * SEGMENT_CAPACITY);
+    ASSERT_EQ(estimate("select value from tab1 where value == 5"), SEGMENT_CAPACITY);
+    ASSERT_EQ(estimate("delete tab1 where value >= " + std::to_string(SEGMENT_CAPACITY)), 2 * SEGMENT_CAPACITY);
+    ASSERT_EQ(estimate("update tab1 set value = 0 where value < 0"), 0);
+
+    // statements that scan nothing
+    ASSERT_EQ(estimate("insert (\"row\", 1) to tab1"), 0);
+    ASSERT_EQ(estimate("select value from missing"), 0);
+}
+
+TEST(QueryTest, Explain)
+{
+    Database db;
+    Session session(db);
+    session.execute("create table tab1 (name : string, value : int32)");
+    for (auto i = 0U; i < 3 * SEGMENT_CAPACITY; ++i)
+        session.execute("insert (\"row\", " + std::to_string(i) + ") to tab1");
+
+    auto operators = [] (Result& res) {
+        std::vector<std::string> lines;
+        res.get_table()->for_each_row([&] (const Row& row, const std::vector<size_t>& positions) {
+            lines.push_back(row[positions[0]].get_string());
+        });
+        return lines;
+    };
+
+    // the plan alone, nothing is run
+    Result res = session.execute("explain select name, value from tab1 where value == 5");
+    ASSERT_TRUE(res.ok());
+    ASSERT_EQ(res.get_table()->width(), 1);
+    ASSERT_EQ(operators(res), (std::vector<std::string>{
+        "Project name, value", "  Scan tab1 filter value == 5"}));
+    ASSERT_EQ(res.plan()->rows_out_, 0);
+
+    res = session.execute("explain select value from (select value from tab1 where value < 10) where value > 7");
+    ASSERT_EQ(operators(res), (std::vector<std::string>{
+        "Project value", "  Scan subquery filter value > 7",
+        "    Project value", "      Scan tab1 filter value < 10"}));
+
+    // zone maps rule out two of the three segments
+    res = session.execute("explain analyze select value from tab1 where value == 5");
+    ASSERT_TRUE(res.ok());
+    ASSERT_EQ(res.get_table()->width(), 6);
+    const PlanNode* plan = res.plan();
+    ASSERT_NE(plan, nullptr);
+    ASSERT_EQ(plan->rows_in_, 1);
+    ASSERT_EQ(plan->rows_out_, 1);
+    const PlanNode& scan = plan->children_.front();
+    ASSERT_EQ(scan.rows_in_, 3 * SEGMENT_CAPACITY);
+    ASSERT_EQ(scan.rows_out_, 1);
+    ASSERT_GE(scan.rows_skipped_, 2 * SEGMENT_CAPACITY);
+    ASSERT_GT(scan.bytes_, 0);
+
+    // the statement takes effect
+    res = session.execute("explain analyze delete tab1 where value >= 100");
+    ASSERT_TRUE(res.ok());
+    ASSERT_EQ(res.plan()->name_, "Delete");
+    ASSERT_EQ(res.plan()->rows_out_, 3 * SEGMENT_CAPACITY - 100);
+    ASSERT_EQ(session.execute("select value from tab1").get_table()->size(), 100);
+
+    // errors of the statement are reported instead of a plan
+    res = session.execute("explain analyze select value from missing");
+    ASSERT_FALSE(res.ok());
+
+    // statements run through Command::analyze keep their own result
+    Parser p("select value from tab1 where value < 10");
+    Command command;
+    p.parse(command);
+    res = command.analyze(&session);
+    ASSERT_TRUE(res.ok());
+    ASSERT_EQ(res.get_table()->size(), 10);
+    ASSERT_EQ(res.plan()->rows_out_, 10);
+}
+
+TEST(QueryTest, LatencyHistogram)
+{
+    // every latency falls in a bucket at most 1/8 wider than itself
+    size_t last = 0;
+    for (uint64_t ns = 0; ns < (uint64_t(1) << 36); ns = ns * 5 / 4 + 1) {
+        size_t bucket = LatencyHistogram::bucket(ns);
+        ASSERT_GE(bucket, last);
+        ASSERT_GE(LatencyHistogram::upper_bound(bucket), ns);
+        ASSERT_LE(LatencyHistogram::upper_bound(bucket), ns + ns / 8);
+        if (bucket > 0) {
+            ASSERT_LT(LatencyHistogram::upper_bound(bucket - 1), ns);
+        }
+        last = bucket;
+    }
+
+    LatencyHistogram histogram;
+    for (uint64_t us = 1; us <= 100; ++us)
+        histogram.record(us * 1000);
+    HistogramSnapshot snapshot;
+    snapshot.add(histogram);
+    ASSERT_EQ(snapshot.count_, 100);
+    ASSERT_EQ(snapshot.sum_ns_, 5050 * 1000);
+    ASSERT_NEAR(snapshot.quantile(0.5), 50000, 50000 / 8);
+    ASSERT_NEAR(snapshot.quantile(0.99), 99000, 99000 / 8);
+}
+
+TEST(QueryTest, Metrics)
+{
+    Database db;
+    db.execute("create table tab1 (name : string, value : int32)");
+    for (auto i = 0; i < 10; ++i)
+        db.execute("insert (\"row\", " + std::to_string(i) + ") to tab1");
+    db.execute("select value from tab1 where value < 4");
+    db.execute("select value from missing");
+    db.execute("selec value from tab1");
+
+    MetricsSnapshot metrics = db.metrics_snapshot();
+    const CommandSnapshot& insert = metrics.commands_[Insert];
+    ASSERT_EQ(insert.executed_, 10);
+    ASSERT_EQ(insert.failed_, 0);
+    ASSERT_EQ(insert.parse_.count_, 10);
+    ASSERT_EQ(insert.execute_.count_, 10);
+    ASSERT_EQ(insert.rows_returned_, 0);
+
+    const CommandSnapshot& select = metrics.commands_[Select];
+    ASSERT_EQ(select.executed_, 2);
+    ASSERT_EQ(select.failed_, 1);
+    ASSERT_EQ(select.rows_scanned_, 10);
+    ASSERT_EQ(select.rows_returned_, 4);
+    ASSERT_EQ(metrics.parse_errors_, 1);
+
+    ASSERT_EQ(metrics.tables_.size(), 1);
+    ASSERT_EQ(metrics.tables_[0].name_, "tab1");
+    ASSERT_EQ(metrics.tables_[0].rows_, 10);
+    ASSERT_GT(metrics.tables_[0].bytes_, 10 * 2 * sizeof(Cell));
+
+    ASSERT_EQ(command_stats_table(metrics)->size(), 3);    // create, insert, select
+
+    OutputBuffer out;
+    write_prometheus(metrics, out);
+    std::string text(out.view());
+    ASSERT_NE(text.find("# TYPE memdb_statements_total counter\n"), std::string::npos);
+    ASSERT_NE(text.find("memdb_statements_total{command=\"insert\"} 10\n"), std::string::npos);
+    ASSERT_NE(text.find("memdb_statement_errors_total{command=\"select\"} 1\n"), std::string::npos);
+    ASSERT_NE(text.find("memdb_parse_errors_total 1\n"), std::string::npos);
+    ASSERT_NE(text.find("memdb_execute_duration_seconds_count{command=\"select\"} 2\n"), std::string::npos);
+    ASSERT_NE(text.find("memdb_execute_duration_seconds{command=\"insert\",quantile=\"0.99\"} "), std::string::npos);
+    ASSERT_NE(text.find("memdb_table_rows{table=\"tab1\"} 10\n"), std::string::npos);
+}
+
+TEST(QueryTest, NormalizeQuery)
+{
+    ASSERT_EQ(normalize_query("select  name from tab1\n  where value < 42"),
+        "select name from tab1 where value < ?");
+    ASSERT_EQ(normalize_query("insert (\"a \\\" b\", 0x0aff, -7) to tab2"),
+        "insert (?, ?, -?) to tab2");
+    ASSERT_EQ(normalize_query("select v1 from t2 where v1 = $1 "),
+        "select v1 from t2 where v1 = $1");
+}
+
+TEST(QueryTest, SlowLog)
+{
+    Database db;
+    db.execute("create table tab1 (name : string, value : int32)");
+    db.slow_log().set_threshold(0);
+    for (auto i = 0; i < 10; ++i)
+        db.execute("insert (\"row\", " + std::to_string(i) + ") to tab1");
+    db.execute("select value from tab1 where value < 4");
+
+    auto entries = db.slow_log().entries();
+    ASSERT_EQ(entries.size(), 11);
+    ASSERT_EQ(entries[0].query_, "insert (?, ?) to tab1");
+
+    const SlowQuery& select = entries.back();
+    ASSERT_EQ(select.query_, "select value from tab1 where value < ?");
+    ASSERT_EQ(select.rows_scanned_, 10);
+    ASSERT_EQ(select.rows_returned_, 4);
+    ASSERT_TRUE(select.ok_);
+    ASSERT_GT(select.parse_ns_, 0);
+    ASSERT_EQ(select.plan_.rfind("Project value <- Scan tab1", 0), 0);
+    ASSERT_EQ(slow_log_table(entries)->size(), 11);
+
+    // the ring keeps the latest entries
+    SlowLogOptions options;
+    options.threshold_us_ = 0;
+    options.capacity_ = 4;
+    db.slow_log().configure(options);
+    ASSERT_EQ(db.slow_log().entries().size(), 4);
+    db.execute("select name from tab1");
+    entries = db.slow_log().entries();
+    ASSERT_EQ(entries.size(), 4);
+    ASSERT_EQ(entries.back().query_, "select name from tab1");
+
+    // fast statements are not recorded
+    db.slow_log().set_threshold(UINT64_MAX);
+    db.execute("select name from tab1");
+    ASSERT_EQ(db.slow_log().entries().back().query_, "select name from tab1");
+    ASSERT_EQ(db.slow_log().entries().size(), 4);
+}
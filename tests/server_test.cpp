@@ -0,0 +1,452 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <string>
+#include <vector>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "database/database.hpp"
+#include "server/server.hpp"
+#include "server/protocol.hpp"
+#include "client/client.hpp"
+
+using namespace memdb;
+
+// Blocking client side of the framing, just enough for the tests
+static int connect_to(uint16_t port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Frame of a QUERY message
+static std::string frame(const std::string& query)
+{
+    uint32_t length = query.size() + 1;
+    std::string res(4, '\0');
+    for (int i = 0; i < 4; ++i)
+        res[i] = char(length >> (8 * i));
+    return res + char(QueryMessage) + query;
+}
+
+static bool send_all(int fd, const std::string& data)
+{
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t res = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (res <= 0)
+            return false;
+        sent += res;
+    }
+    return true;
+}
+
+static bool recv_all(int fd, char* data, size_t size)
+{
+    while (size) {
+        ssize_t res = recv(fd, data, size, 0);
+        if (res <= 0)
+            return false;
+        data += res;
+        size -= res;
+    }
+    return true;
+}
+
+static uint32_t load_u32(const std::string& data, size_t offset)
+{
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i)
+        value |= uint32_t(uint8_t(data[offset + i])) << (8 * i);
+    return value;
+}
+
+// Payload of the next response, empty once the server closed the connection
+static std::string receive_frame(int fd)
+{
+    char header[4];
+    if (!recv_all(fd, header, 4))
+        return "";
+    std::string payload(load_u32(std::string(header, 4), 0), '\0');
+    if (!recv_all(fd, payload.data(), payload.size()))
+        return "";
+    return payload;
+}
+
+static bool response_ok(const std::string& payload)
+{
+    return !payload.empty() && payload[0] == ResponseOk;
+}
+
+// Number of rows of a successful columnar result
+static size_t response_rows(const std::string& payload)
+{
+    size_t offset = 1;
+    std::vector<CellType> types(uint8_t(payload[offset]) | uint8_t(payload[offset + 1]) << 8);
+    offset += 2;
+    for (auto& type : types) {
+        type = CellType(payload[offset]);
+        offset += 3 + (uint8_t(payload[offset + 1]) | uint8_t(payload[offset + 2]) << 8);
+    }
+
+    size_t rows = 0;
+    for (;;) {
+        uint32_t batch = load_u32(payload, offset);
+        offset += 4;
+        if (!batch)
+            return rows;
+        rows += batch;
+        for (auto type : types) {
+            switch (type) {
+            case INT32: offset += 4 * batch; break;
+            case BOOL:  offset += batch; break;
+            default:    offset += 4 * (batch + 1) + load_u32(payload, offset + 4 * batch); break;
+            }
+        }
+    }
+}
+
+class ServerTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        ServerOptions options;
+        options.port_ = 0;
+        options.workers_ = 4;
+        server_ = std::make_unique<Server>(db_, options);
+        loop_ = std::thread([this] { server_->run(); });
+    }
+
+    void TearDown() override
+    {
+        server_->stop();
+        loop_.join();
+        server_.reset();
+    }
+
+    Database                db_;
+    std::unique_ptr<Server> server_;
+    std::thread             loop_;
+};
+
+TEST_F(ServerTest, Pipelining)
+{
+    int fd = connect_to(server_->port());
+    ASSERT_GE(fd, 0);
+
+    // every request goes out before any response is read
+    std::vector<std::string> queries = {
+        "create table tab1 (name : string, value : int32)",
+        "insert (\"a\", 1) to tab1",
+        "insert (\"b\", 10) to tab1",
+        "select name, value from tab1 where value > 0",
+        "select missing from tab1",
+        "select name from tab1 where value > 5"
+    };
+    std::string requests;
+    for (auto& query : queries)
+        requests += frame(query);
+    ASSERT_TRUE(send_all(fd, requests));
+
+    // responses come back in order
+    std::vector<std::string> responses;
+    for (auto i = 0U; i < queries.size(); ++i)
+        responses.push_back(receive_frame(fd));
+
+    for (auto i = 0U; i < 4; ++i)
+        ASSERT_TRUE(response_ok(responses[i])) << queries[i];
+    ASSERT_EQ(response_rows(responses[3]), 2);
+    ASSERT_FALSE(response_ok(responses[4]));
+    ASSERT_EQ(responses[4][0], ResponseError);
+    ASSERT_EQ(response_rows(responses[5]), 1);
+
+    // a client that stops sending still gets the answers to what it sent
+    ASSERT_TRUE(send_all(fd, frame("select value from tab1") + frame("select name from tab1")));
+    shutdown(fd, SHUT_WR);
+    ASSERT_EQ(response_rows(receive_frame(fd)), 2);
+    ASSERT_EQ(response_rows(receive_frame(fd)), 2);
+    ASSERT_EQ(receive_frame(fd), "");
+    close(fd);
+}
+
+TEST_F(ServerTest, SessionPerConnection)
+{
+    int first = connect_to(server_->port());
+    int second = connect_to(server_->port());
+    ASSERT_GE(first, 0);
+    ASSERT_GE(second, 0);
+
+    ASSERT_TRUE(send_all(first, frame("create table tab1 (value : int32)") + frame("begin")
+        + frame("insert (1) to tab1")));
+    for (int i = 0; i < 3; ++i)
+        ASSERT_TRUE(response_ok(receive_frame(first)));
+
+    // the transaction of one connection is invisible to the other until commit
+    ASSERT_TRUE(send_all(second, frame("select value from tab1")));
+    ASSERT_EQ(response_rows(receive_frame(second)), 0);
+
+    ASSERT_TRUE(send_all(first, frame("commit")));
+    ASSERT_TRUE(response_ok(receive_frame(first)));
+
+    ASSERT_TRUE(send_all(second, frame("select value from tab1")));
+    ASSERT_EQ(response_rows(receive_frame(second)), 1);
+
+    // many clients at once, each on its own table
+    std::vector<std::thread> clients;
+    std::atomic<int> failures = 0;
+    for (int c = 0; c < 8; ++c)
+        clients.emplace_back([&, c] {
+            int fd = connect_to(server_->port());
+            std::string table = "client" + std::to_string(c);
+            std::string requests = frame("create table " + table + " (value : int32)");
+            for (int i = 0; i < 100; ++i)
+                requests += frame("insert (" + std::to_string(i) + ") to " + table);
+            requests += frame("select value from " + table);
+            if (!send_all(fd, requests))
+                failures++;
+            for (int i = 0; i < 101; ++i)
+                if (!response_ok(receive_frame(fd)))
+                    failures++;
+            if (response_rows(receive_frame(fd)) != 100)
+                failures++;
+            close(fd);
+        });
+    for (auto& client : clients)
+        client.join();
+    ASSERT_EQ(failures, 0);
+
+    close(first);
+    close(second);
+}
+
+TEST_F(ServerTest, OversizedRequest)
+{
+    int fd = connect_to(server_->port());
+    ASSERT_GE(fd, 0);
+
+    // requests before the bad frame are answered, then the connection is closed
+    std::string header(4, '\0');
+    for (int i = 0; i < 4; ++i)
+        header[i] = char((SERVER_MAX_REQUEST + 1) >> (8 * i));
+    ASSERT_TRUE(send_all(fd, frame("create table tab1 (value : int32)") + header));
+
+    ASSERT_TRUE(response_ok(receive_frame(fd)));
+    ASSERT_EQ(receive_frame(fd), "");
+    close(fd);
+
+    // the server keeps serving others
+    fd = connect_to(server_->port());
+    ASSERT_TRUE(send_all(fd, frame("select value from tab1")));
+    ASSERT_EQ(response_rows(receive_frame(fd)), 0);
+    close(fd);
+}
+
+TEST_F(ServerTest, PreparedStatements)
+{
+    Client client("127.0.0.1", server_->port());
+    ASSERT_TRUE(client.query("create table tab1 (name : string, value : int32, flag : bool, data : bytes)").ok());
+
+    uint32_t insert = client.prepare("insert ($1, $2, $3, $4) to tab1");
+    std::vector<std::byte> bytes = { std::byte(0), std::byte(0xff), std::byte(7) };
+    for (int i = 0; i < 3000; i += 100) {
+        for (int j = i; j < i + 100; ++j)
+            client.send_execute(insert, { Cell("row" + std::to_string(j)), Cell(j), Cell(j % 3 == 0), Cell(bytes) });
+        client.flush();
+        for (int j = 0; j < 100; ++j)
+            ASSERT_TRUE(client.receive().ok());
+    }
+
+    // values come back typed and in order, over more than one batch
+    uint32_t select = client.prepare("select value, name, flag, data from tab1 where value >= $1");
+    ResultSet res = client.execute(select, { Cell(500) });
+    ASSERT_TRUE(res.ok());
+    ASSERT_EQ(res.width(), 4);
+    ASSERT_EQ(res.size(), 2500);
+    ASSERT_EQ(res.name(1), "name");
+    ASSERT_EQ(res.type(3), BYTES);
+
+    std::vector<int> values;
+    for (auto r = 0U; r < res.size(); ++r) {
+        int value = res.int_value(0, r);
+        values.push_back(value);
+        ASSERT_EQ(res.data(1, r), "row" + std::to_string(value));
+        ASSERT_EQ(res.bool_value(2, r), value % 3 == 0);
+        ASSERT_EQ(res.cell(3, r).get_bytes(), bytes);
+    }
+    std::sort(values.begin(), values.end());
+    ASSERT_EQ(values.front(), 500);
+    ASSERT_EQ(values.back(), 2999);
+
+    // errors of a statement leave the connection usable
+    res = client.execute(select, {});
+    ASSERT_FALSE(res.ok());
+    ASSERT_NE(res.error().find("$1"), std::string::npos);
+    ASSERT_THROW(client.prepare("select value from tab1 where"), ClientException);
+
+    // texts and statements may be mixed in one pipeline
+    client.send_query("select value from tab1 where value < 10");
+    client.send_execute(select, { Cell(2990) });
+    client.send_query("select missing from tab1");
+    client.flush();
+    ASSERT_EQ(client.receive().size(), 10);
+    ASSERT_EQ(client.receive().size(), 10);
+    ASSERT_FALSE(client.receive().ok());
+
+    // statements belong to the connection that prepared them
+    Client other("127.0.0.1", server_->port());
+    ASSERT_FALSE(other.execute(select, { Cell(0) }).ok());
+
+    client.close(select);
+    ASSERT_FALSE(client.execute(select, { Cell(0) }).ok());
+    ASSERT_THROW(client.close(select), ClientException);
+    client.close(insert);
+}
+
+// Server of its own options on a free port, for tests that need other bounds
+struct RunningServer
+{
+    RunningServer(const ServerOptions& options)
+    : server_(db_, options), loop_([this] { server_.run(); })
+    { }
+
+    ~RunningServer()
+    {
+        server_.stop();
+        loop_.join();
+    }
+
+    Database    db_;
+    Server      server_;
+    std::thread loop_;
+};
+
+TEST(AdmissionTest, Bounds)
+{
+    ServerOptions options;
+    options.port_ = 0;
+    options.workers_ = 2;
+    options.connection_requests_ = 4;
+
+    {
+        RunningServer running(options);
+        Client client("127.0.0.1", running.server_.port());
+        ASSERT_TRUE(client.query("create table tab1 (value : int32)").ok());
+
+        // requests past the bound of the connection are turned away, in order
+        for (int i = 0; i < 20; ++i)
+            client.send_query("select value from tab1");
+        client.flush();
+        size_t rejected = 0;
+        for (int i = 0; i < 20; ++i) {
+            ResultSet res = client.receive();
+            if (i < 4) {
+                ASSERT_TRUE(res.ok());
+            }
+            ASSERT_TRUE(res.ok() || res.retryable());
+            rejected += res.retryable();
+        }
+        ASSERT_GT(rejected, 0);
+
+        // once the queue drains requests are admitted again
+        ASSERT_TRUE(client.query("select value from tab1").ok());
+    }
+
+    // the bound of the whole server holds across connections
+    options.connection_requests_ = SERVER_CONNECTION_REQUESTS;
+    options.total_requests_ = 3;
+    {
+        RunningServer running(options);
+        Client client("127.0.0.1", running.server_.port());
+        for (int i = 0; i < 10; ++i)
+            client.send_query("create table tab" + std::to_string(i) + " (value : int32)");
+        client.flush();
+        for (int i = 0; i < 10; ++i) {
+            ResultSet res = client.receive();
+            ASSERT_EQ(res.ok(), i < 3) << i;
+            ASSERT_EQ(res.retryable(), i >= 3);
+        }
+
+        // a rejected statement did not run
+        ASSERT_TRUE(client.query("select value from tab2").ok());
+        ASSERT_FALSE(client.query("select value from tab3").ok());
+    }
+
+    // bytes waiting to be framed count too, a connection over the bound
+    // is read again once its admitted requests are done
+    options.total_requests_ = SERVER_TOTAL_REQUESTS;
+    options.connection_bytes_ = 64;
+    {
+        RunningServer running(options);
+        Client client("127.0.0.1", running.server_.port());
+        ASSERT_TRUE(client.query("create table tab1 (value : int32)").ok());
+        for (int i = 0; i < 2000; ++i)
+            client.send_query("insert (" + std::to_string(i) + ") to tab1");
+        client.flush();
+        for (int i = 0; i < 2000; ++i) {
+            ResultSet res = client.receive();
+            ASSERT_TRUE(res.ok() || res.retryable());
+        }
+        ASSERT_TRUE(client.query("select value from tab1").ok());
+    }
+    options.connection_bytes_ = SERVER_CONNECTION_BYTES;
+
+    // with no room at all the event loop answers by itself
+    options.total_requests_ = 0;
+    {
+        RunningServer running(options);
+        Client client("127.0.0.1", running.server_.port());
+        ResultSet res = client.query("create table tab1 (value : int32)");
+        ASSERT_TRUE(res.retryable());
+        ASSERT_THROW(client.prepare("select value from tab1"), ClientException);
+    }
+}
+
+TEST(AdmissionTest, HeavyPool)
+{
+    ServerOptions options;
+    options.port_ = 0;
+    options.workers_ = 2;
+    options.heavy_workers_ = 1;
+    options.heavy_rows_ = 10;
+
+    RunningServer running(options);
+    Client client("127.0.0.1", running.server_.port());
+    ASSERT_TRUE(client.query("create table tab1 (value : int32)").ok());
+
+    // inserts stay on the main pool, selects move to the heavy one once the
+    // table is big enough; responses keep the order of the requests
+    for (int i = 0; i < 40; ++i) {
+        client.send_query("insert (" + std::to_string(i) + ") to tab1");
+        client.send_query("select value from tab1");
+    }
+    client.flush();
+    for (int i = 0; i < 40; ++i) {
+        ASSERT_TRUE(client.receive().ok());
+        ResultSet res = client.receive();
+        ASSERT_TRUE(res.ok());
+        ASSERT_EQ(res.size(), i + 1);
+    }
+
+    // a session is the same whichever pool runs its statements
+    uint32_t select = client.prepare("select value from tab1 where value < $1");
+    ASSERT_TRUE(client.query("begin").ok());
+    ASSERT_TRUE(client.query("insert (-1) to tab1").ok());
+    ASSERT_EQ(client.execute(select, { Cell(0) }).size(), 1);
+    ASSERT_TRUE(client.query("rollback").ok());
+    ASSERT_EQ(client.execute(select, { Cell(0) }).size(), 0);
+}
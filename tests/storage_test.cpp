@@ -0,0 +1,406 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <functional>
+#include <cstring>
+
+#include "database/database.hpp"
+
+using namespace memdb;
+
+static std::string temp_path(const std::string& name)
+{
+    return "/tmp/memdb_" + std::to_string(getpid()) + "_" + name;
+}
+
+TEST(StorageTest, SaveLoad)
+{
+    std::string path = temp_path("save_load.snapshot");
+
+    {
+        Database db;
+        db.execute("create table tab1 (name : string, value : int32, flag : bool, data : bytes)");
+        db.execute("insert (\"a\", 1, true, 0x0A0B) to tab1");
+        db.execute("insert (\"bbb\", -10, false, 0xFF) to tab1");
+        db.execute("create table tab2 (value : int32)");
+
+        Result res = db.execute("save \"" + path + "\"");
+        ASSERT_TRUE(res.ok());
+    }
+
+    Database db;
+    Result res = db.execute("load '" + path + "'");
+    ASSERT_TRUE(res.ok());
+
+    auto tab1 = db.get_table("tab1");
+    ASSERT_EQ(tab1->size(), 2);
+    ASSERT_EQ(tab1->width(), 4);
+    ASSERT_EQ(db.get_table("tab2")->size(), 0);
+
+    res = db.execute("select name, data from tab1 where value < 0 && !flag");
+    ASSERT_TRUE(res.ok());
+
+    Table* selected = res.get_table();
+    ASSERT_EQ(selected->size(), 1);
+
+    unlink(path.c_str());
+}
+
+TEST(StorageTest, DictionaryColumns)
+{
+    std::string path = temp_path("dictionary.snapshot");
+
+    {
+        Database db;
+        db.execute("create table tab1 (kind : string, name : string)");
+        auto table = db.get_table("tab1");
+        auto lock = table->write_lock();
+        for (int i = 0; i < 1000; ++i)
+            table->insert(std::vector<Cell>{Cell(std::string(i % 2 ? "odd" : "even")),
+                Cell("name" + std::to_string(i))});
+        lock.unlock();
+
+        ASSERT_TRUE(db.execute("save \"" + path + "\"").ok());
+    }
+
+    // repeated kinds are written as codes, distinct names as they are
+    Database db;
+    ASSERT_TRUE(db.execute("load '" + path + "'").ok());
+
+    auto tab1 = db.get_table("tab1");
+    ASSERT_EQ(tab1->size(), 1000);
+    ASSERT_EQ(tab1->columns()[0].dictionary_->size(), 2);
+
+    Result res = db.execute("select name from tab1 where kind == \"odd\" && name == \"name7\"");
+    ASSERT_TRUE(res.ok());
+    ASSERT_EQ(res.get_table()->size(), 1);
+
+    res = db.execute("select name from tab1 where kind != \"even\"");
+    ASSERT_TRUE(res.ok());
+    ASSERT_EQ(res.get_table()->size(), 500);
+
+    unlink(path.c_str());
+}
+
+TEST(StorageTest, LoadRejectsGarbage)
+{
+    std::string path = temp_path("garbage.snapshot");
+
+    FILE* file = fopen(path.c_str(), "w");
+    ASSERT_NE(file, nullptr);
+    fputs("definitely not a snapshot, but long enough to contain a header", file);
+    fclose(file);
+
+    Database db;
+    db.execute("create table tab1 (value : int32)");
+
+    Result res = db.execute("load \"" + path + "\"");
+    ASSERT_FALSE(res.ok());
+
+    // failed load keeps the catalog untouched
+    ASSERT_NO_THROW(db.get_table("tab1"));
+
+    unlink(path.c_str());
+}
+
+TEST(StorageTest, LoadRejectsBadCatalog)
+{
+    std::string path = temp_path("bad_catalog.snapshot");
+
+    Database db;
+    db.execute("create table tab1 (value : int32)");
+    db.execute("create table tab2 (value : int32)");
+    db.execute("insert (1) to tab1");
+    db.execute("insert (2) to tab2");
+
+    auto corrupt = [&] (const std::function<void(std::string&, uint64_t)>& change) {
+        ASSERT_TRUE(db.execute("save \"" + path + "\"").ok());
+        std::string data;
+        {
+            std::ifstream in(path, std::ios::binary);
+            data.assign(std::istreambuf_iterator<char>(in), {});
+        }
+        uint64_t catalog;
+        std::memcpy(&catalog, data.data() + 32, sizeof(catalog));
+        change(data, catalog);
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << data;
+    };
+
+    // tab2 named tab1 would replace it
+    corrupt([] (std::string& data, uint64_t catalog) {
+        size_t name = data.find("tab2", catalog);
+        ASSERT_NE(name, std::string::npos);
+        data[name + 3] = '1';
+    });
+    ASSERT_FALSE(db.execute("load \"" + path + "\"").ok());
+
+    // row ids of tab1 moved off their page boundary: name, columns, row count, next id
+    corrupt([] (std::string& data, uint64_t catalog) {
+        size_t position = catalog + (4 + 4) + 4 + (1 + 1 + 4 + 5) + 8 + 8;
+        data[position] += 4;
+    });
+    ASSERT_FALSE(db.execute("load \"" + path + "\"").ok());
+
+    ASSERT_TRUE(db.execute("save \"" + path + "\"").ok());
+    ASSERT_TRUE(db.execute("load \"" + path + "\"").ok());
+    ASSERT_EQ(db.get_table("tab2")->size(), 1);
+
+    unlink(path.c_str());
+}
+
+static std::string temp_dir(const std::string& name)
+{
+    std::string dir = temp_path(name);
+    std::filesystem::remove_all(dir);
+    return dir;
+}
+
+TEST(StorageTest, WalRecovery)
+{
+    DurabilityOptions options;
+    options.directory_ = temp_dir("wal_recovery");
+
+    {
+        Database db(options);
+        db.execute("create table tab1 (name : string, value : int32)");
+        db.execute("create table tab2 (value : int32)");
+        db.execute("insert (\"a\", 1) to tab1");
+        db.execute("insert (value = 10, name = \"b\") to tab1");
+        db.execute("insert (\"c\", 100) to tab1");
+        db.execute("update tab1 set value = value + 1 where name == \"a\"");
+        db.execute("delete tab1 where value > 50");
+        db.execute("drop table tab2");
+    }
+
+    // torn record at the end of the log is ignored
+    {
+        std::ofstream wal(options.directory_ + "/wal", std::ios::app | std::ios::binary);
+        wal << "garbage";
+    }
+
+    Database db(options);
+    ASSERT_EQ(db.get_table("tab1")->size(), 2);
+    ASSERT_THROW(db.get_table("tab2"), TableDoNotExistException);
+
+    Result res = db.execute("select name from tab1 where value == 2");
+    ASSERT_TRUE(res.ok());
+    ASSERT_EQ(res.get_table()->size(), 1);
+
+    // log is appendable after recovery
+    ASSERT_TRUE(db.execute("insert (\"d\", 4) to tab1").ok());
+
+    std::filesystem::remove_all(options.directory_);
+}
+
+TEST(StorageTest, WalSkipsFailedStatements)
+{
+    DurabilityOptions options;
+    options.directory_ = temp_dir("wal_failed_statements");
+
+    {
+        Database db(options);
+        db.execute("create table tab1 (name : string, value : int32)");
+        db.execute("insert (\"a\", 1) to tab1");
+        ASSERT_FALSE(db.execute("insert (1, \"a\") to tab1").ok());
+        ASSERT_FALSE(db.execute("insert (value = \"a\") to tab1").ok());
+        ASSERT_FALSE(db.execute("update tab1 set value = value / 0").ok());
+        ASSERT_FALSE(db.execute("update tab1 set value = name").ok());
+        ASSERT_FALSE(db.execute("delete tab1 where name > 1").ok());
+    }
+
+    // only the statements that succeeded are in the log
+    {
+        WriteAheadLog wal(options.directory_ + "/wal", SyncNever, 0);
+        int replayed = 0;
+        wal.recover(0, [&replayed] (const WalRecord&) { replayed++; });
+        ASSERT_EQ(replayed, 2);
+        wal.commit(wal.append(WalRecord::insert("missing", std::vector<Cell>{Cell(1)})));
+    }
+
+    // a record that does not apply is reported, not skipped
+    ASSERT_THROW(Database db(options), WalException);
+
+    std::filesystem::remove_all(options.directory_);
+}
+
+TEST(StorageTest, WalCheckpoint)
+{
+    DurabilityOptions options;
+    options.directory_ = temp_dir("wal_checkpoint");
+    options.sync_policy_ = SyncInterval;
+    options.sync_interval_ms_ = 5;
+
+    {
+        Database db(options);
+        db.execute("create table tab1 (value : int32)");
+        db.execute("insert (1) to tab1");
+        db.checkpoint();
+        db.execute("insert (2) to tab1");
+    }
+
+    Database db(options);
+    ASSERT_EQ(db.get_table("tab1")->size(), 2);
+
+    std::filesystem::remove_all(options.directory_);
+}
+
+TEST(StorageTest, WalGroupCommit)
+{
+    std::string dir = temp_dir("wal_group_commit");
+    std::filesystem::create_directories(dir);
+
+    const int threads = 8, records = 100;
+    {
+        WriteAheadLog wal(dir + "/wal", SyncEveryCommit, 0);
+        wal.recover(0, [] (const WalRecord&) { });
+
+        std::vector<std::thread> committers;
+        for (int t = 0; t < threads; ++t)
+            committers.emplace_back([&wal, t] {
+                for (int i = 0; i < records; ++i)
+                    wal.commit(wal.append(WalRecord::insert("tab1", std::vector<Cell>{Cell(t), Cell(i)})));
+            });
+
+        for (auto& committer : committers)
+            committer.join();
+
+        ASSERT_EQ(wal.last_lsn(), (uint64_t)threads * records);
+    }
+
+    WriteAheadLog wal(dir + "/wal", SyncNever, 0);
+    int replayed = 0;
+    wal.recover(0, [&replayed] (const WalRecord& record) {
+        ASSERT_EQ(record.type_, WalInsert);
+        replayed++;
+    });
+    ASSERT_EQ(replayed, threads * records);
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST(StorageTest, WalWriteFailure)
+{
+    std::string dir = temp_dir("wal_write_failure");
+    std::filesystem::create_directories(dir);
+    std::string path = dir + "/wal";
+
+    auto record = [] (int value) {
+        return WalRecord::insert("tab1", std::vector<Cell>{Cell(std::string(100, 'x')), Cell(value)});
+    };
+
+    {
+        WriteAheadLog wal(path, SyncEveryCommit, 0);
+        wal.recover(0, [] (const WalRecord&) { });
+        wal.commit(wal.append(record(1)));
+
+        // the file may not grow past the first record, writes fail with EFBIG
+        struct rlimit saved;
+        getrlimit(RLIMIT_FSIZE, &saved);
+        auto saved_handler = std::signal(SIGXFSZ, SIG_IGN);
+        struct rlimit limit = saved;
+        limit.rlim_cur = std::filesystem::file_size(path) + 50;
+        setrlimit(RLIMIT_FSIZE, &limit);
+
+        uint64_t lsn = wal.append(record(2));
+        ASSERT_THROW(wal.commit(lsn), WalException);
+
+        setrlimit(RLIMIT_FSIZE, &saved);
+        std::signal(SIGXFSZ, saved_handler);
+
+        // the log stays failed although the disk is fine again, and tells why
+        try {
+            wal.commit(lsn);
+            FAIL();
+        }
+        catch (WalException& ex) {
+            ASSERT_NE(std::string(ex.what()).find("write failed: File too large"), std::string::npos) << ex.what();
+        }
+        ASSERT_THROW(wal.append(record(3)), WalException);
+    }
+
+    // the torn record was cut off, recovery sees the first one only
+    {
+        WriteAheadLog wal(path, SyncEveryCommit, 0);
+        int replayed = 0;
+        wal.recover(0, [&replayed] (const WalRecord&) { replayed++; });
+        ASSERT_EQ(replayed, 1);
+        ASSERT_EQ(wal.last_lsn(), 1);
+
+        // a checkpoint starts a working log
+        wal.reset();
+        wal.commit(wal.append(record(4)));
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST(StorageTest, BackgroundSave)
+{
+    std::string path = temp_path("background.snapshot");
+
+    Database db;
+    db.execute("create table tab1 (value : int32)");
+    for (int i = 0; i < 1000; ++i)
+        db.execute("insert (" + std::to_string(i) + ") to tab1");
+
+    ASSERT_TRUE(db.execute("bgsave \"" + path + "\"").ok());
+
+    // changes made while the child is writing are not in the snapshot
+    db.execute("delete tab1 where value >= 0");
+    ASSERT_EQ(db.get_table("tab1")->size(), 0);
+
+    BackgroundSaveStatus status;
+    for (int i = 0; i < 1000; ++i) {
+        status = db.background_save_status();
+        if (status.state_ != BackgroundSaveStatus::Running)
+            break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    ASSERT_EQ(status.state_, BackgroundSaveStatus::Done);
+    ASSERT_EQ(status.progress_, 100);
+
+    Result res = db.execute("bgsave status");
+    ASSERT_TRUE(res.ok());
+    ASSERT_EQ(res.get_table()->size(), 1);
+
+    ASSERT_TRUE(db.execute("load \"" + path + "\"").ok());
+    ASSERT_EQ(db.get_table("tab1")->size(), 1000);
+
+    unlink(path.c_str());
+}
+
+TEST(StorageTest, SlowLogFile)
+{
+    std::string path = temp_path("slow.log");
+    unlink(path.c_str());
+
+    Database db;
+    SlowLogOptions options;
+    options.threshold_us_ = 0;
+    options.path_ = path;
+    db.slow_log().configure(options);
+
+    db.execute("create table tab1 (name : string, value : int32)");
+    db.execute("insert (\"row\", 1) to tab1");
+    db.execute("select value from missing");
+    db.slow_log().flush();
+
+    std::ifstream in(path);
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(in, line); )
+        lines.push_back(line);
+    ASSERT_EQ(lines.size(), 3);
+    ASSERT_NE(lines[1].find(" ok=true "), std::string::npos);
+    ASSERT_NE(lines[1].find(" query=\"insert (?, ?) to tab1\""), std::string::npos);
+    ASSERT_NE(lines[2].find(" ok=false "), std::string::npos);
+    ASSERT_EQ(lines[2].rfind("time=", 0), 0);
+
+    options.path_ = "/nonexistent/dir/slow.log";
+    ASSERT_THROW(db.slow_log().configure(options), SlowLogException);
+
+    unlink(path.c_str());
+}
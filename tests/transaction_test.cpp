@@ -0,0 +1,204 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <filesystem>
+
+#include "database/database.hpp"
+
+using namespace memdb;
+
+static size_t count_rows(Session& session, const std::string& query)
+{
+    Result res = session.execute(query);
+    EXPECT_TRUE(res.ok());
+    if (!res.ok())
+        return 0;
+
+    size_t size = res.get_table()->size();
+    return size;
+}
+
+TEST(TransactionTest, CommitAndRollback)
+{
+    Database db;
+    Session session(db), other(db);
+    db.execute("create table tab1 (name : string, value : int32)");
+    db.execute("insert (\"a\", 1) to tab1");
+
+    ASSERT_TRUE(session.execute("begin").ok());
+    ASSERT_TRUE(session.execute("insert (\"b\", 2) to tab1").ok());
+    ASSERT_TRUE(session.execute("update tab1 set value = value + 10 where name == \"a\"").ok());
+
+    // the transaction reads its own writes, others do not see them yet
+    ASSERT_EQ(count_rows(session, "select name from tab1 where value > 1"), 2);
+    ASSERT_EQ(count_rows(other, "select name from tab1 where value > 1"), 0);
+
+    ASSERT_TRUE(session.execute("commit").ok());
+    ASSERT_EQ(count_rows(other, "select name from tab1 where value > 1"), 2);
+
+    ASSERT_TRUE(session.execute("begin").ok());
+    ASSERT_TRUE(session.execute("delete tab1 where value > 0").ok());
+    ASSERT_EQ(count_rows(session, "select name from tab1 where value > 0"), 0);
+    ASSERT_TRUE(session.execute("rollback").ok());
+
+    ASSERT_EQ(db.get_table("tab1")->size(), 2);
+}
+
+TEST(TransactionTest, ResultsKeepDictionary)
+{
+    Database db;
+    Session session(db);
+    db.execute("create table tab1 (name : string, value : int32)");
+    db.execute("insert (\"a\", 1) to tab1");
+    auto& dictionary = db.get_table("tab1")->columns()[0].dictionary_;
+    ASSERT_EQ(dictionary->size(), 1);
+
+    // own rows are copied into results, their strings stay out of the table
+    ASSERT_TRUE(session.execute("begin").ok());
+    ASSERT_TRUE(session.execute("insert (\"b\", 2) to tab1").ok());
+    ASSERT_TRUE(session.execute("update tab1 set name = \"c\" where value == 1").ok());
+    ASSERT_EQ(count_rows(session, "select name from tab1 where name == \"b\" || name == \"c\""), 2);
+    ASSERT_TRUE(session.execute("rollback").ok());
+    ASSERT_EQ(dictionary->size(), 1);
+
+    ASSERT_TRUE(session.execute("begin").ok());
+    ASSERT_TRUE(session.execute("insert (\"b\", 2) to tab1").ok());
+    ASSERT_TRUE(session.execute("commit").ok());
+    ASSERT_EQ(dictionary->size(), 2);
+}
+
+TEST(TransactionTest, SnapshotAndConflict)
+{
+    Database db;
+    Session first(db), second(db);
+    db.execute("create table tab1 (value : int32)");
+    db.execute("insert (1) to tab1");
+
+    first.execute("begin");
+    second.execute("begin");
+
+    // changes committed after BEGIN are not visible to the transaction
+    db.execute("insert (2) to tab1");
+    ASSERT_EQ(count_rows(first, "select value from tab1 where value > 0"), 1);
+
+    ASSERT_TRUE(first.execute("update tab1 set value = 10 where value == 1").ok());
+    ASSERT_TRUE(second.execute("update tab1 set value = 20 where value == 1").ok());
+
+    // first committer wins, the second one is aborted as a whole
+    ASSERT_TRUE(first.execute("commit").ok());
+    ASSERT_FALSE(second.execute("commit").ok());
+    ASSERT_FALSE(second.execute("rollback").ok());
+
+    Session check(db);
+    ASSERT_EQ(count_rows(check, "select value from tab1 where value == 10"), 1);
+    ASSERT_EQ(count_rows(check, "select value from tab1 where value == 20"), 0);
+}
+
+TEST(TransactionTest, StatementErrors)
+{
+    Database db;
+    Session session(db);
+    db.execute("create table tab1 (name : string, value : int32)");
+    db.execute("insert (\"a\", 1) to tab1");
+    db.execute("insert (\"b\", 2) to tab1");
+
+    // a failing statement leaves the table untouched
+    ASSERT_FALSE(db.execute("update tab1 set value = value / (value - 2) where value > 0").ok());
+    ASSERT_EQ(count_rows(session, "select name from tab1 where value == 1 || value == 2"), 2);
+
+    ASSERT_FALSE(session.execute("commit").ok());
+    ASSERT_TRUE(session.execute("begin").ok());
+    ASSERT_FALSE(session.execute("begin").ok());
+    ASSERT_FALSE(session.execute("create table tab2 (value : int32)").ok());
+    ASSERT_FALSE(session.execute("drop table tab1").ok());
+    ASSERT_TRUE(session.execute("rollback").ok());
+}
+
+TEST(TransactionTest, Recovery)
+{
+    DurabilityOptions options;
+    options.directory_ = "/tmp/memdb_" + std::to_string(getpid()) + "_transaction_recovery";
+    std::filesystem::remove_all(options.directory_);
+
+    {
+        Database db(options);
+        Session session(db);
+        db.execute("create table tab1 (name : string, value : int32)");
+        db.execute("insert (\"a\", 1) to tab1");
+        db.execute("insert (\"a\", 1) to tab1");
+
+        session.execute("begin");
+        for (int i = 0; i < 1000; ++i)
+            session.execute("insert (\"b\", " + std::to_string(i) + ") to tab1");
+        session.execute("update tab1 set value = 2 where name == \"a\"");
+        session.execute("delete tab1 where value >= 500 && name == \"b\"");
+        ASSERT_TRUE(session.execute("commit").ok());
+
+        session.execute("begin");
+        session.execute("delete tab1 where value >= 0");
+        session.execute("rollback");
+    }
+
+    Database db(options);
+    Session session(db);
+    ASSERT_EQ(db.get_table("tab1")->size(), 502);
+    ASSERT_EQ(count_rows(session, "select name from tab1 where value == 2"), 3);
+
+    std::filesystem::remove_all(options.directory_);
+}
+
+static std::vector<RowId> row_ids(Database& db, const std::string& name)
+{
+    auto table = db.get_table(name);
+    TransactionManager::ReadView view(*db.transactions());
+
+    std::vector<RowId> ids;
+    auto segments = table->segments();
+    for (RowVersion* version : table->visible_versions(view.ts(), *segments))
+        ids.push_back(version->row_->id());
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+TEST(TransactionTest, RowIds)
+{
+    DurabilityOptions options;
+    options.directory_ = "/tmp/memdb_" + std::to_string(getpid()) + "_transaction_row_ids";
+    std::filesystem::remove_all(options.directory_);
+
+    std::vector<RowId> ids;
+    {
+        Database db(options);
+        Session session(db);
+        db.execute("create table tab1 (value : int32)");
+        for (int i = 0; i < 10; ++i)
+            db.execute("insert (" + std::to_string(i) + ") to tab1");
+
+        // updates keep ids, ids of deleted rows are not given out again
+        db.execute("update tab1 set value = value + 100 where value >= 0");
+        db.execute("delete tab1 where value >= 105");
+        db.execute("insert (7) to tab1");
+        ASSERT_EQ(row_ids(db, "tab1"), std::vector<RowId>({1, 2, 3, 4, 5, 11}));
+
+        db.checkpoint();
+
+        // the log names rows by id, recovery applies it on top of the snapshot
+        session.execute("begin");
+        session.execute("update tab1 set value = 0 where value == 7 || value == 101");
+        session.execute("insert (8) to tab1");
+        ASSERT_TRUE(session.execute("commit").ok());
+
+        ids = row_ids(db, "tab1");
+        ASSERT_EQ(ids, std::vector<RowId>({1, 2, 3, 4, 5, 11, 12}));
+    }
+
+    Database db(options);
+    ASSERT_EQ(row_ids(db, "tab1"), ids);
+
+    Session session(db);
+    ASSERT_EQ(count_rows(session, "select value from tab1 where value == 0"), 2);
+
+    db.execute("insert (9) to tab1");
+    ASSERT_EQ(row_ids(db, "tab1").back(), 13);
+
+    std::filesystem::remove_all(options.directory_);
+}